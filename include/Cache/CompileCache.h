@@ -0,0 +1,65 @@
+#ifndef INCLUDE_CACHE_COMPILECACHE_H
+#define INCLUDE_CACHE_COMPILECACHE_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/SHA256.h"
+
+#include <optional>
+#include <string>
+
+namespace tensor_compiler {
+
+/// @brief Builds a cache key from every input that affects the artifact.
+///
+/// Fields are hashed with their length, so ("ab", "c") and ("a", "bc")
+/// give different keys.
+class CacheKey final {
+public:
+  CacheKey &add(llvm::StringRef field);
+  CacheKey &add(int64_t value);
+
+  /// @brief Add the version of the running compiler: the LLVM version and
+  /// the size and modification time of the executable, so every rebuild of
+  /// the compiler invalidates earlier entries.
+  CacheKey &addCompilerVersion();
+
+  /// @brief Hex SHA-256 of all fields added so far.
+  std::string finish();
+
+private:
+  llvm::SHA256 hasher_;
+};
+
+/// @brief On-disk cache of compiled artifacts, one file per key.
+///
+/// Entries are written to a temporary file in the cache directory and
+/// renamed into place, so concurrent compilers never see partial files.
+class CompileCache final {
+public:
+  /// @param directory Cache directory, created on first insert.
+  explicit CompileCache(std::string directory);
+
+  /// @brief Directory from TC_CACHE_DIR, or empty if it is not set.
+  static std::string defaultDirectory();
+
+  /// @brief Path of the cached artifact, or std::nullopt on a miss.
+  std::optional<std::string> lookup(llvm::StringRef key) const;
+
+  /// @brief A fresh temporary file in the cache directory to write an
+  /// artifact into before insert(); empty on failure.
+  std::string createTemporary() const;
+
+  /// @brief Move the artifact at temporaryPath into the cache under key.
+  /// @return false if the entry could not be stored; the temporary file is
+  /// then left in place for the caller to use and remove.
+  bool insert(llvm::StringRef key, const std::string &temporaryPath) const;
+
+private:
+  std::string entryPath(llvm::StringRef key) const;
+
+  std::string directory_;
+};
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_CACHE_COMPILECACHE_H
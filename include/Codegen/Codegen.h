@@ -1,8 +1,13 @@
 #ifndef INCLUDE_CODEGEN_CODEGEN_H
 #define INCLUDE_CODEGEN_CODEGEN_H
 
+#include <functional>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
+#include "Codegen/WeightsBlob.h"
 #include "Structure/Graph.h"
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -17,20 +22,75 @@
 
 namespace tensor_compiler {
 
+/// @brief How 2D convolutions with group == 1 are emitted.
+enum class ConvLowering {
+  direct,    ///< linalg.conv_2d_nchw_fchw.
+  im2col,    ///< Patch-matrix pack followed by a matmul.
+  automatic, ///< Per layer, by a size heuristic.
+};
+
+/// @brief Winograd variant used for 3x3 stride-1 convolutions.
+enum class Winograd {
+  none,  ///< Use convLowering for every conv.
+  f2x2,  ///< F(2x2, 3x3): 4x4 tiles, 2.25x fewer multiplies.
+  f4x4,  ///< F(4x4, 3x3): 6x6 tiles, 4x fewer multiplies, less accurate.
+};
+
+/// @brief Options controlling MLIR generation.
+struct CodegenOptions {
+  ConvLowering convLowering = ConvLowering::direct;
+  Winograd winograd = Winograd::none;
+  /// Place f32 constants of at least kMinExternalWeightBytes in the
+  /// WeightsBlob instead of a DenseResourceElementsAttr.
+  bool externalWeights = true;
+};
+
+/// @brief Smallest constant, in bytes, moved to the WeightsBlob or, without
+/// external weights, to a DenseResourceElementsAttr. Smaller ones stay
+/// dense so canonicalization can still fold them.
+inline constexpr size_t kMinExternalWeightBytes = 256;
+
 class Codegen {
 private:
   mlir::DialectRegistry registry_;
   mlir::MLIRContext &context_;
+  CodegenOptions options_;
+  mutable WeightsBlob weights_;
 
 public:
-  explicit Codegen(mlir::MLIRContext &context);
+  /// @brief MLIR value of every tensor, indexed by TensorId.
+  using Values = std::vector<mlir::Value>;
+
+  explicit Codegen(mlir::MLIRContext &context,
+                   const CodegenOptions &options = {});
 
   mlir::OwningOpRef<mlir::ModuleOp> generate(const Graph &graph);
 
+  /// @brief Weights placed outside the module by the last generate();
+  /// must be written out and linked with the generated code.
+  const WeightsBlob &weights() const noexcept;
+
   mlir::MLIRContext &getContext() noexcept;
   const mlir::MLIRContext &getContext() const noexcept;
 
+  /// @brief Emits one node and binds its outputs in values.
+  using NodeHandler = std::function<void(
+      const Codegen &codegen, mlir::OpBuilder &builder, mlir::Location loc,
+      const Graph &graph, const Node &node,
+      Values &values)>;
+
+  /// @brief Register or replace the emitter of an opcode, e.g. for an op
+  /// defined in another library (see OpRegistry for its other hooks).
+  ///
+  /// Not synchronized with generate(); register handlers before compiling.
+  /// @param opcode Operator type.
+  /// @param handler Emitter called for every node with that opcode.
+  static void registerHandler(std::string_view opcode, NodeHandler handler);
+
 private:
+  /// Handlers indexed by OpId; empty for unsupported ops.
+  static std::vector<NodeHandler> &handlers();
+
   mlir::Type convertElementType(int onnx_type) const;
   mlir::RankedTensorType convertTensorType(const Tensor &tensor) const;
 
@@ -40,7 +100,7 @@ private:
   void
   bindRawPointerInputs(const Graph &graph, mlir::Block *entryBlock,
                        mlir::OpBuilder &builder, mlir::Location loc,
-                       std::unordered_map<std::string, mlir::Value> &values);
+                       Values &values);
 
   void writeResultToOutputBuffer(mlir::OpBuilder &builder, mlir::Location loc,
                                  mlir::Value computedTensor,
@@ -48,85 +108,101 @@ private:
 
   std::vector<mlir::Value> collectReturnValues(
       const Graph &graph,
-      const std::unordered_map<std::string, mlir::Value> &values) const;
+      const Values &values) const;
 
   void genNodes(mlir::OpBuilder &builder, mlir::Location loc,
                 const Graph &graph,
-                std::unordered_map<std::string, mlir::Value> &values) const;
+                Values &values) const;
 
   void genNode(mlir::OpBuilder &builder, mlir::Location loc, const Node &node,
                const Graph &graph,
-               std::unordered_map<std::string, mlir::Value> &values) const;
+               Values &values) const;
 
   void genMulNode(mlir::OpBuilder &builder, mlir::Location loc,
                   const Node &node,
-                  std::unordered_map<std::string, mlir::Value> &values) const;
+                  Values &values) const;
+
+  /// bytesOutliveModule: bytes belong to the Graph, not to a temporary,
+  /// and may be referenced instead of copied.
+  mlir::Value genWeights(mlir::OpBuilder &builder, mlir::Location loc,
+                         mlir::RankedTensorType type, std::string_view bytes,
+                         bool bytesOutliveModule) const;
+
+  /// Constant in the module: a DenseElementsAttr below
+  /// kMinExternalWeightBytes, a DenseResourceElementsAttr above, viewing
+  /// the bytes without a copy if they outlive the module.
+  mlir::Value genInlineConstant(mlir::OpBuilder &builder, mlir::Location loc,
+                                mlir::RankedTensorType type,
+                                std::string_view bytes,
+                                bool bytesOutliveModule) const;
 
   mlir::Value genConstantTensor(mlir::OpBuilder &builder, mlir::Location loc,
                                 const Tensor &tensor) const;
 
   void genConstants(mlir::OpBuilder &builder, mlir::Location loc,
                     const Graph &graph,
-                    std::unordered_map<std::string, mlir::Value> &values) const;
+                    Values &values) const;
 
   void genAddNode(mlir::OpBuilder &builder, mlir::Location loc,
                   const Node &node,
-                  std::unordered_map<std::string, mlir::Value> &values) const;
+                  Values &values) const;
 
   void
   genIdentityNode(mlir::OpBuilder &builder, mlir::Location loc,
                   const Node &node,
-                  std::unordered_map<std::string, mlir::Value> &values) const;
+                  Values &values) const;
 
   void genSubNode(mlir::OpBuilder &builder, mlir::Location loc,
                   const Node &node,
-                  std::unordered_map<std::string, mlir::Value> &values) const;
+                  Values &values) const;
 
   void genDivNode(mlir::OpBuilder &builder, mlir::Location loc,
                   const Node &node,
-                  std::unordered_map<std::string, mlir::Value> &values) const;
+                  Values &values) const;
 
   void genReluNode(mlir::OpBuilder &builder, mlir::Location loc,
                    const Node &node,
-                   std::unordered_map<std::string, mlir::Value> &values) const;
+                   Values &values) const;
 
   void genConvNode(mlir::OpBuilder &builder, mlir::Location loc,
                    const Graph &graph, const Node &node,
-                   std::unordered_map<std::string, mlir::Value> &values) const;
+                   Values &values) const;
 
   void genBatchNormalizationNode(
-      mlir::OpBuilder &builder, mlir::Location loc, const Node &node,
-      std::unordered_map<std::string, mlir::Value> &values) const;
+      mlir::OpBuilder &builder, mlir::Location loc, const Graph &graph,
+      const Node &node,
+      Values &values) const;
 
   void
   genMaxPoolNode(mlir::OpBuilder &builder, mlir::Location loc, const Node &node,
-                 std::unordered_map<std::string, mlir::Value> &values) const;
+                 Values &values) const;
 
   void
   genReduceMeanNode(mlir::OpBuilder &builder, mlir::Location loc,
                     const Node &node,
-                    std::unordered_map<std::string, mlir::Value> &values) const;
+                    Values &values) const;
 
   void
-  genReshapeNode(mlir::OpBuilder &builder, mlir::Location loc, const Node &node,
-                 std::unordered_map<std::string, mlir::Value> &values) const;
+  genReshapeNode(mlir::OpBuilder &builder, mlir::Location loc,
+                 const Graph &graph, const Node &node,
+                 Values &values) const;
 
   void
   genSqueezeNode(mlir::OpBuilder &builder, mlir::Location loc,
                  const Graph &graph, const Node &node,
-                 std::unordered_map<std::string, mlir::Value> &values) const;
+                 Values &values) const;
 
   void
   genMatMulNode(mlir::OpBuilder &builder, mlir::Location loc, const Node &node,
-                std::unordered_map<std::string, mlir::Value> &values) const;
+                Values &values) const;
 
   void
   genSoftmaxNode(mlir::OpBuilder &builder, mlir::Location loc, const Node &node,
-                 std::unordered_map<std::string, mlir::Value> &values) const;
+                 Values &values) const;
 
   void
   genArgMaxNode(mlir::OpBuilder &builder, mlir::Location loc, const Node &node,
-                std::unordered_map<std::string, mlir::Value> &values) const;
+                Values &values) const;
 };
 
 } // namespace tensor_compiler
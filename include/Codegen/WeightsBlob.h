@@ -0,0 +1,65 @@
+#ifndef INCLUDE_CODEGEN_WEIGHTSBLOB_H
+#define INCLUDE_CODEGEN_WEIGHTSBLOB_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tensor_compiler {
+
+/// @brief Alignment in bytes of every weight tensor in the blob.
+inline constexpr uint64_t kWeightsAlignment = 64;
+
+/// @brief Symbol of the first byte of the weights section in the assembly.
+inline constexpr const char *kWeightsBaseSymbol = "tensorCompWeights";
+
+/// @brief Raw bytes of the model weights, kept out of the MLIR/LLVM IR.
+///
+/// Codegen appends every large constant here and refers to it by symbol
+/// through an external global. The blob is written next to the assembly,
+/// which pulls it in with `.incbin` and defines each symbol at its offset,
+/// so weights never pass through textual data directives.
+class WeightsBlob final {
+public:
+  /// @brief One weight tensor placed in the blob.
+  struct Entry {
+    std::string symbol;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+  };
+
+  /// @brief Append raw tensor bytes at the next aligned offset.
+  /// @param bytes Tensor data.
+  /// @return Symbol naming the appended tensor.
+  const std::string &append(std::string_view bytes);
+
+  /// @brief Drop all entries.
+  void clear();
+
+  bool empty() const noexcept { return entries_.empty(); }
+
+  /// @brief Size of the blob in bytes, including alignment padding.
+  uint64_t size() const noexcept { return data_.size(); }
+
+  const std::vector<Entry> &entries() const noexcept { return entries_; }
+
+  /// @brief Blob contents; entry i starts at entries()[i].offset.
+  std::string_view data() const noexcept { return data_; }
+
+  /// @brief Write the blob to a binary file.
+  /// @throws std::runtime_error if the file cannot be written.
+  void write(const std::string &path) const;
+
+  /// @brief Build the ELF assembly section that includes the blob file
+  /// written to `path` and defines the symbol of every entry.
+  std::string asmSection(const std::string &path) const;
+
+private:
+  std::string data_;
+  std::vector<Entry> entries_;
+};
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_CODEGEN_WEIGHTSBLOB_H
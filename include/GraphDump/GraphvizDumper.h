@@ -144,7 +144,11 @@ private:
   }
 
   static void dumpTensors(const Graph &g, std::ostream &gv) {
-    for (const auto &[name, tensor] : g.tensors()) {
+    for (TensorId id = 0; id < g.tensorIdCount(); ++id) {
+      if (!g.tensor(id))
+        continue;
+      const Tensor &tensor = *g.tensor(id);
+      const std::string &name = tensor.name();
       std::string tensorId = "tensor_" + escapeDot(name);
       std::string kindStr;
       std::string bgcolor;
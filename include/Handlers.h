@@ -2,7 +2,8 @@
 #define INCLUDE_HANDLERS_H
 
 #include "onnx.pb.h"
-#include <limits>
+#include "Structure/Tensor.h"
+#include <stdexcept>
 
 namespace tensor_compiler {
 
@@ -26,7 +27,7 @@ inline std::vector<int64_t> extractDims(const onnx::ValueInfoProto &v) {
   for (int i = 0; i < shape.dim_size(); ++i) {
     const auto &d = shape.dim(i);
     int64_t val = d.has_dim_value() ? static_cast<int64_t>(d.dim_value())
-                                    : std::numeric_limits<int64_t>::min();
+                                    : kDynamicDim;
     dims.push_back(val);
   }
 
@@ -34,6 +35,11 @@ inline std::vector<int64_t> extractDims(const onnx::ValueInfoProto &v) {
 }
 
 inline std::string extractTensorBytes(const onnx::TensorProto &t) {
+  // External data is only reachable through the model path (ModelFile).
+  if (t.data_location() == onnx::TensorProto_DataLocation_EXTERNAL)
+    throw std::runtime_error("initializer '" + t.name() +
+                             "' has external data that was not loaded");
+
   if (!t.raw_data().empty())
     return t.raw_data();
 
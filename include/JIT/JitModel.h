@@ -0,0 +1,92 @@
+#ifndef INCLUDE_JIT_JITMODEL_H
+#define INCLUDE_JIT_JITMODEL_H
+
+#include "Codegen/WeightsBlob.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "llvm/Support/Error.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mlir {
+class ExecutionEngine;
+} // namespace mlir
+
+namespace llvm::orc {
+class LLJIT;
+} // namespace llvm::orc
+
+namespace tensor_compiler {
+
+/// @brief A model compiled in memory with MLIR's ExecutionEngine (ORC
+/// LLJIT), callable without an assembler, linker or dlopen.
+///
+/// Parallel loops run on the runtime thread pool linked into the compiler,
+/// configured as for the shared library (tensorCompSetNumThreads or
+/// TC_NUM_THREADS).
+class JitModel final {
+public:
+  /// @brief JIT-compile a module lowered by MLIRToLLVM for the host CPU.
+  ///
+  /// The LLVM pipeline for optLevel runs with the cost model of the host
+  /// TargetMachine, so the code is optimized as AOT output for the same
+  /// CPU would be.
+  /// @param llvmDialectModule Module in the LLVM dialect.
+  /// @param weights Weights of the Codegen that produced the module.
+  /// @param optLevel LLVM optimization level (0-3).
+  /// @param cpu CPU the pipeline optimizes for as accepted by -mcpu; empty
+  /// selects the host CPU.
+  /// @param features Features as accepted by -mattr, applied on top of the
+  /// host features.
+  /// @param objectPath If not empty, the JIT-compiled object is also written
+  /// there for load().
+  static llvm::Expected<std::unique_ptr<JitModel>>
+  create(mlir::ModuleOp llvmDialectModule, const WeightsBlob &weights,
+         unsigned optLevel, const std::string &cpu = {},
+         const std::string &features = {},
+         const std::string &objectPath = {});
+
+  /// @brief Load an object written by create() into a fresh LLJIT, skipping
+  /// Codegen, the MLIR pipeline and LLVM codegen.
+  static llvm::Expected<std::unique_ptr<JitModel>>
+  load(const std::string &objectPath);
+
+  ~JitModel();
+
+  JitModel(const JitModel &) = delete;
+  JitModel &operator=(const JitModel &) = delete;
+
+  /// @brief Run one inference.
+  ///
+  /// Not reentrant: concurrent calls on one JitModel share its workspace.
+  /// @param inputs One dense f32 buffer per graph input, in graph order.
+  /// @param outputs One dense f32 buffer per graph output, in graph order.
+  /// @return 0 on success, otherwise the model's or a JIT error code.
+  int forward(const std::vector<const float *> &inputs,
+              const std::vector<float *> &outputs);
+
+  /// @brief Number of inputs plus outputs forward() expects.
+  std::size_t numBuffers() const noexcept { return numBuffers_; }
+
+private:
+  using PackedFunc = void (*)(void **);
+
+  JitModel() = default;
+
+  llvm::Error initialize(PackedFunc forward, PackedFunc workspaceSize,
+                         std::size_t numBuffers);
+
+  // Exactly one of them owns the code.
+  std::unique_ptr<mlir::ExecutionEngine> engine_;
+  std::unique_ptr<llvm::orc::LLJIT> jit_;
+
+  PackedFunc forward_ = nullptr;
+  std::size_t numBuffers_ = 0;
+  void *workspace_ = nullptr;
+};
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_JIT_JITMODEL_H
@@ -0,0 +1,25 @@
+#ifndef INCLUDE_LOWERING_FUSION_H
+#define INCLUDE_LOWERING_FUSION_H
+
+#include "mlir/Pass/Pass.h"
+
+#include <memory>
+
+namespace tensor_compiler {
+
+/// @brief Create a pass that fuses elementwise epilogues with their
+/// producers on tensors.
+///
+/// First, chains of elementwise linalg.generic ops (BN scale/shift, Add,
+/// Mul, Relu) are merged into a single generic. Then every elementwise
+/// generic that consumes the result of a Conv, MatMul or other reduction op
+/// is tiled, and that producer together with its fill/bias/pad producers is
+/// computed per tile inside the same scf.for nest, so the intermediate
+/// tensor never materializes in full. Producers with other users are not
+/// fused, to avoid recomputation, and neither are reductions further
+/// upstream, whose halo every tile would recompute.
+std::unique_ptr<mlir::Pass> createFuseEpiloguesPass();
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_LOWERING_FUSION_H
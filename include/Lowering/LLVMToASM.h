@@ -8,14 +8,77 @@ class Module;
 class raw_pwrite_stream;
 } // namespace llvm
 
+#include <cstdint>
+#include <optional>
 #include <string>
 
 namespace tensor_compiler {
 
+/// @brief Machine the generated code is compiled for.
+struct TargetSpec {
+  std::string triple;
+
+  /// CPU name as accepted by -mcpu; empty selects the generic CPU.
+  std::string cpu;
+
+  /// Comma-separated feature list as accepted by -mattr ("+avx2,-fma").
+  std::string features;
+};
+
+/// @brief Build a TargetSpec from driver options.
+///
+/// cpu "native" is replaced by the host CPU name and, unless features
+/// disable them, the host features; explicit features are applied on top.
+TargetSpec resolveTargetSpec(const std::string &triple, const std::string &cpu,
+                             const std::string &features);
+
+/// @brief Number of f32 lanes in the widest vector register of the target,
+/// or std::nullopt if the triple is not a registered target.
+std::optional<int64_t> getVectorWidth(const TargetSpec &target);
+
+/// @brief Kind of file written by generateCode.
+enum class CodeGenFile {
+  assembly, ///< Textual target assembly.
+  object,   ///< Relocatable object file, emitted without an assembler pass.
+  archive,  ///< Static archive of objects compiled on several threads.
+};
+
+/// @brief Optimize llvmModule with the LLVM pipeline for optLevel (0-3) and
+/// write a fileKind file for the target to os, using the matching codegen
+/// opt level. The code is position independent.
+///
+/// For CodeGenFile::archive the optimized module is split into
+/// min(threads, number of defined functions) partitions of whole functions
+/// (the entry point, one function per layer and the outlined parallel loop
+/// bodies), each compiled to an object on a thread of its own. The archive holds one member per
+/// partition and depends on the module and threads only. A warning is
+/// printed when threads > 1 has no effect. Assembly and object output is
+/// always compiled on one thread and ignores threads.
+mlir::LogicalResult generateCode(llvm::Module *llvmModule,
+                                 const TargetSpec &target, unsigned optLevel,
+                                 CodeGenFile fileKind,
+                                 llvm::raw_pwrite_stream &os,
+                                 unsigned threads = 1);
+
+/// @brief generateCode for CodeGenFile::assembly.
 mlir::LogicalResult generateAssembly(llvm::Module *llvmModule,
-                                     const std::string &triple,
+                                     const TargetSpec &target,
                                      unsigned optLevel,
                                      llvm::raw_pwrite_stream &os);
+
+/// @brief Link objectFile and the runtime static library into a shared
+/// object with the system C compiler driver (`cc`), so the result can be
+/// dlopen'ed and exposes the ModelAPI entry points.
+/// @param objectFile Model object, or a CodeGenFile::archive whose members
+/// are all linked in.
+mlir::LogicalResult linkSharedLibrary(const std::string &objectFile,
+                                      const std::string &runtimeLibrary,
+                                      const std::string &outputFile);
+
+/// @brief Merge the members of a CodeGenFile::archive into one relocatable
+/// object with the system linker (`ld -r`), for --emit=obj.
+mlir::LogicalResult linkRelocatableObject(const std::string &archiveFile,
+                                          const std::string &outputFile);
 } // namespace tensor_compiler
 
 #endif // INCLUDE_LOWERING_LLVMTOASMLOWERING_H
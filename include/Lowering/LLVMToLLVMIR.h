@@ -1,6 +1,7 @@
 #ifndef INCLUDE_LOWERING_LLVMTOLLVMIR_H
 #define INCLUDE_LOWERING_LLVMTOLLVMIR_H
 
+#include "Codegen/WeightsBlob.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "llvm/IR/LLVMContext.h"
 
@@ -12,6 +13,12 @@ namespace tensor_compiler {
 std::unique_ptr<llvm::Module>
 LLVMToLLVMIR(llvm::LLVMContext &llvmCtx,
              mlir::OwningOpRef<mlir::ModuleOp> &mlirModule);
+
+/// @brief Define the weight globals that Codegen left as external
+/// declarations, as private aliases into one constant array holding the
+/// blob. Used when the module is compiled straight to an object file, where
+/// the assembly-level .incbin is not available.
+void embedWeights(llvm::Module &llvmModule, const WeightsBlob &weights);
 } // namespace tensor_compiler
 
 #endif // INCLUDE_LOWERING_LLVMTOLLVMIR_H
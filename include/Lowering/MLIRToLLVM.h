@@ -6,9 +6,49 @@
 #include "mlir/IR/OwningOpRef.h"
 #include "mlir/Support/LogicalResult.h"
 
+#include <cstdint>
+
 namespace tensor_compiler {
+
+/// @brief Lowering strategy applied to linalg ops before bufferization.
+enum class Pipeline {
+  scalar,     ///< linalg ops become naive scalar loop nests.
+  vectorized, ///< linalg ops are tiled and rewritten into vector ops.
+};
+
+/// @brief Options controlling the MLIR to LLVM dialect lowering.
+struct LoweringOptions {
+  Pipeline pipeline = Pipeline::scalar;
+
+  /// Number of f32 lanes used by the vectorized pipeline; the driver derives
+  /// it from -mcpu/-mattr.
+  int64_t vectorWidth = 8;
+
+  /// Distribute top-level parallel loops over the runtime thread pool.
+  bool parallel = false;
+
+  /// Fuse elementwise epilogues into the loop nest of their producer.
+  bool fuse = false;
+};
+
+/// @brief Load the dialects, external interface models and LLVM IR
+/// translations Codegen and the lowering pipeline need into context.
+void registerCompilerDialects(mlir::MLIRContext &context);
+
+/// @brief Run the tensor-level optimizations (elementwise ops to linalg,
+/// epilogue fusion and, for the vectorized pipeline, tiling and
+/// vectorization) on the module in place.
+///
+/// MLIRToLLVM expects a module that went through this step.
+mlir::LogicalResult
+optimizeTensorIR(mlir::MLIRContext &context,
+                 mlir::OwningOpRef<mlir::ModuleOp> &mlirModule,
+                 const LoweringOptions &options = {});
+
+/// @brief Bufferize the optimized module and lower it to the LLVM dialect.
 mlir::LogicalResult MLIRToLLVM(mlir::MLIRContext &context,
-                               mlir::OwningOpRef<mlir::ModuleOp> &mlirModule);
+                               mlir::OwningOpRef<mlir::ModuleOp> &mlirModule,
+                               const LoweringOptions &options = {});
 } // namespace tensor_compiler
 
 #endif // INCLUDE_LOWERING_MLIRTOLLVM_H
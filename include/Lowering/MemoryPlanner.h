@@ -0,0 +1,33 @@
+#ifndef INCLUDE_LOWERING_MEMORYPLANNER_H
+#define INCLUDE_LOWERING_MEMORYPLANNER_H
+
+#include "mlir/Pass/Pass.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace tensor_compiler {
+
+/// @brief Name of the generated function returning the workspace size in
+/// bytes that tensorCompForwardImpl expects as its last argument.
+inline constexpr const char *kWorkspaceSizeFuncName =
+    "tensorCompWorkspaceSizeImpl";
+
+/// @brief Alignment in bytes of every buffer placed in the workspace; the
+/// workspace itself must be aligned to it as well.
+inline constexpr int64_t kWorkspaceAlignment = 64;
+
+/// @brief Create a pass that places the intermediate buffers of the entry
+/// function into one caller-provided workspace.
+///
+/// Runs after bufferization. Every statically shaped memref.alloc at the top
+/// level of the entry function gets a live range from its first to its last
+/// use (through aliasing views); buffers with disjoint live ranges share
+/// memory. The allocs are replaced by memref.view into a new trailing
+/// memref<N x i8> argument of the entry function, and a function named
+/// kWorkspaceSizeFuncName returning N is added to the module.
+std::unique_ptr<mlir::Pass> createMemoryPlannerPass();
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_LOWERING_MEMORYPLANNER_H
@@ -0,0 +1,23 @@
+#ifndef INCLUDE_LOWERING_OUTLINELAYERS_H
+#define INCLUDE_LOWERING_OUTLINELAYERS_H
+
+#include "mlir/Pass/Pass.h"
+
+#include <memory>
+
+namespace tensor_compiler {
+
+/// @brief Create a pass that moves every layer of the entry function into a
+/// private function of its own, called from the entry function.
+///
+/// Runs after bufferization and memory planning, where a layer is a
+/// top-level op with regions and no results: a linalg op, or the loop nest
+/// it was tiled or fused into. Memrefs with static shape and identity
+/// layout become arguments; pure producers such as constants and views are
+/// re-materialized inside. The functions are marked noinline, so LLVM keeps
+/// them apart and split code generation has one unit per layer.
+std::unique_ptr<mlir::Pass> createOutlineLayersPass();
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_LOWERING_OUTLINELAYERS_H
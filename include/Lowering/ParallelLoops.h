@@ -0,0 +1,27 @@
+#ifndef INCLUDE_LOWERING_PARALLELLOOPS_H
+#define INCLUDE_LOWERING_PARALLELLOOPS_H
+
+#include "mlir/Pass/Pass.h"
+
+#include <memory>
+
+namespace tensor_compiler {
+
+/// @brief Attribute marking an scf.for whose iterations are independent.
+///
+/// Set by the tiling pass on the outermost tile loop of a parallel dimension.
+inline constexpr const char *kParallelLoopAttrName = "tc.parallel";
+
+/// @brief Create a pass that outlines top-level parallel loops of the kernel
+/// into separate functions and replaces each loop with a call to the
+/// runtime thread pool (tensorCompParallelFor).
+///
+/// Handles scf.parallel ops and scf.for ops tagged with
+/// kParallelLoopAttrName, after bufferization. Only the outermost dimension
+/// is distributed; loops capturing values that cannot be passed through the
+/// runtime context (dynamic memrefs, non-pure scalars) stay sequential.
+std::unique_ptr<mlir::Pass> createOutlineParallelLoopsPass();
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_LOWERING_PARALLELLOOPS_H
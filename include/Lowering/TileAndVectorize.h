@@ -0,0 +1,31 @@
+#ifndef INCLUDE_LOWERING_TILEANDVECTORIZE_H
+#define INCLUDE_LOWERING_TILEANDVECTORIZE_H
+
+#include "mlir/Pass/Pass.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace tensor_compiler {
+
+/// @brief Knobs of the tensor-level tiling and vectorization pass.
+struct TileAndVectorizeOptions {
+  /// Number of f32 lanes in one SIMD register of the target.
+  int64_t vectorWidth = 8;
+
+  /// Upper bound for the tile of reduction loops that are tiled at all.
+  int64_t reductionTile = 16;
+};
+
+/// @brief Create a pass that tiles linalg ops on tensors to cache-sized
+/// blocks, decomposes 2D convolutions and pooling into 1D ones and rewrites
+/// the tiled ops into vector dialect operations.
+///
+/// Ops with dynamic shapes or without a vector form are left untouched and
+/// go through the scalar loop lowering later in the pipeline.
+std::unique_ptr<mlir::Pass>
+createTileAndVectorizePass(const TileAndVectorizeOptions &options = {});
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_LOWERING_TILEANDVECTORIZE_H
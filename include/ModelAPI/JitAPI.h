@@ -0,0 +1,37 @@
+#ifndef INCLUDE_MODELAPI_JITAPI_H
+#define INCLUDE_MODELAPI_JITAPI_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief Opaque handle of a model loaded into an in-process JIT.
+typedef struct TcJitModel TcJitModel;
+
+/// @brief Load a JIT object written by the compiler (the --run artifact of
+/// the compilation cache) without an assembler, linker or dlopen.
+///
+/// Returns NULL on failure, after printing the reason to stderr. The handle
+/// is released with tcJitFree().
+TcJitModel *tcJitLoad(const char *objectPath);
+
+/// @brief Run one inference.
+///
+/// Not reentrant: concurrent calls on one handle share its workspace.
+/// @param inputs numInputs dense f32 buffers, in graph input order.
+/// @param outputs numOutputs dense f32 buffers, in graph output order.
+/// @return 0 on success; non-zero if the buffer counts do not match the
+/// model or the model fails.
+int tcJitForward(TcJitModel *model, const float *const *inputs,
+                 size_t numInputs, float *const *outputs, size_t numOutputs);
+
+/// @brief Release a handle from tcJitLoad(); NULL is ignored.
+void tcJitFree(TcJitModel *model);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUDE_MODELAPI_JITAPI_H
@@ -1,12 +1,46 @@
 #ifndef INCLUDE_MODELAPI_MODELAPI_H
 #define INCLUDE_MODELAPI_MODELAPI_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/// @brief Run the model using a workspace owned by the calling thread,
+/// allocated on its first call. Returns non-zero on failure.
 int tensorCompForward(const float *input, float *output);
 
+/// @brief Bytes of scratch memory the model needs for intermediate tensors.
+size_t tensorCompWorkspaceSize(void);
+
+/// @brief Run the model with a caller-provided workspace of at least
+/// tensorCompWorkspaceSize() bytes, aligned to 64 bytes. A workspace must
+/// not be shared by concurrent calls.
+int tensorCompForwardWithWorkspace(const float *input, float *output,
+                                   void *workspace);
+
+/// @brief Set the number of threads used by parallel kernels.
+///
+/// A value <= 0 restores the default: TC_NUM_THREADS from the environment,
+/// or the number of online cores. 1 disables multi-threading.
+void tensorCompSetNumThreads(int numThreads);
+
+/// @brief Number of threads parallel kernels run on.
+int tensorCompGetNumThreads(void);
+
+/// @brief Loop body outlined by the compiler: runs the iterations
+/// [begin, end) of the original loop.
+typedef void (*TensorCompParallelBody)(int64_t begin, int64_t end, void *ctx);
+
+/// @brief Run body over [lb, ub) with the given step on the thread pool.
+///
+/// Called by generated code; chunk bounds passed to body are aligned to
+/// step. Nested or concurrent calls run on the calling thread.
+void tensorCompParallelFor(TensorCompParallelBody body, int64_t lb, int64_t ub,
+                           int64_t step, void *ctx);
+
 #ifdef __cplusplus
 }
 #endif
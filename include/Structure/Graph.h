@@ -1,60 +1,153 @@
 #ifndef INCLUDE_GRAPH_H
 #define INCLUDE_GRAPH_H
 
+#include "ModelFile.h"
 #include "Node.h"
 #include "Tensor.h"
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
 namespace tensor_compiler {
 
-using T_map = std::unordered_map<std::string, Tensor>;
-
 /// @brief Represents a computation graph consisting of nodes and tensors.
 ///
 /// A graph owns a collection of tensors and nodes. It tracks the input and
 /// output tensors of the entire graph. The graph can be built by adding
 /// tensors and nodes, and querying them by name.
+///
+/// Every tensor name is interned to a dense TensorId when it first appears
+/// (at parse time for the ONNX graph). The names live once in a TensorNames
+/// table shared with copies of the graph; only the graph interns into it.
+/// Its nodes, tensors and input/output lists hold ids and read the table.
+/// Tensors and the def-use index are indexed by id, so hot paths such as
+/// Codegen look them up without hashing strings. Ids stay valid for the
+/// life of the graph, also after their tensor is removed.
+///
+/// The def-use index maps every tensor to the node producing it and the
+/// nodes reading it. It follows every change of the node list, so passes
+/// can look up producers and consumers in constant time.
 class Graph final {
 private:
   std::string name_;
-  T_map tensors_;
   std::vector<Node> nodes_;
-  std::vector<std::string> inputs_;
-  std::vector<std::string> outputs_;
+  std::vector<TensorId> inputIds_;
+  std::vector<TensorId> outputIds_;
+
+  std::shared_ptr<TensorNames> names_ = std::make_shared<TensorNames>();
+  // A deque keeps the tensors handed out by tensor() in place while new
+  // names are interned. The tables below grow on demand, so ids interned by
+  // a copy of the graph may lie past their end.
+  std::deque<std::optional<Tensor>> tensors_;
+
+  std::vector<std::optional<std::size_t>> producers_;
+  std::vector<std::vector<std::size_t>> consumers_;
 
 public:
   /// @brief Construct the compute graph from an ONNX model graph
   /// @param graph onnx::GraphProto for building Graph.
-  explicit Graph(const onnx::GraphProto &graph);
+  /// @param rawData Initializer bytes cut out of graph by
+  /// parseModelWithoutRawData; the tensors view them without copying.
+  explicit Graph(const onnx::GraphProto &graph,
+                 const RawDataViews &rawData = {});
+
 
   /// @brief Get the graph name.
   /// @return const reference to name string.
   const std::string &name() const;
 
-  /// @brief Get the map of tensors (name -> Tensor).
-  /// @return const reference to T_map.
-  const T_map &tensors() const;
-
   /// @brief Get the list of nodes in the graph.
   /// @return const reference to vector of Node.
   const std::vector<Node> &nodes() const;
 
   /// @brief Get the list of graph input tensor names.
-  /// @return const reference to vector of strings.
-  const std::vector<std::string> &inputs() const;
+  /// @return View of the names of inputIds().
+  TensorNameList inputs() const;
 
   /// @brief Get the list of graph output tensor names.
-  /// @return const reference to vector of strings.
-  const std::vector<std::string> &outputs() const;
+  /// @return View of the names of outputIds().
+  TensorNameList outputs() const;
+
+  /// @brief Get the TensorIds of the graph inputs.
+  /// @return const reference to vector of ids, parallel to inputs().
+  const std::vector<TensorId> &inputIds() const;
+
+  /// @brief Get the TensorIds of the graph outputs.
+  /// @return const reference to vector of ids, parallel to outputs().
+  const std::vector<TensorId> &outputIds() const;
+
+  /// @brief Number of interned tensor names; every TensorId is below it.
+  /// @return Size for tables indexed by TensorId.
+  std::size_t tensorIdCount() const;
+
+  /// @brief Get the id of a tensor name.
+  /// @param name Tensor name.
+  /// @return TensorId, or std::nullopt if the name never appeared in this
+  /// graph or its copies.
+  std::optional<TensorId> tensorId(std::string_view name) const;
+
+  /// @brief Get the name of a tensor id.
+  /// @param id TensorId below tensorIdCount().
+  /// @return const reference to the interned name.
+  const std::string &tensorName(TensorId id) const;
 
   /// @brief Get a tensor by name.
   /// @param name Tensor name.
   /// @return Pointer to the tensor, or nullptr if not found.
   const Tensor *tensor(const std::string &name) const;
 
-private:
+  /// @brief Get a tensor by id.
+  /// @param id TensorId, e.g. from Node::inputIds().
+  /// @return Pointer to the tensor, or nullptr if it was removed or id is
+  /// kNoTensor.
+  const Tensor *tensor(TensorId id) const;
+
+  /// @brief Get the node producing a tensor.
+  /// @param name Tensor name.
+  /// @return Index into nodes(), or std::nullopt for graph inputs,
+  /// initializers and unknown names.
+  std::optional<std::size_t> producer(const std::string &name) const;
+
+  /// @brief Get the node producing a tensor.
+  /// @param id TensorId.
+  /// @return Index into nodes(), or std::nullopt for graph inputs,
+  /// initializers and kNoTensor.
+  std::optional<std::size_t> producer(TensorId id) const;
+
+  /// @brief Get the nodes reading a tensor.
+  /// @param name Tensor name.
+  /// @return Indices into nodes() in ascending order, each node once; empty
+  /// for unused and unknown names. Graph outputs are not included.
+  const std::vector<std::size_t> &consumers(const std::string &name) const;
+
+  /// @brief Get the nodes reading a tensor.
+  /// @param id TensorId.
+  /// @return As consumers(const std::string &).
+  const std::vector<std::size_t> &consumers(TensorId id) const;
+
+  /// @brief Add a tensor to the graph.
+  ///
+  /// The name is interned unless the tensor already uses this graph's
+  /// table. If a tensor with the same name already exists, it is replaced.
+  /// @param tensor The tensor to add.
+  void addTensor(Tensor tensor);
+
+  /// @brief Remove a tensor from the graph.
+  /// @param name Tensor name; unknown names are ignored.
+  void removeTensor(const std::string &name);
+
+  /// @brief Replace the node list, e.g. after a graph rewrite.
+  ///
+  /// Tensors are not touched; see removeUnusedTensors(). Rebuilds the
+  /// def-use index and the TensorIds of the nodes; indices from producer()
+  /// and consumers() refer to the new list afterwards.
+  /// @param nodes New nodes in topological order.
+  void setNodes(std::vector<Node> nodes);
+
   /// @brief Set the graph name.
   /// @param name New name.
   void setName(std::string name);
@@ -67,13 +160,10 @@ private:
   /// @param outputs Vector of output names.
   void setOutputs(const std::vector<std::string> &outputs);
 
-  /// @brief Add a tensor to the graph.
-  ///
-  /// If a tensor with the same name already exists, it is replaced.
-  /// @param tensor The tensor to add.
-  void addTensor(Tensor tensor);
-
   /// @brief Add a node to the graph.
+  ///
+  /// The node goes to the end of the list, after its producers. Its names
+  /// are interned unless it already uses this graph's table.
   /// @param node The node to add.
   void addNode(Node node);
 
@@ -85,10 +175,38 @@ private:
   /// @param output Output tensor name.
   void addOutput(const std::string &output);
 
+  /// @brief Make every node reading one tensor read another instead.
+  ///
+  /// Graph outputs are not renamed: callers keep a node producing them.
+  /// @param from Tensor name to replace.
+  /// @param to Replacement tensor name.
+  void replaceUses(const std::string &from, const std::string &to);
+
+  /// @brief Remove constant and intermediate tensors that no node and no
+  /// graph input or output refers to.
+  /// @return Number of removed tensors.
+  std::size_t removeUnusedTensors();
+
+private:
+  /// @brief Get the id of a name, interning it if new.
+  /// @param name Tensor name; empty for an omitted optional input/output.
+  /// @return TensorId, or kNoTensor for an empty name.
+  TensorId intern(std::string_view name);
+
+  /// @brief Grow the tables indexed by TensorId to hold id.
+  /// @param id TensorId of names_, or kNoTensor (ignored).
+  void reserveSlots(TensorId id);
+
+  /// @brief Give nodes_[idx] the ids of names_ and record its inputs and
+  /// outputs in the def-use index.
+  /// @param idx Index of a node appended after all indexed ones.
+  void indexNode(std::size_t idx);
+
   /// @brief Convert an ONNX TensorProto to a Tensor object.
   /// @param t The ONNX TensorProto to convert.
+  /// @param rawData Views of initializer bytes missing from t, by name.
   /// @return Tensor with name, dims, type, data and kind=constant.
-  Tensor handleTensor(const onnx::TensorProto &t);
+  Tensor handleTensor(const onnx::TensorProto &t, const RawDataViews &rawData);
 
   /// @brief Convert an ONNX ValueInfoProto to a Tensor object.
   /// @param t The ONNX ValueInfoProto to convert.
@@ -0,0 +1,93 @@
+#ifndef INCLUDE_MODELFILE_H
+#define INCLUDE_MODELFILE_H
+
+#include "onnx.pb.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace tensor_compiler {
+
+/// @brief raw_data of graph initializers by tensor name, viewing the bytes
+/// of the serialized model.
+using RawDataViews = std::unordered_map<std::string, std::string_view>;
+
+/// @brief Parse a serialized ModelProto without copying initializer bytes.
+///
+/// The raw_data fields of the main graph's initializers are cut out of the
+/// wire data before protobuf sees it: `model` gets everything else, and
+/// `rawData` gets views of the cut bytes inside `bytes`.
+/// @param bytes Serialized onnx::ModelProto.
+/// @param model Receives the model without initializer raw_data.
+/// @param rawData Receives the initializer bytes.
+/// @return false if bytes is not a well-formed ModelProto.
+bool parseModelWithoutRawData(std::string_view bytes, onnx::ModelProto &model,
+                              RawDataViews &rawData);
+
+/// @brief A file mapped read-only into memory.
+class MappedFile final {
+private:
+  void *mapping_ = nullptr;
+  std::size_t size_ = 0;
+
+public:
+  /// @brief Map the file at path.
+  /// @throws std::runtime_error if the file cannot be opened or mapped.
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /// @brief The whole file.
+  std::string_view bytes() const;
+};
+
+/// @brief An ONNX model file mapped read-only into memory.
+///
+/// Initializer bytes are never copied: Graph tensors built with rawData()
+/// view the mapping, which must outlive them. The pages are file-backed, so
+/// compiling a model costs about one times its size in memory.
+///
+/// Initializers with data_location = EXTERNAL are resolved the same way:
+/// their `location` is taken relative to the directory of the model, the
+/// file is mapped once, and `offset`/`length` select the view. This is how
+/// models over the 2 GB protobuf limit are stored.
+class ModelFile final {
+private:
+  MappedFile file_;
+  /// External data files by location; std::map keeps the mappings in place.
+  std::map<std::string, MappedFile> externalFiles_;
+  onnx::ModelProto model_;
+  RawDataViews rawData_;
+
+  void resolveExternalData(const std::string &modelPath);
+
+public:
+  /// @brief Map and parse the model at path, and map its external data.
+  /// @throws std::runtime_error if a file cannot be mapped, the model cannot
+  /// be parsed or an external data reference is invalid.
+  explicit ModelFile(const std::string &path);
+
+  ModelFile(const ModelFile &) = delete;
+  ModelFile &operator=(const ModelFile &) = delete;
+
+  /// @brief The whole file.
+  std::string_view bytes() const;
+
+  /// @brief Mapped external data files by location, in location order.
+  const std::map<std::string, MappedFile> &externalFiles() const;
+
+  /// @brief The model, without initializer raw_data.
+  const onnx::ModelProto &model() const;
+
+  /// @brief Initializer bytes of the main graph, inline raw_data and
+  /// external data alike, viewing the mappings.
+  const RawDataViews &rawData() const;
+};
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_MODELFILE_H
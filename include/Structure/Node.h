@@ -2,9 +2,12 @@
 #define INCLUDE_NODE_H
 
 #include "Attribute.h"
+#include "OpRegistry.h"
+#include "Tensor.h"
 #include "onnx.pb.h"
 #include <cstddef>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -16,8 +19,11 @@ using Attributes = std::unordered_map<std::string, Attribute>;
 /// @brief Represents a node in the computation graph.
 ///
 /// A node corresponds to an operator in the neural network. It stores the *
-/// operator type (opcode), its inputs/outputs as tensor names, and a set of
-/// attributes that parameterize the operator.
+/// operator type (opcode), its inputs/outputs and a set of attributes that
+/// parameterize the operator. Inside a Graph, inputs and outputs are
+/// TensorIds into the Graph's TensorNames table; a node built on its own,
+/// or changed by setInputs()/setOutputs(), keeps plain names until
+/// Graph::addNode() or Graph::setNodes() interns them.
 class Node final {
 public:
   using node_id = std::size_t;
@@ -26,10 +32,17 @@ public:
 private:
   node_id id_{0};
   std::string opcode_;
+  OpId opId_;
   std::string name_;
 
-  std::vector<std::string> inputs_;
-  std::vector<std::string> outputs_;
+  // Set by the Graph holding the node; copies keep them.
+  std::shared_ptr<const TensorNames> names_;
+  std::vector<TensorId> inputIds_;
+  std::vector<TensorId> outputIds_;
+
+  // Names of a node without a table.
+  std::vector<std::string> inputNames_;
+  std::vector<std::string> outputNames_;
 
   Attributes attributes_;
 
@@ -38,8 +51,9 @@ public:
   /// @param name Human-readable name of the node.
   /// @param opcode Operator type (e.g., "Conv", "Relu").
   /// @param id Unique identifier (default 0).
-  Node(const std::string &name, const std::string &opcode, node_id id = 0)
-      : id_{id}, opcode_{opcode}, name_{name} {}
+  ///
+  /// The opcode is interned in OpRegistry.
+  Node(const std::string &name, const std::string &opcode, node_id id = 0);
 
   /// @brief Set the node's name.
   /// @param name New name.
@@ -53,17 +67,37 @@ public:
   /// @return const reference to opcode string.
   const std::string &opcode() const;
 
+  /// @brief Get the interned operator type.
+  /// @return OpId of opcode() in OpRegistry.
+  OpId opId() const;
+
   /// @brief Get the node's name.
   /// @return const reference to name string.
   const std::string &name() const;
 
   /// @brief Get the list of input tensor names.
-  /// @return const reference to vector of strings.
-  const std::vector<std::string> &inputs() const;
+  /// @return View of the names; empty for omitted optional inputs.
+  TensorNameList inputs() const;
 
   /// @brief Get the list of output tensor names.
-  /// @return const reference to vector of strings.
-  const std::vector<std::string> &outputs() const;
+  /// @return View of the names; empty for omitted optional outputs.
+  TensorNameList outputs() const;
+
+  /// @brief Get the TensorIds of the inputs.
+  ///
+  /// Set for nodes of Graph::nodes() and their unchanged copies, with
+  /// kNoTensor for omitted optional inputs; empty for a node without a
+  /// table.
+  /// @return const reference to vector of ids, parallel to inputs().
+  const std::vector<TensorId> &inputIds() const;
+
+  /// @brief Get the TensorIds of the outputs.
+  ///
+  /// Set for nodes of Graph::nodes() and their unchanged copies, with
+  /// kNoTensor for omitted optional outputs; empty for a node without a
+  /// table.
+  /// @return const reference to vector of ids, parallel to outputs().
+  const std::vector<TensorId> &outputIds() const;
 
   /// @brief Get the node's attributes map.
   /// @return const reference to Attributes map.
@@ -103,8 +137,14 @@ public:
   bool hasAttribute(const std::string &name) const;
 
 private:
+  friend class Graph;
+
   void addInput(const std::string &input);
   void addOutput(const std::string &output);
+
+  /// @brief Turn the ids back into plain names and drop the table, so
+  /// changes never intern into a Graph's table.
+  void detach();
 };
 
 } // namespace tensor_compiler
@@ -0,0 +1,99 @@
+#ifndef INCLUDE_OPREGISTRY_H
+#define INCLUDE_OPREGISTRY_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tensor_compiler {
+
+class Graph;
+class Node;
+
+/// @brief Dense identifier of an interned opcode, usable as a table index.
+using OpId = std::uint32_t;
+
+/// @brief Element type (onnx::TensorProto_DataType) and shape of a tensor.
+struct TypeAndShape {
+  int type = 0;
+  std::vector<int64_t> shape;
+};
+
+/// @brief Hooks of one operator.
+///
+/// Unset hooks mean the operator does not support the feature: shape
+/// inference leaves its outputs alone and its cost counts as 0. MLIR
+/// emission is registered separately with Codegen::registerHandler.
+struct OpInfo {
+  /// Type and shape of output 0, or std::nullopt if the inputs do not
+  /// determine it yet.
+  std::function<std::optional<TypeAndShape>(const Graph &, const Node &)>
+      inferShape;
+  /// Estimated arithmetic operations of one execution.
+  std::function<std::uint64_t(const Graph &, const Node &)> cost;
+  /// Elementwise over its output, so it may be fused into a neighbour.
+  bool fusible = false;
+};
+
+/// @brief Process-wide table of operators.
+///
+/// Opcodes are interned to dense OpIds when a Node is created, so passes
+/// and Codegen dispatch by index instead of comparing strings. The
+/// operators Codegen supports are registered with their cost and fusion
+/// hooks up front; shape inference adds its rules on first use. Ops from
+/// another library are added with registerOp before the model is compiled.
+class OpRegistry final {
+private:
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, OpId> ids_;
+  // Deques keep references returned by name() and info() valid while
+  // new opcodes are interned.
+  std::deque<std::string> names_;
+  std::deque<OpInfo> infos_;
+
+  OpRegistry();
+
+public:
+  OpRegistry(const OpRegistry &) = delete;
+  OpRegistry &operator=(const OpRegistry &) = delete;
+
+  /// @brief The registry shared by the whole process.
+  static OpRegistry &instance();
+
+  /// @brief Get the id of an opcode, assigning the next one if new.
+  /// @param opcode Operator type (e.g., "Conv").
+  /// @return OpId of opcode.
+  OpId intern(std::string_view opcode);
+
+  /// @brief Look up an opcode without interning it.
+  /// @return OpId, or std::nullopt if the opcode was never seen.
+  std::optional<OpId> find(std::string_view opcode) const;
+
+  /// @brief Opcode of an id returned by intern.
+  const std::string &name(OpId id) const;
+
+  /// @brief Hooks of an id returned by intern.
+  const OpInfo &info(OpId id) const;
+
+  /// @brief Register an operator or replace all of its hooks.
+  ///
+  /// Not synchronized with readers of info(); register ops before
+  /// compiling.
+  /// @param opcode Operator type.
+  /// @param info Hooks of the operator.
+  /// @return OpId of opcode.
+  OpId registerOp(std::string_view opcode, OpInfo info);
+
+  /// @brief Number of interned opcodes; every OpId is below it.
+  std::size_t size() const;
+};
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_OPREGISTRY_H
@@ -2,7 +2,17 @@
 #define INCLUDE_TENSOR_H
 
 #include "onnx.pb.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace tensor_compiler {
@@ -15,21 +25,169 @@ enum class Tensor_kind {
   constant,
 };
 
+/// @brief Size of a dimension only known at run time (symbolic ONNX dims);
+/// the same value as mlir::ShapedType::kDynamic.
+inline constexpr int64_t kDynamicDim = std::numeric_limits<int64_t>::min();
+
+/// @brief Dense index of a tensor name within its TensorNames table.
+using TensorId = std::uint32_t;
+
+/// @brief TensorId of an omitted optional node input or output.
+inline constexpr TensorId kNoTensor = std::numeric_limits<TensorId>::max();
+
+/// @brief Append-only table interning tensor names to dense TensorIds.
+///
+/// A Graph shares one table with its nodes and tensors, which store only
+/// TensorIds. Names are never removed, so ids and the references returned
+/// by name() stay valid while the table is alive.
+class TensorNames final {
+private:
+  // A deque keeps the strings viewed by ids_ in place.
+  std::deque<std::string> names_;
+  std::unordered_map<std::string_view, TensorId> ids_;
+
+public:
+  TensorNames() = default;
+  TensorNames(const TensorNames &) = delete;
+  TensorNames &operator=(const TensorNames &) = delete;
+
+  /// @brief Get the id of a name, interning it if new.
+  /// @param name Tensor name; empty for an omitted optional input/output.
+  /// @return TensorId, or kNoTensor for an empty name.
+  TensorId intern(std::string_view name);
+
+  /// @brief Get the id of a name without interning it.
+  /// @param name Tensor name.
+  /// @return TensorId, or std::nullopt if the name was never interned.
+  std::optional<TensorId> find(std::string_view name) const;
+
+  /// @brief Get the name of an id.
+  /// @param id TensorId below size(), or kNoTensor.
+  /// @return const reference to the name; empty for kNoTensor.
+  const std::string &name(TensorId id) const;
+
+  /// @brief Number of interned names; every TensorId is below it.
+  /// @return Size for tables indexed by TensorId.
+  std::size_t size() const;
+};
+
+/// @brief Read-only list of tensor names, as returned by Node::inputs(),
+/// Node::outputs(), Graph::inputs() and Graph::outputs().
+///
+/// Views either TensorIds and their table, or the plain names of a node
+/// that is not in a Graph. It is valid while its owner is alive and the
+/// viewed list is unchanged. Converts to std::vector<std::string> for
+/// callers that need a copy.
+class TensorNameList final {
+public:
+  class const_iterator final {
+  private:
+    const TensorId *id_ = nullptr;
+    const std::string *name_ = nullptr;
+    const TensorNames *names_ = nullptr;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string *;
+    using reference = const std::string &;
+
+    const_iterator() = default;
+    const_iterator(const TensorId *id, const TensorNames *names)
+        : id_{id}, names_{names} {}
+    explicit const_iterator(const std::string *name) : name_{name} {}
+
+    reference operator*() const {
+      return names_ ? names_->name(*id_) : *name_;
+    }
+    pointer operator->() const { return &**this; }
+    const_iterator &operator++() {
+      if (names_)
+        ++id_;
+      else
+        ++name_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++*this;
+      return old;
+    }
+    friend bool operator==(const const_iterator &a, const const_iterator &b) {
+      return a.id_ == b.id_ && a.name_ == b.name_;
+    }
+  };
+  using iterator = const_iterator;
+  using value_type = std::string;
+  using size_type = std::size_t;
+
+private:
+  const std::vector<TensorId> *ids_ = nullptr;
+  const TensorNames *names_ = nullptr;
+  const std::vector<std::string> *strings_ = nullptr;
+
+public:
+  /// @brief Construct a view of ids.
+  /// @param ids TensorIds to name; must outlive the view.
+  /// @param names Table of ids; not null.
+  TensorNameList(const std::vector<TensorId> &ids, const TensorNames *names)
+      : ids_{&ids}, names_{names} {}
+
+  /// @brief Construct a view of plain names.
+  /// @param names Names; must outlive the view.
+  explicit TensorNameList(const std::vector<std::string> &names)
+      : strings_{&names} {}
+
+  std::size_t size() const {
+    return names_ ? ids_->size() : strings_->size();
+  }
+  bool empty() const { return size() == 0; }
+  const std::string &operator[](std::size_t i) const {
+    return names_ ? names_->name((*ids_)[i]) : (*strings_)[i];
+  }
+  const_iterator begin() const {
+    return names_ ? const_iterator{ids_->data(), names_}
+                  : const_iterator{strings_->data()};
+  }
+  const_iterator end() const {
+    return names_ ? const_iterator{ids_->data() + ids_->size(), names_}
+                  : const_iterator{strings_->data() + strings_->size()};
+  }
+
+  operator std::vector<std::string>() const {
+    return std::vector<std::string>(begin(), end());
+  }
+
+  friend bool operator==(const TensorNameList &list,
+                         const std::vector<std::string> &names) {
+    return list.size() == names.size() &&
+           std::equal(names.begin(), names.end(), list.begin());
+  }
+};
+
 using data_type = onnx::TensorProto_DataType;
 using dim_type = google::protobuf::RepeatedField<int64_t>;
 
 /// @brief Represents a tensor in the computation graph.
 ///
 /// Stores tensor metadata: name, data type, shape, raw data, and its kind.
-/// The raw data is stored as a string (binary blob). For float tensors,
-/// a convenience factory method Tensor::create() is provided.
+/// The raw data is either owned (a shared, immutable string, so copies of
+/// a Tensor are cheap) or a non-owning view of bytes kept alive elsewhere,
+/// e.g. a memory-mapped model file. For float tensors, a convenience
+/// factory method Tensor::create() is provided.
 class Tensor final {
 private:
+  // Set by the Graph holding the tensor, which interns the name; copies
+  // keep them. A tensor outside a Graph keeps its name in name_ instead.
+  std::shared_ptr<const TensorNames> names_;
+  TensorId id_ = kNoTensor;
   std::string name_;
   int type_ = data_type::TensorProto_DataType_UNDEFINED;
   Tensor_kind kind_ = Tensor_kind::unknown;
 
-  std::string data_;
+  std::shared_ptr<const std::string> storage_;
+  std::string_view data_;
   std::vector<int64_t> shape_;
   dim_type dim_;
 
@@ -44,7 +202,10 @@ public:
   /// @param kind Tensor kind (default unknown).
   Tensor(const std::string &name, data_type type, std::vector<int64_t> shape,
          const std::string &data, Tensor_kind kind = Tensor_kind::unknown)
-      : name_{name}, type_{type}, kind_{kind}, data_{data}, shape_{shape} {}
+      : type_{type}, kind_{kind}, shape_{shape} {
+    setName(name);
+    setData(data);
+  }
 
   /// @brief Create a float tensor from a vector of floats.
   /// Convenience method that packs the float data into a binary string.
@@ -58,7 +219,7 @@ public:
                        const std::vector<float> &data, const Tensor_kind &kind);
 
   /// @brief Get the tensor name.
-  /// @return const reference to name string.
+  /// @return const reference to name string, empty if never set.
   const std::string &name() const;
 
   /// @brief Get the data type.
@@ -69,9 +230,10 @@ public:
   /// @return Tensor_kind.
   Tensor_kind kind() const;
 
-  /// @brief Get the raw data as a string.
-  /// @return const reference to data string.
-  const std::string &data() const;
+  /// @brief Get the raw data.
+  /// @return View of the bytes, valid while the tensor (or, for setDataView,
+  /// the viewed buffer) is alive.
+  std::string_view data() const;
 
   /// @brief Get the tensor shape.
   /// @return const reference to vector of dimensions.
@@ -82,6 +244,9 @@ public:
   const dim_type dim() const;
 
   /// @brief Set the tensor name.
+  ///
+  /// Detaches the tensor from the name table of its Graph; Graph::addTensor
+  /// interns the new name.
   /// @param name New name.
   void setName(const std::string &name);
 
@@ -93,9 +258,13 @@ public:
   /// @param kind Tensor_kind.
   void setKind(Tensor_kind kind);
 
-  /// @brief Set the raw data.
+  /// @brief Set the raw data; the tensor takes ownership of it.
   /// @param data Binary string.
-  void setData(const std::string &data);
+  void setData(std::string data);
+
+  /// @brief Set the raw data without copying it.
+  /// @param data Bytes that must outlive the tensor and all its copies.
+  void setDataView(std::string_view data);
 
   /// @brief Set the tensor shape.
   /// @param shape Vector of dimensions.
@@ -108,6 +277,9 @@ public:
   /// @brief Check if the tensor is a constant (initializer).
   /// @return true if kind_ == Tensor_kind::constant.
   bool isConstant() const;
+
+private:
+  friend class Graph;
 };
 
 } // namespace tensor_compiler
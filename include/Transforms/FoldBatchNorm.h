@@ -0,0 +1,27 @@
+#ifndef INCLUDE_TRANSFORMS_FOLDBATCHNORM_H
+#define INCLUDE_TRANSFORMS_FOLDBATCHNORM_H
+
+#include "Structure/Graph.h"
+
+#include <cstddef>
+
+namespace tensor_compiler {
+
+/// @brief Fold inference-mode BatchNormalization nodes into the Conv that
+/// produces their input.
+///
+/// A BatchNormalization is folded when its input comes from a Conv with a
+/// constant f32 filter (and bias, if any), that Conv output has no other
+/// consumer and is not a graph output, and scale/bias/mean/var are constant
+/// f32 tensors with one value per output channel. The Conv then receives
+/// new constant weights W * s and bias (b - mean) * s + beta, with
+/// s = scale / sqrt(var + epsilon), and writes the BatchNormalization
+/// output directly. Constants left without users are removed.
+///
+/// @param graph Graph to rewrite in place.
+/// @return Number of folded BatchNormalization nodes.
+std::size_t foldConvBatchNorm(Graph &graph);
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_TRANSFORMS_FOLDBATCHNORM_H
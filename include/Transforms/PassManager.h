@@ -0,0 +1,83 @@
+#ifndef INCLUDE_TRANSFORMS_PASSMANAGER_H
+#define INCLUDE_TRANSFORMS_PASSMANAGER_H
+
+#include "Structure/Graph.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace tensor_compiler {
+
+/// @brief A rewrite of the Structure IR.
+///
+/// Passes may assume the nodes are in topological order and must keep them
+/// so. They rewrite nodes through the public Graph API; tensors left
+/// without references are removed by the PassManager.
+class GraphPass {
+public:
+  virtual ~GraphPass() = default;
+
+  /// @brief Name used on the command line, e.g. "dce".
+  virtual std::string_view name() const = 0;
+
+  /// @brief Rewrite graph in place.
+  /// @return true if the graph changed.
+  virtual bool run(Graph &graph) = 0;
+};
+
+/// @brief Runs graph passes in order until none of them changes the graph.
+class PassManager final {
+private:
+  std::vector<std::unique_ptr<GraphPass>> passes_;
+  std::unordered_set<std::string> disabled_;
+
+public:
+  /// @brief Upper bound on the rounds over all passes.
+  static constexpr int kMaxRounds = 8;
+
+  /// @brief Append a pass.
+  void addPass(std::unique_ptr<GraphPass> pass);
+
+  /// @brief Skip the pass with this name in run().
+  /// @throws std::runtime_error if no added pass has this name.
+  void disable(const std::string &name);
+
+  /// @brief Names of the added passes, in order.
+  std::vector<std::string> passNames() const;
+
+  /// @brief Run the enabled passes over graph, repeating the whole sequence
+  /// while some pass reports a change (at most kMaxRounds times), then
+  /// remove unused tensors.
+  /// @return true if the graph changed.
+  bool run(Graph &graph) const;
+};
+
+/// @brief Fold inference BatchNormalization into Conv ("fold-batch-norm"),
+/// see foldConvBatchNorm.
+std::unique_ptr<GraphPass> createFoldBatchNormPass();
+
+/// @brief Remove nodes none of whose outputs reaches a graph output ("dce").
+std::unique_ptr<GraphPass> createDeadCodeEliminationPass();
+
+/// @brief Forward the input of Identity nodes to their consumers
+/// ("identity"). An Identity producing a graph output is kept.
+std::unique_ptr<GraphPass> createIdentityEliminationPass();
+
+/// @brief Evaluate nodes with only constant inputs at compile time and
+/// replace their outputs with initializers ("constant-fold"). Needs the
+/// shapes from inferShapes.
+std::unique_ptr<GraphPass> createConstantFoldingPass();
+
+/// @brief Merge nodes with the same op, inputs and attributes ("cse").
+std::unique_ptr<GraphPass> createCSEPass();
+
+/// @brief Add the default pipeline: fold-batch-norm, identity,
+/// constant-fold, cse, dce.
+void addDefaultGraphPasses(PassManager &pm);
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_TRANSFORMS_PASSMANAGER_H
@@ -0,0 +1,41 @@
+#ifndef INCLUDE_TRANSFORMS_SCHEDULE_H
+#define INCLUDE_TRANSFORMS_SCHEDULE_H
+
+#include "Structure/Graph.h"
+
+#include <cstddef>
+
+namespace tensor_compiler {
+
+/// @brief Put the nodes into a topological order.
+///
+/// ONNX only recommends topologically sorted node lists, so files in any
+/// order are accepted. Nodes already in a valid position keep their
+/// relative file order.
+/// @param graph Graph to reorder in place.
+/// @throws std::runtime_error if the nodes form a cycle.
+void sortTopologically(Graph &graph);
+
+/// @brief Reorder the nodes to reduce the peak size of live activations.
+///
+/// List scheduling over the dependency graph: among the ready nodes, run the
+/// one that grows the live set least, i.e. the bytes of its outputs minus
+/// the bytes of inputs it is the last consumer of; ties keep file order.
+/// Activations are the tensors produced by nodes that are not graph outputs;
+/// their sizes come from the shapes of inferShapes, and tensors of unknown
+/// or dynamic size count as zero. The greedy order only looks one node
+/// ahead, so it is kept only if its peak is below that of the order from
+/// sortTopologically(); otherwise the graph gets the latter.
+/// @param graph Graph to reorder in place.
+/// @return Peak live activation bytes of the new order.
+/// @throws std::runtime_error if the nodes form a cycle.
+std::size_t scheduleForMemory(Graph &graph);
+
+/// @brief Peak live activation bytes of the current node order, with the
+/// same accounting as scheduleForMemory.
+/// @param graph Graph in topological order.
+std::size_t peakActivationBytes(const Graph &graph);
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_TRANSFORMS_SCHEDULE_H
@@ -0,0 +1,34 @@
+#ifndef INCLUDE_TRANSFORMS_SHAPEINFERENCE_H
+#define INCLUDE_TRANSFORMS_SHAPEINFERENCE_H
+
+#include "Structure/Graph.h"
+
+#include <cstddef>
+
+namespace tensor_compiler {
+
+/// @brief Infer element types and shapes of the tensors produced by nodes.
+///
+/// Walks the nodes in order and derives output 0 from the inputs with the
+/// OpInfo::inferShape rule registered for the op in OpRegistry. Built-in
+/// rules follow ONNX for the ops Codegen supports: elementwise ops with
+/// numpy broadcasting, Conv and MaxPool (pads, strides, dilations,
+/// auto_pad), ReduceMean, Reshape, Squeeze and Unsqueeze with constant
+/// shape/axes inputs, MatMul, Softmax, ArgMax and BatchNormalization, plus
+/// the shape arithmetic ops Shape, Gather, Concat and Transpose that
+/// constant folding evaluates. Dimensions that depend on a dynamic input
+/// dimension stay kDynamicDim; outputs of ops without a rule or of
+/// nodes with an unknown input are left untouched.
+///
+/// Declared graph outputs are refined: dynamic dimensions take the inferred
+/// size, an output without a declared shape takes the inferred one.
+///
+/// @param graph Graph to annotate in place.
+/// @return Number of tensors whose type or shape changed.
+/// @throws std::runtime_error if inputs are incompatible (e.g. a failing
+/// broadcast) or an inferred shape contradicts a declared output.
+std::size_t inferShapes(Graph &graph);
+
+} // namespace tensor_compiler
+
+#endif // INCLUDE_TRANSFORMS_SHAPEINFERENCE_H
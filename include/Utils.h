@@ -22,12 +22,16 @@ struct EdgeHash {
 inline void dumpTensors(const Graph &graph, std::ostream &os) {
   os << "Graph name: " << graph.name() << "\n";
   os << "Tensors:\n";
-  for (const auto &[name, tensor] : graph.tensors()) {
-    os << "  " << name << ": type=" << tensor.type()
-       << ", kind=" << static_cast<int>(tensor.kind()) << ", shape=[";
-    for (size_t i = 0; i < tensor.shape().size(); ++i) {
-      os << tensor.shape()[i];
-      if (i < tensor.shape().size() - 1) {
+  for (TensorId id = 0; id < graph.tensorIdCount(); ++id) {
+    const Tensor *tensor = graph.tensor(id);
+    if (!tensor) {
+      continue;
+    }
+    os << "  " << tensor->name() << ": type=" << tensor->type()
+       << ", kind=" << static_cast<int>(tensor->kind()) << ", shape=[";
+    for (size_t i = 0; i < tensor->shape().size(); ++i) {
+      os << tensor->shape()[i];
+      if (i < tensor->shape().size() - 1) {
         os << ", ";
       }
     }
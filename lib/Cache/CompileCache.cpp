@@ -0,0 +1,104 @@
+#include "Cache/CompileCache.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+namespace tensor_compiler {
+
+namespace {
+
+// Any function of the executable gives getMainExecutable its path.
+void anchor() {}
+
+} // namespace
+
+CacheKey &CacheKey::add(llvm::StringRef field) {
+    add(static_cast<int64_t>(field.size()));
+    hasher_.update(field);
+    return *this;
+}
+
+CacheKey &CacheKey::add(int64_t value) {
+    uint8_t bytes[sizeof(value)];
+    for (size_t i = 0; i < sizeof(value); ++i) {
+        bytes[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i));
+    }
+    hasher_.update(llvm::ArrayRef<uint8_t>(bytes, sizeof(bytes)));
+    return *this;
+}
+
+CacheKey &CacheKey::addCompilerVersion() {
+    add(LLVM_VERSION_STRING);
+
+    std::string executable = llvm::sys::fs::getMainExecutable(
+        nullptr, reinterpret_cast<void *>(&anchor));
+    llvm::sys::fs::file_status status;
+    if (!executable.empty() && !llvm::sys::fs::status(executable, status)) {
+        add(static_cast<int64_t>(status.getSize()));
+        add(static_cast<int64_t>(
+            llvm::sys::toTimeT(status.getLastModificationTime())));
+    } else {
+        // Unknown build: a fresh key every run, i.e. never a stale hit.
+        add(executable);
+        add(static_cast<int64_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count()));
+    }
+    return *this;
+}
+
+std::string CacheKey::finish() {
+    return llvm::toHex(hasher_.final(), /*LowerCase=*/true);
+}
+
+CompileCache::CompileCache(std::string directory)
+    : directory_(std::move(directory)) {}
+
+std::string CompileCache::defaultDirectory() {
+    const char *env = std::getenv("TC_CACHE_DIR");
+    return env ? std::string(env) : std::string();
+}
+
+std::string CompileCache::entryPath(llvm::StringRef key) const {
+    llvm::SmallString<256> path(directory_);
+    llvm::sys::path::append(path, key + ".o");
+    return std::string(path);
+}
+
+std::optional<std::string> CompileCache::lookup(llvm::StringRef key) const {
+    std::string path = entryPath(key);
+    if (!llvm::sys::fs::is_regular_file(path)) {
+        return std::nullopt;
+    }
+    return path;
+}
+
+std::string CompileCache::createTemporary() const {
+    if (llvm::sys::fs::create_directories(directory_)) {
+        return {};
+    }
+    llvm::SmallString<256> model(directory_);
+    llvm::sys::path::append(model, "tmp-%%%%%%%%.o");
+    int fd = -1;
+    llvm::SmallString<256> path;
+    if (llvm::sys::fs::createUniqueFile(model, fd, path)) {
+        return {};
+    }
+    llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+    return std::string(path);
+}
+
+bool CompileCache::insert(llvm::StringRef key,
+                          const std::string &temporaryPath) const {
+    return !llvm::sys::fs::rename(temporaryPath, entryPath(key));
+}
+
+} // namespace tensor_compiler
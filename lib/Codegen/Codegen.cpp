@@ -1,8 +1,12 @@
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <unordered_map>
 #include <vector>
 #include <string>
 #include <limits>
+#include <optional>
+#include <cmath>
 #include "Codegen/Codegen.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Math/IR/Math.h"
@@ -13,6 +17,7 @@
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Linalg/Utils/Utils.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/AsmState.h"
 #include "llvm/ADT/SmallVector.h"
 
 namespace tensor_compiler {
@@ -20,16 +25,22 @@ namespace tensor_compiler {
 namespace {
 
 mlir::Value getBoundValue(
-    const std::unordered_map<std::string, mlir::Value> &values,
-    const std::string &name,
+    const Codegen::Values &values,
+    const Node &node,
+    size_t input,
     const char *opName) {
 
-    auto it = values.find(name);
-    if (it == values.end()) {
+    TensorId id = node.inputIds().at(input);
+    if (id >= values.size() || !values[id]) {
         throw std::runtime_error(std::string(opName) +
-                                 " input not bound: " + name);
+                                 " input not bound: " + node.inputs()[input]);
     }
-    return it->second;
+    return values[id];
+}
+
+// The value of a graph input or output, or a null Value if not bound.
+mlir::Value lookupValue(const Codegen::Values &values, TensorId id) {
+    return id < values.size() ? values[id] : mlir::Value();
 }
 
 void checkUnaryNodeShape(const Node &node, const char *opName) {
@@ -207,6 +218,49 @@ void checkBatchNormParamType(mlir::Value value, int64_t channels,
     }
 }
 
+// Returns the values of a constant rank-1 f32 tensor with `channels`
+// elements, or std::nullopt if the tensor is computed at runtime.
+std::optional<std::vector<float>> readChannelConstant(const Graph &graph,
+                                                      const std::string &name,
+                                                      int64_t channels) {
+    const Tensor *tensor = graph.tensor(name);
+    if (!tensor || !tensor->isConstant() ||
+        tensor->type() != onnx::TensorProto_DataType_FLOAT ||
+        tensor->shape().size() != 1 || tensor->shape()[0] != channels) {
+        return std::nullopt;
+    }
+
+    const auto &raw = tensor->data();
+    if (raw.size() != static_cast<size_t>(channels) * sizeof(float)) {
+        return std::nullopt;
+    }
+
+    std::vector<float> data(static_cast<size_t>(channels));
+    std::memcpy(data.data(), raw.data(), raw.size());
+    return data;
+}
+
+// Returns the values of a constant f32 filter with `elements` elements,
+// or std::nullopt if it is computed at runtime.
+std::optional<std::vector<float>> readFilterConstant(const Graph &graph,
+                                                     const std::string &name,
+                                                     int64_t elements) {
+    const Tensor *tensor = graph.tensor(name);
+    if (!tensor || !tensor->isConstant() ||
+        tensor->type() != onnx::TensorProto_DataType_FLOAT) {
+        return std::nullopt;
+    }
+
+    const auto &raw = tensor->data();
+    if (raw.size() != static_cast<size_t>(elements) * sizeof(float)) {
+        return std::nullopt;
+    }
+
+    std::vector<float> data(static_cast<size_t>(elements));
+    std::memcpy(data.data(), raw.data(), raw.size());
+    return data;
+}
+
 std::vector<int64_t> computeBroadcastResultShape(
     llvm::ArrayRef<int64_t> shapeA,
     llvm::ArrayRef<int64_t> shapeB) {
@@ -324,9 +378,573 @@ mlir::Value genBroadcastAddOp(
     return addOp.getResult(0);
 }
 
+void buildMulAccBody(mlir::OpBuilder &b, mlir::Location l,
+                     mlir::ValueRange args) {
+    auto product = b.create<mlir::arith::MulFOp>(l, args[0], args[1]);
+    auto sum = b.create<mlir::arith::AddFOp>(l, args[2], product.getResult());
+    b.create<mlir::linalg::YieldOp>(l, sum.getResult());
+}
+
+// Depthwise convolution (group == channels, one filter per channel) as a
+// generic with loops (n, c, oh, kh, kw, ow): every kernel tap sweeps a whole
+// contiguous output row, which suits the memory-bound depthwise layers
+// better than the channel-innermost order of the named depthwise ops.
+mlir::Value genDepthwiseConvOp(mlir::OpBuilder &builder, mlir::Location loc,
+                               mlir::Value input, mlir::Value filter,
+                               mlir::Value init,
+                               llvm::ArrayRef<int64_t> strides,
+                               llvm::ArrayRef<int64_t> dilations) {
+    auto filterType = mlir::cast<mlir::RankedTensorType>(filter.getType());
+    auto filterShape = filterType.getShape();
+    auto collapsedType = mlir::RankedTensorType::get(
+        {filterShape[0], filterShape[2], filterShape[3]},
+        filterType.getElementType());
+    llvm::SmallVector<mlir::ReassociationIndices> reassociation = {
+        {0, 1}, {2}, {3}};
+    mlir::Value collapsedFilter = builder.create<mlir::tensor::CollapseShapeOp>(
+        loc, collapsedType, filter, reassociation);
+
+    auto *ctx = builder.getContext();
+    auto n = builder.getAffineDimExpr(0);
+    auto c = builder.getAffineDimExpr(1);
+    auto oh = builder.getAffineDimExpr(2);
+    auto kh = builder.getAffineDimExpr(3);
+    auto kw = builder.getAffineDimExpr(4);
+    auto ow = builder.getAffineDimExpr(5);
+
+    auto inputMap = mlir::AffineMap::get(
+        6, 0,
+        {n, c, oh * strides[0] + kh * dilations[0],
+         ow * strides[1] + kw * dilations[1]},
+        ctx);
+    auto filterMap = mlir::AffineMap::get(6, 0, {c, kh, kw}, ctx);
+    auto outputMap = mlir::AffineMap::get(6, 0, {n, c, oh, ow}, ctx);
+
+    auto depthwise = builder.create<mlir::linalg::GenericOp>(
+        loc,
+        mlir::TypeRange{init.getType()},
+        mlir::ValueRange{input, collapsedFilter},
+        mlir::ValueRange{init},
+        llvm::ArrayRef<mlir::AffineMap>{inputMap, filterMap, outputMap},
+        createMixedIterators(6, {3, 4}),
+        buildMulAccBody);
+    return depthwise.getResult(0);
+}
+
+// Grouped convolution as one generic over 5-D views: input
+// [N, G, C/G, H, W], filter [G, F/G, C/G, KH, KW], output
+// [N, G, F/G, OH, OW], with loops (n, g, fg, oh, ow, c, kh, kw).
+mlir::Value genGroupedConvOp(mlir::OpBuilder &builder, mlir::Location loc,
+                             mlir::Value input, mlir::Value filter,
+                             mlir::Value init, int64_t group,
+                             llvm::ArrayRef<int64_t> strides,
+                             llvm::ArrayRef<int64_t> dilations) {
+    auto inputType = mlir::cast<mlir::RankedTensorType>(input.getType());
+    auto filterType = mlir::cast<mlir::RankedTensorType>(filter.getType());
+    auto initType = mlir::cast<mlir::RankedTensorType>(init.getType());
+    auto in = inputType.getShape();
+    auto fl = filterType.getShape();
+    auto out = initType.getShape();
+    auto elementType = inputType.getElementType();
+
+    llvm::SmallVector<mlir::ReassociationIndices> splitChannels = {
+        {0}, {1, 2}, {3}, {4}};
+    llvm::SmallVector<mlir::ReassociationIndices> splitFilters = {
+        {0, 1}, {2}, {3}, {4}};
+
+    auto input5Type = mlir::RankedTensorType::get(
+        {in[0], group, in[1] / group, in[2], in[3]}, elementType);
+    auto filter5Type = mlir::RankedTensorType::get(
+        {group, fl[0] / group, fl[1], fl[2], fl[3]}, elementType);
+    auto output5Type = mlir::RankedTensorType::get(
+        {out[0], group, out[1] / group, out[2], out[3]}, elementType);
+
+    mlir::Value input5 = builder.create<mlir::tensor::ExpandShapeOp>(
+        loc, input5Type, input, splitChannels);
+    mlir::Value filter5 = builder.create<mlir::tensor::ExpandShapeOp>(
+        loc, filter5Type, filter, splitFilters);
+    mlir::Value init5 = builder.create<mlir::tensor::ExpandShapeOp>(
+        loc, output5Type, init, splitChannels);
+
+    auto *ctx = builder.getContext();
+    auto n = builder.getAffineDimExpr(0);
+    auto g = builder.getAffineDimExpr(1);
+    auto fg = builder.getAffineDimExpr(2);
+    auto oh = builder.getAffineDimExpr(3);
+    auto ow = builder.getAffineDimExpr(4);
+    auto c = builder.getAffineDimExpr(5);
+    auto kh = builder.getAffineDimExpr(6);
+    auto kw = builder.getAffineDimExpr(7);
+
+    auto inputMap = mlir::AffineMap::get(
+        8, 0,
+        {n, g, c, oh * strides[0] + kh * dilations[0],
+         ow * strides[1] + kw * dilations[1]},
+        ctx);
+    auto filterMap = mlir::AffineMap::get(8, 0, {g, fg, c, kh, kw}, ctx);
+    auto outputMap = mlir::AffineMap::get(8, 0, {n, g, fg, oh, ow}, ctx);
+
+    auto grouped = builder.create<mlir::linalg::GenericOp>(
+        loc,
+        mlir::TypeRange{output5Type},
+        mlir::ValueRange{input5, filter5},
+        mlir::ValueRange{init5},
+        llvm::ArrayRef<mlir::AffineMap>{inputMap, filterMap, outputMap},
+        createMixedIterators(8, {5, 6, 7}),
+        buildMulAccBody);
+
+    return builder.create<mlir::tensor::CollapseShapeOp>(
+        loc, initType, grouped.getResult(0), splitChannels);
+}
+
+// The automatic conv lowering packs patches only when the GEMM is deep
+// enough to amortize the pack and the patch matrix stays cache-friendly.
+constexpr int64_t kIm2ColMinDepth = 32;
+constexpr int64_t kIm2ColMinPixels = 16;
+constexpr int64_t kIm2ColMaxPackBytes = 32 * 1024 * 1024;
+
+bool preferIm2Col(ConvLowering lowering, bool pointwise, int64_t batch,
+                  int64_t depth, int64_t pixels) {
+    switch (lowering) {
+    case ConvLowering::direct:
+        return false;
+    case ConvLowering::im2col:
+        return true;
+    case ConvLowering::automatic:
+        break;
+    }
+    if (pointwise) {
+        return true;
+    }
+    if (mlir::ShapedType::isDynamic(batch) || batch <= 0) {
+        return false;
+    }
+    return depth >= kIm2ColMinDepth && pixels >= kIm2ColMinPixels &&
+           batch * depth * pixels * static_cast<int64_t>(sizeof(float)) <=
+               kIm2ColMaxPackBytes;
+}
+
+// Convolution as GEMM: the patch matrix cols[n, (c, kh, kw), (oh, ow)] is
+// packed by a generic (or is the input itself for 1x1 stride-1 convs
+// without padding), and out[n, f, p] = sum_k W[f, k] * cols[n, k, p]. A
+// static batch of 1 uses linalg.matmul directly.
+mlir::Value genIm2ColConvOp(mlir::OpBuilder &builder, mlir::Location loc,
+                            mlir::Value input, mlir::Value filter,
+                            mlir::Value init, bool pointwise,
+                            llvm::ArrayRef<int64_t> strides,
+                            llvm::ArrayRef<int64_t> dilations) {
+    auto inputType = mlir::cast<mlir::RankedTensorType>(input.getType());
+    auto filterType = mlir::cast<mlir::RankedTensorType>(filter.getType());
+    auto initType = mlir::cast<mlir::RankedTensorType>(init.getType());
+    auto elementType = inputType.getElementType();
+    auto *ctx = builder.getContext();
+
+    const int64_t batch = inputType.getShape()[0];
+    const int64_t channels = inputType.getShape()[1];
+    const int64_t filters = filterType.getShape()[0];
+    const int64_t kernelH = filterType.getShape()[2];
+    const int64_t kernelW = filterType.getShape()[3];
+    const int64_t outH = initType.getShape()[2];
+    const int64_t outW = initType.getShape()[3];
+    const int64_t depth = channels * kernelH * kernelW;
+    const int64_t pixels = outH * outW;
+
+    llvm::SmallVector<mlir::ReassociationIndices> flattenTail = {
+        {0}, {1, 2, 3}};
+    llvm::SmallVector<mlir::ReassociationIndices> flattenSpatial = {
+        {0}, {1}, {2, 3}};
+
+    mlir::Value cols;
+    auto colsType =
+        mlir::RankedTensorType::get({batch, depth, pixels}, elementType);
+    if (pointwise) {
+        cols = builder.create<mlir::tensor::CollapseShapeOp>(
+            loc, colsType, input, flattenSpatial);
+    } else {
+        auto patchType = mlir::RankedTensorType::get(
+            {batch, channels, kernelH, kernelW, outH, outW}, elementType);
+        std::vector<mlir::Value> dynamicDims;
+        if (mlir::ShapedType::isDynamic(batch)) {
+            dynamicDims.push_back(
+                builder.create<mlir::tensor::DimOp>(loc, input, 0));
+        }
+        auto patchEmpty = builder.create<mlir::tensor::EmptyOp>(
+            loc, patchType, dynamicDims);
+
+        auto n = builder.getAffineDimExpr(0);
+        auto c = builder.getAffineDimExpr(1);
+        auto kh = builder.getAffineDimExpr(2);
+        auto kw = builder.getAffineDimExpr(3);
+        auto oh = builder.getAffineDimExpr(4);
+        auto ow = builder.getAffineDimExpr(5);
+        auto inputMap = mlir::AffineMap::get(
+            6, 0,
+            {n, c, oh * strides[0] + kh * dilations[0],
+             ow * strides[1] + kw * dilations[1]},
+            ctx);
+        auto patchMap = mlir::AffineMap::get(6, 0, {n, c, kh, kw, oh, ow}, ctx);
+
+        auto pack = builder.create<mlir::linalg::GenericOp>(
+            loc,
+            mlir::TypeRange{patchType},
+            mlir::ValueRange{input},
+            mlir::ValueRange{patchEmpty.getResult()},
+            llvm::ArrayRef<mlir::AffineMap>{inputMap, patchMap},
+            createParallelIterators(6),
+            [](mlir::OpBuilder &b, mlir::Location l, mlir::ValueRange args) {
+                b.create<mlir::linalg::YieldOp>(l, args[0]);
+            });
+        cols = builder.create<mlir::tensor::CollapseShapeOp>(
+            loc, colsType, pack.getResult(0),
+            llvm::SmallVector<mlir::ReassociationIndices>{
+                {0}, {1, 2, 3}, {4, 5}});
+    }
+
+    auto weightsType =
+        mlir::RankedTensorType::get({filters, depth}, elementType);
+    mlir::Value weights = builder.create<mlir::tensor::CollapseShapeOp>(
+        loc, weightsType, filter, flattenTail);
+
+    auto accType =
+        mlir::RankedTensorType::get({batch, filters, pixels}, elementType);
+    mlir::Value acc = builder.create<mlir::tensor::CollapseShapeOp>(
+        loc, accType, init, flattenSpatial);
+
+    mlir::Value result;
+    if (batch == 1) {
+        llvm::SmallVector<mlir::ReassociationIndices> dropBatch = {{0, 1}, {2}};
+        auto cols2Type =
+            mlir::RankedTensorType::get({depth, pixels}, elementType);
+        auto acc2Type =
+            mlir::RankedTensorType::get({filters, pixels}, elementType);
+        mlir::Value cols2 = builder.create<mlir::tensor::CollapseShapeOp>(
+            loc, cols2Type, cols, dropBatch);
+        mlir::Value acc2 = builder.create<mlir::tensor::CollapseShapeOp>(
+            loc, acc2Type, acc, dropBatch);
+        auto matmul = builder.create<mlir::linalg::MatmulOp>(
+            loc, mlir::TypeRange{acc2Type}, mlir::ValueRange{weights, cols2},
+            mlir::ValueRange{acc2});
+        result = builder.create<mlir::tensor::ExpandShapeOp>(
+            loc, accType, matmul.getResult(0), dropBatch);
+    } else {
+        auto n = builder.getAffineDimExpr(0);
+        auto f = builder.getAffineDimExpr(1);
+        auto p = builder.getAffineDimExpr(2);
+        auto k = builder.getAffineDimExpr(3);
+        auto gemm = builder.create<mlir::linalg::GenericOp>(
+            loc,
+            mlir::TypeRange{accType},
+            mlir::ValueRange{weights, cols},
+            mlir::ValueRange{acc},
+            llvm::ArrayRef<mlir::AffineMap>{
+                mlir::AffineMap::get(4, 0, {f, k}, ctx),
+                mlir::AffineMap::get(4, 0, {n, k, p}, ctx),
+                mlir::AffineMap::get(4, 0, {n, f, p}, ctx)},
+            createMixedIterators(4, {3}),
+            buildMulAccBody);
+        result = gemm.getResult(0);
+    }
+
+    return builder.create<mlir::tensor::ExpandShapeOp>(
+        loc, initType, result, flattenSpatial);
+}
+
+// Winograd F(m x m, 3 x 3) transform matrices (Lavin & Gray), row-major:
+// BT is alpha x alpha, G is alpha x 3, AT is m x alpha, alpha = m + 2.
+struct WinogradMatrices {
+    int64_t m;
+    std::vector<float> bt;
+    std::vector<float> g;
+    std::vector<float> at;
+};
+
+WinogradMatrices getWinogradMatrices(Winograd variant) {
+    if (variant == Winograd::f2x2) {
+        return {2,
+                {1, 0, -1, 0,
+                 0, 1, 1, 0,
+                 0, -1, 1, 0,
+                 0, 1, 0, -1},
+                {1, 0, 0,
+                 0.5f, 0.5f, 0.5f,
+                 0.5f, -0.5f, 0.5f,
+                 0, 0, 1},
+                {1, 1, 1, 0,
+                 0, 1, -1, -1}};
+    }
+    return {4,
+            {4, 0, -5, 0, 1, 0,
+             0, -4, -4, 1, 1, 0,
+             0, 4, -4, -1, 1, 0,
+             0, -2, -1, 2, 1, 0,
+             0, 2, -1, -2, 1, 0,
+             0, 4, 0, -5, 0, 1},
+            {1.0f / 4, 0, 0,
+             -1.0f / 6, -1.0f / 6, -1.0f / 6,
+             -1.0f / 6, 1.0f / 6, -1.0f / 6,
+             1.0f / 24, 1.0f / 12, 1.0f / 6,
+             1.0f / 24, -1.0f / 12, 1.0f / 6,
+             0, 0, 1},
+            {1, 1, 1, 1, 1, 0,
+             0, 1, -1, 2, -2, 0,
+             0, 1, 1, 4, 4, 0,
+             0, 1, -1, 8, -8, 1}};
+}
+
+// U[xi, nu, f, c] = (G w[f, c] G^T)[xi, nu], computed once at compile time.
+std::vector<float> transformWinogradFilter(const WinogradMatrices &wm,
+                                           const std::vector<float> &filter,
+                                           int64_t filters, int64_t channels) {
+    const int64_t alpha = wm.m + 2;
+    std::vector<float> u(static_cast<size_t>(alpha * alpha * filters * channels));
+    for (int64_t f = 0; f < filters; ++f) {
+        for (int64_t c = 0; c < channels; ++c) {
+            const float *w = &filter[static_cast<size_t>((f * channels + c) * 9)];
+            double gw[6][3] = {};
+            for (int64_t i = 0; i < alpha; ++i) {
+                for (int64_t j = 0; j < 3; ++j) {
+                    for (int64_t k = 0; k < 3; ++k) {
+                        gw[i][j] += wm.g[i * 3 + k] * w[k * 3 + j];
+                    }
+                }
+            }
+            for (int64_t i = 0; i < alpha; ++i) {
+                for (int64_t j = 0; j < alpha; ++j) {
+                    double value = 0.0;
+                    for (int64_t k = 0; k < 3; ++k) {
+                        value += gw[i][k] * wm.g[j * 3 + k];
+                    }
+                    size_t idx = static_cast<size_t>(
+                        ((i * alpha + j) * filters + f) * channels + c);
+                    u[idx] = static_cast<float>(value);
+                }
+            }
+        }
+    }
+    return u;
+}
+
+mlir::Value genF32Constant(mlir::OpBuilder &builder, mlir::Location loc,
+                           llvm::ArrayRef<int64_t> shape,
+                           const std::vector<float> &data) {
+    auto type = mlir::RankedTensorType::get(shape, builder.getF32Type());
+    return builder.create<mlir::arith::ConstantOp>(
+        loc, type,
+        mlir::DenseElementsAttr::get(type, llvm::ArrayRef<float>(data)));
+}
+
+mlir::Value genZeroFilled(mlir::OpBuilder &builder, mlir::Location loc,
+                          llvm::ArrayRef<int64_t> shape) {
+    auto type = mlir::RankedTensorType::get(shape, builder.getF32Type());
+    auto empty = builder.create<mlir::tensor::EmptyOp>(loc, type,
+                                                       mlir::ValueRange{});
+    auto zero = builder.create<mlir::arith::ConstantOp>(
+        loc, builder.getF32FloatAttr(0.0f));
+    return builder
+        .create<mlir::linalg::FillOp>(loc, mlir::TypeRange{type},
+                                      mlir::ValueRange{zero.getResult()},
+                                      mlir::ValueRange{empty.getResult()})
+        .getResult(0);
+}
+
+// Contraction generic accumulating args[0] * args[1] into the init.
+mlir::Value genContraction(mlir::OpBuilder &builder, mlir::Location loc,
+                           mlir::Value lhs, mlir::Value rhs, mlir::Value init,
+                           llvm::ArrayRef<mlir::AffineMap> maps,
+                           int64_t loops, llvm::ArrayRef<int64_t> reductions) {
+    return builder
+        .create<mlir::linalg::GenericOp>(
+            loc, mlir::TypeRange{init.getType()}, mlir::ValueRange{lhs, rhs},
+            mlir::ValueRange{init}, maps,
+            createMixedIterators(loops, reductions), buildMulAccBody)
+        .getResult(0);
+}
+
+// Winograd convolution of a static NCHW f32 input with a 3x3 filter
+// pre-transformed into U[alpha, alpha, F, C], stride 1, dilation 1. The input is padded so that tH x tW tiles
+// of m x m outputs cover the result, which is cropped at the end:
+//   V = BT d B     (two generics, one per side)
+//   M = U . V      (batched over the alpha x alpha tile positions)
+//   Y = AT M A     (two generics, the second accumulating onto the bias)
+mlir::Value genWinogradConvOp(mlir::OpBuilder &builder, mlir::Location loc,
+                              mlir::Value input, mlir::Value u,
+                              int64_t filters, mlir::Value bias,
+                              llvm::ArrayRef<int64_t> pads, int64_t outH,
+                              int64_t outW, Winograd variant) {
+    const WinogradMatrices wm = getWinogradMatrices(variant);
+    const int64_t m = wm.m;
+    const int64_t alpha = m + 2;
+
+    auto inputType = mlir::cast<mlir::RankedTensorType>(input.getType());
+    auto inShape = inputType.getShape();
+    const int64_t batch = inShape[0];
+    const int64_t channels = inShape[1];
+    const int64_t tilesH = (outH + m - 1) / m;
+    const int64_t tilesW = (outW + m - 1) / m;
+    const int64_t paddedH = tilesH * m + 2;
+    const int64_t paddedW = tilesW * m + 2;
+    auto *ctx = builder.getContext();
+
+    mlir::Value padded = input;
+    const int64_t highH = paddedH - inShape[2] - pads[0];
+    const int64_t highW = paddedW - inShape[3] - pads[1];
+    if (pads[0] != 0 || pads[1] != 0 || highH != 0 || highW != 0) {
+        auto paddedType = mlir::RankedTensorType::get(
+            {batch, channels, paddedH, paddedW}, inputType.getElementType());
+        auto zero = builder.create<mlir::arith::ConstantOp>(
+            loc, builder.getF32FloatAttr(0.0f));
+        std::vector<mlir::OpFoldResult> low = {
+            builder.getIndexAttr(0), builder.getIndexAttr(0),
+            builder.getIndexAttr(pads[0]), builder.getIndexAttr(pads[1])};
+        std::vector<mlir::OpFoldResult> high = {
+            builder.getIndexAttr(0), builder.getIndexAttr(0),
+            builder.getIndexAttr(highH), builder.getIndexAttr(highW)};
+        padded = builder.create<mlir::tensor::PadOp>(
+            loc, paddedType, input, low, high, zero.getResult(), false);
+    }
+
+    mlir::Value bt = genF32Constant(builder, loc, {alpha, alpha}, wm.bt);
+    mlir::Value at = genF32Constant(builder, loc, {m, alpha}, wm.at);
+
+    auto d = [&](unsigned i) { return builder.getAffineDimExpr(i); };
+    auto map = [&](unsigned loops, llvm::ArrayRef<mlir::AffineExpr> exprs) {
+        return mlir::AffineMap::get(loops, 0, exprs, ctx);
+    };
+
+    // T1[xi, n, c, th, tw, b] = sum_a BT[xi, a] * d[n, c, th*m + a, tw*m + b]
+    // loops (xi, n, c, th, tw, b, a)
+    mlir::Value t1 = genContraction(
+        builder, loc, bt, padded,
+        genZeroFilled(builder, loc, {alpha, batch, channels, tilesH, tilesW, alpha}),
+        {map(7, {d(0), d(6)}),
+         map(7, {d(1), d(2), d(3) * m + d(6), d(4) * m + d(5)}),
+         map(7, {d(0), d(1), d(2), d(3), d(4), d(5)})},
+        7, {6});
+
+    // V[xi, nu, n, c, th, tw] = sum_b T1[xi, n, c, th, tw, b] * BT[nu, b]
+    // loops (xi, nu, n, c, th, tw, b)
+    mlir::Value v = genContraction(
+        builder, loc, t1, bt,
+        genZeroFilled(builder, loc, {alpha, alpha, batch, channels, tilesH, tilesW}),
+        {map(7, {d(0), d(2), d(3), d(4), d(5), d(6)}),
+         map(7, {d(1), d(6)}),
+         map(7, {d(0), d(1), d(2), d(3), d(4), d(5)})},
+        7, {6});
+
+    // M[xi, nu, n, f, th, tw] = sum_c U[xi, nu, f, c] * V[xi, nu, n, c, th, tw]
+    // loops (xi, nu, n, f, th, tw, c)
+    mlir::Value mm = genContraction(
+        builder, loc, u, v,
+        genZeroFilled(builder, loc, {alpha, alpha, batch, filters, tilesH, tilesW}),
+        {map(7, {d(0), d(1), d(3), d(6)}),
+         map(7, {d(0), d(1), d(2), d(6), d(4), d(5)}),
+         map(7, {d(0), d(1), d(2), d(3), d(4), d(5)})},
+        7, {6});
+
+    // O1[i, nu, n, f, th, tw] = sum_xi AT[i, xi] * M[xi, nu, n, f, th, tw]
+    // loops (i, nu, n, f, th, tw, xi)
+    mlir::Value o1 = genContraction(
+        builder, loc, at, mm,
+        genZeroFilled(builder, loc, {m, alpha, batch, filters, tilesH, tilesW}),
+        {map(7, {d(0), d(6)}),
+         map(7, {d(6), d(1), d(2), d(3), d(4), d(5)}),
+         map(7, {d(0), d(1), d(2), d(3), d(4), d(5)})},
+        7, {6});
+
+    // Y[n, f, th, i, tw, j] = bias[f] + sum_nu O1[i, nu, n, f, th, tw] * AT[j, nu]
+    // loops (n, f, th, i, tw, j, nu)
+    llvm::SmallVector<int64_t> yShape = {batch, filters, tilesH, m, tilesW, m};
+    mlir::Value yInit;
+    if (bias) {
+        auto yType = mlir::RankedTensorType::get(yShape, builder.getF32Type());
+        auto empty = builder.create<mlir::tensor::EmptyOp>(loc, yType,
+                                                           mlir::ValueRange{});
+        yInit = builder
+                    .create<mlir::linalg::GenericOp>(
+                        loc, mlir::TypeRange{yType}, mlir::ValueRange{bias},
+                        mlir::ValueRange{empty.getResult()},
+                        llvm::ArrayRef<mlir::AffineMap>{
+                            map(6, {d(1)}),
+                            map(6, {d(0), d(1), d(2), d(3), d(4), d(5)})},
+                        createParallelIterators(6),
+                        [](mlir::OpBuilder &b, mlir::Location l,
+                           mlir::ValueRange args) {
+                            b.create<mlir::linalg::YieldOp>(l, args[0]);
+                        })
+                    .getResult(0);
+    } else {
+        yInit = genZeroFilled(builder, loc, yShape);
+    }
+    mlir::Value y = genContraction(
+        builder, loc, o1, at, yInit,
+        {map(7, {d(3), d(6), d(0), d(1), d(2), d(4)}),
+         map(7, {d(5), d(6)}),
+         map(7, {d(0), d(1), d(2), d(3), d(4), d(5)})},
+        7, {6});
+
+    auto fullType = mlir::RankedTensorType::get(
+        {batch, filters, tilesH * m, tilesW * m}, builder.getF32Type());
+    mlir::Value full = builder.create<mlir::tensor::CollapseShapeOp>(
+        loc, fullType, y,
+        llvm::SmallVector<mlir::ReassociationIndices>{{0}, {1}, {2, 3}, {4, 5}});
+    if (tilesH * m == outH && tilesW * m == outW) {
+        return full;
+    }
+
+    auto outType = mlir::RankedTensorType::get({batch, filters, outH, outW},
+                                               builder.getF32Type());
+    llvm::SmallVector<mlir::OpFoldResult> offsets(4, builder.getIndexAttr(0));
+    llvm::SmallVector<mlir::OpFoldResult> sizes = {
+        builder.getIndexAttr(batch), builder.getIndexAttr(filters),
+        builder.getIndexAttr(outH), builder.getIndexAttr(outW)};
+    llvm::SmallVector<mlir::OpFoldResult> unitStrides(4,
+                                                      builder.getIndexAttr(1));
+    return builder.create<mlir::tensor::ExtractSliceOp>(
+        loc, outType, full, offsets, sizes, unitStrides);
+}
+
+// Graph shape inference (inferShapes) may know dimensions the op builders
+// left dynamic, e.g. behind a Reshape with a constant shape. Casting the
+// results to the inferred static type keeps later nodes free of tensor.dim.
+void castToInferredTypes(
+    mlir::OpBuilder &builder, mlir::Location loc, const Graph &graph,
+    const Node &node, Codegen::Values &values) {
+    for (TensorId id : node.outputIds()) {
+        const Tensor *tensor = graph.tensor(id);
+        if (!tensor || tensor->type() == onnx::TensorProto_DataType_UNDEFINED ||
+            id >= values.size() || !values[id]) {
+            continue;
+        }
+        auto type = mlir::dyn_cast<mlir::RankedTensorType>(values[id].getType());
+        if (!type ||
+            static_cast<size_t>(type.getRank()) != tensor->shape().size()) {
+            continue;
+        }
+
+        llvm::SmallVector<int64_t> shape(type.getShape());
+        for (auto [dim, inferred] : llvm::zip(shape, tensor->shape())) {
+            if (mlir::ShapedType::isDynamic(dim)) {
+                dim = inferred;
+            } else if (!mlir::ShapedType::isDynamic(inferred) &&
+                       dim != inferred) {
+                throw std::runtime_error("generated shape of '" +
+                                         tensor->name() +
+                                         "' contradicts shape inference");
+            }
+        }
+        if (llvm::ArrayRef<int64_t>(shape) == type.getShape()) {
+            continue;
+        }
+        values[id] = builder.create<mlir::tensor::CastOp>(
+            loc, mlir::RankedTensorType::get(shape, type.getElementType()),
+            values[id]);
+    }
+}
+
 } // namespace
 
-Codegen::Codegen(mlir::MLIRContext &context) : context_(context) {}
+Codegen::Codegen(mlir::MLIRContext &context, const CodegenOptions &options)
+    : context_(context), options_(options) {}
 
 mlir::MLIRContext &Codegen::getContext() noexcept { return context_; }
 
@@ -381,23 +999,26 @@ mlir::OwningOpRef<mlir::ModuleOp> Codegen::generate(const Graph &graph) {
     auto func = mlir::func::FuncOp::create(loc, ENTRY_FUNC_NAME, funcType);
     func.setPublic();
 
+    module.push_back(func);
+    weights_.clear();
+
     mlir::Block *entryBlock = func.addEntryBlock();
     builder.setInsertionPointToStart(entryBlock);
-    std::unordered_map<std::string, mlir::Value> values;
+    Values values(graph.tensorIdCount());
 
     bindRawPointerInputs(graph, entryBlock, builder, loc, values);
     genConstants(builder, loc, graph, values);
     genNodes(builder, loc, graph, values);
 
-    size_t outArgOffset = graph.inputs().size();
-    for (size_t i = 0; i < graph.outputs().size(); ++i) {
-        const std::string &outName = graph.outputs()[i];
-        auto it = values.find(outName);
-        if (it == values.end()) {
-            throw std::runtime_error("output not computed: " + outName);
+    size_t outArgOffset = graph.inputIds().size();
+    for (size_t i = 0; i < graph.outputIds().size(); ++i) {
+        const TensorId outId = graph.outputIds()[i];
+        mlir::Value computedTensor = lookupValue(values, outId);
+        if (!computedTensor) {
+            throw std::runtime_error("output not computed: " +
+                                     graph.tensorName(outId));
         }
 
-        mlir::Value computedTensor = it->second;
         mlir::Value outBuffer = entryBlock->getArgument(outArgOffset + i);
         builder.create<mlir::bufferization::MaterializeInDestinationOp>(
             loc, mlir::Type(), computedTensor, outBuffer,
@@ -407,10 +1028,13 @@ mlir::OwningOpRef<mlir::ModuleOp> Codegen::generate(const Graph &graph) {
     builder.create<mlir::func::ReturnOp>(loc,
         builder.create<mlir::arith::ConstantOp>(loc, i32Type, builder.getI32IntegerAttr(0)).getResult());
 
-    module.push_back(func);
     return module;
 }
 
+const WeightsBlob &Codegen::weights() const noexcept {
+    return weights_;
+}
+
 mlir::Type Codegen::convertElementType(int onnx_type) const {
     switch (onnx_type) {
     case onnx::TensorProto_DataType_FLOAT:
@@ -439,11 +1063,12 @@ Codegen::convertTensorType(const Tensor &tensor) const {
 
 std::vector<mlir::Type> Codegen::buildInputTypes(const Graph &graph) const {
     std::vector<mlir::Type> inputTypes;
-    inputTypes.reserve(graph.inputs().size());
-    for (const std::string &name : graph.inputs()) {
-        const Tensor *tensor = graph.tensor(name);
+    inputTypes.reserve(graph.inputIds().size());
+    for (TensorId id : graph.inputIds()) {
+        const Tensor *tensor = graph.tensor(id);
         if (!tensor) {
-            throw std::runtime_error("input tensor not found: " + name);
+            throw std::runtime_error("input tensor not found: " +
+                                     graph.tensorName(id));
         }
         auto tensorType = convertTensorType(*tensor);
         inputTypes.push_back(mlir::MemRefType::get(
@@ -454,11 +1079,12 @@ std::vector<mlir::Type> Codegen::buildInputTypes(const Graph &graph) const {
 
 std::vector<mlir::Type> Codegen::buildResultTypes(const Graph &graph) const {
     std::vector<mlir::Type> resultTypes;
-    resultTypes.reserve(graph.outputs().size());
-    for (const std::string &name : graph.outputs()) {
-        const Tensor *tensor = graph.tensor(name);
+    resultTypes.reserve(graph.outputIds().size());
+    for (TensorId id : graph.outputIds()) {
+        const Tensor *tensor = graph.tensor(id);
         if (!tensor) {
-            throw std::runtime_error("output tensor not found: " + name);
+            throw std::runtime_error("output tensor not found: " +
+                                     graph.tensorName(id));
         }
         auto tensorType = convertTensorType(*tensor);
         resultTypes.push_back(mlir::MemRefType::get(
@@ -472,28 +1098,29 @@ void Codegen::bindRawPointerInputs(
     mlir::Block *entryBlock,
     mlir::OpBuilder &builder,
     mlir::Location loc,
-    std::unordered_map<std::string, mlir::Value> &values) {
+    Values &values) {
 
-    auto bindOne = [&](size_t argIdx, const std::string &name, const Tensor *tensor) {
-        if (!tensor) {
-            throw std::runtime_error("tensor not found: " + name);
+    auto bindOne = [&](size_t argIdx, TensorId id) {
+        if (!graph.tensor(id)) {
+            throw std::runtime_error("tensor not found: " + graph.tensorName(id));
         }
         mlir::Value memref = entryBlock->getArgument(argIdx);
-        values[name] = builder.create<mlir::bufferization::ToTensorOp>(
+        values[id] = builder.create<mlir::bufferization::ToTensorOp>(
             loc, memref, /*restrict=*/true, /*writable=*/false);
     };
 
-    for (size_t i = 0; i < graph.inputs().size(); ++i) {
-        bindOne(i, graph.inputs()[i], graph.tensor(graph.inputs()[i]));
+    for (size_t i = 0; i < graph.inputIds().size(); ++i) {
+        bindOne(i, graph.inputIds()[i]);
     }
 }
 
 std::vector<mlir::Value> Codegen::collectReturnValues(
     const Graph &graph,
-    const std::unordered_map<std::string, mlir::Value> &values) const {
-    for (const auto &outputName : graph.outputs()) {
-        if (values.find(outputName) == values.end()) {
-            throw std::runtime_error("output not bound: " + outputName);
+    const Values &values) const {
+    for (TensorId id : graph.outputIds()) {
+        if (!lookupValue(values, id)) {
+            throw std::runtime_error("output not bound: " +
+                                     graph.tensorName(id));
         }
     }
     return {};
@@ -503,130 +1130,118 @@ void Codegen::genNodes(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Graph &graph,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     for (const auto &node : graph.nodes()) {
         genNode(builder, loc, node, graph, values);
+        castToInferredTypes(builder, loc, graph, node, values);
     }
 }
 
+std::vector<Codegen::NodeHandler> &Codegen::handlers() {
+    using Emit = void (Codegen::*)(mlir::OpBuilder &, mlir::Location,
+                                   const Node &, Values &) const;
+    using EmitWithGraph = void (Codegen::*)(mlir::OpBuilder &, mlir::Location,
+                                            const Graph &, const Node &,
+                                            Values &) const;
+
+    static std::vector<NodeHandler> table = [] {
+        std::vector<NodeHandler> builtins;
+        auto set = [&builtins](std::string_view opcode, NodeHandler handler) {
+            const OpId id = OpRegistry::instance().intern(opcode);
+            if (builtins.size() <= id) {
+                builtins.resize(id + 1);
+            }
+            builtins[id] = std::move(handler);
+        };
+        auto add = [&set](std::string_view opcode, Emit emit) {
+            set(opcode, [emit](const Codegen &codegen, mlir::OpBuilder &builder,
+                               mlir::Location loc, const Graph &,
+                               const Node &node, Values &values) {
+                (codegen.*emit)(builder, loc, node, values);
+            });
+        };
+        auto addWithGraph = [&set](std::string_view opcode,
+                                   EmitWithGraph emit) {
+            set(opcode, [emit](const Codegen &codegen, mlir::OpBuilder &builder,
+                               mlir::Location loc, const Graph &graph,
+                               const Node &node, Values &values) {
+                (codegen.*emit)(builder, loc, graph, node, values);
+            });
+        };
+
+        add("Mul", &Codegen::genMulNode);
+        add("Add", &Codegen::genAddNode);
+        add("Identity", &Codegen::genIdentityNode);
+        add("Sub", &Codegen::genSubNode);
+        add("Div", &Codegen::genDivNode);
+        add("Relu", &Codegen::genReluNode);
+        addWithGraph("Conv", &Codegen::genConvNode);
+        addWithGraph("BatchNormalization", &Codegen::genBatchNormalizationNode);
+        add("MaxPool", &Codegen::genMaxPoolNode);
+        add("ReduceMean", &Codegen::genReduceMeanNode);
+        addWithGraph("Reshape", &Codegen::genReshapeNode);
+        addWithGraph("Squeeze", &Codegen::genSqueezeNode);
+        add("MatMul", &Codegen::genMatMulNode);
+        add("Softmax", &Codegen::genSoftmaxNode);
+        add("ArgMax", &Codegen::genArgMaxNode);
+        return builtins;
+    }();
+    return table;
+}
+
+void Codegen::registerHandler(std::string_view opcode, NodeHandler handler) {
+    std::vector<NodeHandler> &table = handlers();
+    const OpId id = OpRegistry::instance().intern(opcode);
+    if (table.size() <= id) {
+        table.resize(id + 1);
+    }
+    table[id] = std::move(handler);
+}
+
 void Codegen::genNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Node &node,
     const Graph &graph,
-    std::unordered_map<std::string, mlir::Value> &values) const {
-
-    const std::string &opcode = node.opcode();
+    Values &values) const {
 
-    if (opcode == "Mul") {
-        genMulNode(builder, loc, node, values);
-        return;
-    }
-
-    if (opcode == "Add") {
-        genAddNode(builder, loc, node, values);
-        return;
-    }
-
-    if (opcode == "Identity") {
-        genIdentityNode(builder, loc, node, values);
-        return;
-    }
-
-    if (opcode == "Sub") {
-        genSubNode(builder, loc, node, values);
-        return;
-    }
-
-    if (opcode == "Div") {
-        genDivNode(builder, loc, node, values);
-        return;
-    }
-
-    if (opcode == "Relu") {
-        genReluNode(builder, loc, node, values);
-        return;
-    }
-
-    if (opcode == "Conv") {
-        genConvNode(builder, loc, graph, node, values);
-        return;
-    }
-
-    if (opcode == "BatchNormalization") {
-        genBatchNormalizationNode(builder, loc, node, values);
-        return;
-    }
-
-    if (opcode == "MaxPool") {
-        genMaxPoolNode(builder, loc, node, values);
-        return;
-    }
-
-    if (opcode == "ReduceMean") {
-        genReduceMeanNode(builder, loc, node, values);
-        return;
+    const std::vector<NodeHandler> &table = handlers();
+    const OpId id = node.opId();
+    if (id >= table.size() || !table[id]) {
+        throw std::runtime_error("unsupported opcode: " + node.opcode());
     }
-
-    if (opcode == "Reshape") {
-        genReshapeNode(builder, loc, node, values);
-        return;
-    }
-
-    if (opcode == "Squeeze") {
-        genSqueezeNode(builder, loc, graph, node, values);
-        return;
-    }
-
-    if (opcode == "MatMul") {
-        genMatMulNode(builder, loc, node, values);
-        return;
-    }
-
-    if (opcode == "Softmax") {
-        genSoftmaxNode(builder, loc, node, values);
-        return;
-    }
-
-    if (opcode == "ArgMax") {
-        genArgMaxNode(builder, loc, node, values);
-        return;
-    }
-
-    throw std::runtime_error("unsupported opcode: " + opcode);
+    table[id](*this, builder, loc, graph, node, values);
 }
 
 void Codegen::genMulNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     checkBinaryNodeShape(node, "Mul");
 
-    const std::string &lhsName = node.inputs()[0];
-    const std::string &rhsName = node.inputs()[1];
-    const std::string &outName = node.outputs()[0];
+    const TensorId outId = node.outputIds()[0];
 
-    mlir::Value lhs = getBoundValue(values, lhsName, "Mul");
-    mlir::Value rhs = getBoundValue(values, rhsName, "Mul");
+    mlir::Value lhs = getBoundValue(values, node, 0, "Mul");
+    mlir::Value rhs = getBoundValue(values, node, 1, "Mul");
 
     auto mulOp = builder.create<mlir::arith::MulFOp>(loc, lhs, rhs);
-    values[outName] = mulOp.getResult();
+    values[outId] = mulOp.getResult();
 }
 
 void Codegen::genAddNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     checkBinaryNodeShape(node, "Add");
-    const std::string &outName = node.outputs()[0];
+    const TensorId outId = node.outputIds()[0];
 
-    mlir::Value lhs = getBoundValue(values, node.inputs()[0], "Add");
-    mlir::Value rhs = getBoundValue(values, node.inputs()[1], "Add");
+    mlir::Value lhs = getBoundValue(values, node, 0, "Add");
+    mlir::Value rhs = getBoundValue(values, node, 1, "Add");
 
     auto lhsType = mlir::dyn_cast<mlir::RankedTensorType>(lhs.getType());
     auto rhsType = mlir::dyn_cast<mlir::RankedTensorType>(rhs.getType());
@@ -635,7 +1250,7 @@ void Codegen::genAddNode(
     }
 
     if (lhsType == rhsType) {
-        values[outName] = builder.create<mlir::arith::AddFOp>(loc, lhs, rhs).getResult();
+        values[outId] = builder.create<mlir::arith::AddFOp>(loc, lhs, rhs).getResult();
         return;
     }
 
@@ -645,7 +1260,76 @@ void Codegen::genAddNode(
     auto lhsMap = createBroadcastAffineMap(builder, lhsType.getShape(), resultType.getRank());
     auto rhsMap = createBroadcastAffineMap(builder, rhsType.getShape(), resultType.getRank());
 
-    values[outName] = genBroadcastAddOp(builder, loc, lhs, rhs, resultType, lhsMap, rhsMap);
+    values[outId] = genBroadcastAddOp(builder, loc, lhs, rhs, resultType, lhsMap, rhsMap);
+}
+
+mlir::Value Codegen::genWeights(
+    mlir::OpBuilder &builder,
+    mlir::Location loc,
+    mlir::RankedTensorType type,
+    std::string_view bytes,
+    bool bytesOutliveModule) const {
+
+    if (!options_.externalWeights || bytes.size() < kMinExternalWeightBytes ||
+        !type.hasStaticShape()) {
+        return genInlineConstant(builder, loc, type, bytes,
+                                 bytesOutliveModule);
+    }
+
+    // External constant global: only the declaration is in the module, the
+    // bytes come from the blob section at link time.
+    const std::string &symbol = weights_.append(bytes);
+    auto memrefType =
+        mlir::MemRefType::get(type.getShape(), type.getElementType());
+    auto module = builder.getInsertionBlock()
+                      ->getParentOp()
+                      ->getParentOfType<mlir::ModuleOp>();
+    auto moduleBuilder = mlir::OpBuilder::atBlockBegin(module.getBody());
+    moduleBuilder.create<mlir::memref::GlobalOp>(
+        loc, symbol, /*sym_visibility=*/mlir::StringAttr{}, memrefType,
+        /*initial_value=*/mlir::Attribute{}, /*constant=*/true,
+        builder.getI64IntegerAttr(static_cast<int64_t>(kWeightsAlignment)));
+
+    auto global =
+        builder.create<mlir::memref::GetGlobalOp>(loc, memrefType, symbol);
+    auto tensor = builder.create<mlir::bufferization::ToTensorOp>(
+        loc, global.getResult(), /*restrict=*/true, /*writable=*/false);
+    return tensor.getResult();
+}
+
+mlir::Value Codegen::genInlineConstant(
+    mlir::OpBuilder &builder,
+    mlir::Location loc,
+    mlir::RankedTensorType type,
+    std::string_view bytes,
+    bool bytesOutliveModule) const {
+
+    llvm::ArrayRef<char> raw(bytes.data(), bytes.size());
+    if (bytes.size() < kMinExternalWeightBytes || !type.hasStaticShape()) {
+        auto attr = mlir::DenseElementsAttr::getFromRawBuffer(type, raw);
+        return builder.create<mlir::arith::ConstantOp>(loc, type, attr)
+            .getResult();
+    }
+
+    // A resource blob is not hashed or uniqued by the context. Graph bytes
+    // (the mapped model file or a folded constant) are viewed in place,
+    // so the Graph must outlive the module. raw_data has no alignment
+    // guarantee and the blob is read as elements, so misaligned bytes and
+    // temporaries are copied once into the blob instead.
+    const size_t alignment = std::max<size_t>(
+        1, type.getElementType().getIntOrFloatBitWidth() / 8);
+    const bool aligned =
+        reinterpret_cast<uintptr_t>(bytes.data()) % alignment == 0;
+    mlir::AsmResourceBlob blob =
+        bytesOutliveModule && aligned
+            ? mlir::UnmanagedAsmResourceBlob::allocateWithAlign(raw,
+                                                                alignment)
+            : mlir::HeapAsmResourceBlob::allocateAndCopyWithAlign(
+                  raw, alignment);
+    auto attr = mlir::DenseResourceElementsAttr::get(
+        type, "tensor_compiler.weight", std::move(blob));
+    return builder.create<mlir::arith::ConstantOp>(loc, type, attr)
+        .getResult();
 }
 
 mlir::Value Codegen::genConstantTensor(
@@ -667,13 +1351,8 @@ mlir::Value Codegen::genConstantTensor(
                 "constant tensor raw data size does not match shape");
         }
 
-        std::vector<float> data(elementCount);
-        std::memcpy(data.data(), raw.data(), raw.size());
-
-        auto attr =
-            mlir::DenseElementsAttr::get(type, llvm::ArrayRef<float>(data));
-        auto cst = builder.create<mlir::arith::ConstantOp>(loc, type, attr);
-        return cst.getResult();
+        return genWeights(builder, loc, type, raw,
+                          /*bytesOutliveModule=*/true);
     }
 
     if (tensor.type() == onnx::TensorProto_DataType_INT64) {
@@ -682,13 +1361,8 @@ mlir::Value Codegen::genConstantTensor(
                 "constant tensor raw data size does not match shape");
         }
 
-        std::vector<int64_t> data(elementCount);
-        std::memcpy(data.data(), raw.data(), raw.size());
-
-        auto attr = mlir::DenseIntElementsAttr::get(
-            mlir::cast<mlir::ShapedType>(type), llvm::ArrayRef<int64_t>(data));
-        auto cst = builder.create<mlir::arith::ConstantOp>(loc, type, attr);
-        return cst.getResult();
+        return genInlineConstant(builder, loc, type, raw,
+                                 /*bytesOutliveModule=*/true);
     }
 
     throw std::runtime_error("unsupported constant tensor element type");
@@ -698,14 +1372,15 @@ void Codegen::genConstants(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Graph &graph,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
-    for (const auto &[name, tensor] : graph.tensors()) {
-        if (!tensor.isConstant()) {
+    for (TensorId id = 0; id < graph.tensorIdCount(); ++id) {
+        const Tensor *tensor = graph.tensor(id);
+        if (!tensor || !tensor->isConstant()) {
             continue;
         }
 
-        values[name] = genConstantTensor(builder, loc, tensor);
+        values[id] = genConstantTensor(builder, loc, *tensor);
     }
 }
 
@@ -713,69 +1388,63 @@ void Codegen::genIdentityNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     (void)builder;
     (void)loc;
 
     checkUnaryNodeShape(node, "Identity");
 
-    const std::string &inName = node.inputs()[0];
-    const std::string &outName = node.outputs()[0];
+    const TensorId outId = node.outputIds()[0];
 
-    values[outName] = getBoundValue(values, inName, "Identity");
+    values[outId] = getBoundValue(values, node, 0, "Identity");
 }
 
 void Codegen::genSubNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     checkBinaryNodeShape(node, "Sub");
 
-    const std::string &lhsName = node.inputs()[0];
-    const std::string &rhsName = node.inputs()[1];
-    const std::string &outName = node.outputs()[0];
+    const TensorId outId = node.outputIds()[0];
 
-    mlir::Value lhs = getBoundValue(values, lhsName, "Sub");
-    mlir::Value rhs = getBoundValue(values, rhsName, "Sub");
+    mlir::Value lhs = getBoundValue(values, node, 0, "Sub");
+    mlir::Value rhs = getBoundValue(values, node, 1, "Sub");
 
     auto subOp = builder.create<mlir::arith::SubFOp>(loc, lhs, rhs);
-    values[outName] = subOp.getResult();
+    values[outId] = subOp.getResult();
 }
 
 void Codegen::genDivNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     checkBinaryNodeShape(node, "Div");
 
-    const std::string &lhsName = node.inputs()[0];
-    const std::string &rhsName = node.inputs()[1];
-    const std::string &outName = node.outputs()[0];
+    const TensorId outId = node.outputIds()[0];
 
-    mlir::Value lhs = getBoundValue(values, lhsName, "Div");
-    mlir::Value rhs = getBoundValue(values, rhsName, "Div");
+    mlir::Value lhs = getBoundValue(values, node, 0, "Div");
+    mlir::Value rhs = getBoundValue(values, node, 1, "Div");
 
     auto divOp = builder.create<mlir::arith::DivFOp>(loc, lhs, rhs);
-    values[outName] = divOp.getResult();
+    values[outId] = divOp.getResult();
 }
 
 void Codegen::genReluNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     checkUnaryNodeShape(node, "Relu");
 
-    const std::string &inName = node.inputs()[0];
-    const std::string &outName = node.outputs()[0];
+    const TensorId outId = node.outputIds()[0];
 
-    mlir::Value input = getBoundValue(values, inName, "Relu");
+    mlir::Value input = getBoundValue(values, node, 0, "Relu");
     auto type = mlir::dyn_cast<mlir::RankedTensorType>(input.getType());
 
     if (!type) {
@@ -818,7 +1487,7 @@ void Codegen::genReluNode(
                 nestedLoc, max.getResult());
         });
 
-    values[outName] = relu.getResult(0);
+    values[outId] = relu.getResult(0);
 }
 
 void Codegen::genConvNode(
@@ -826,7 +1495,7 @@ void Codegen::genConvNode(
     mlir::Location loc,
     const Graph &graph,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     if (node.inputs().size() < 2 || node.inputs().size() > 3) {
         throw std::runtime_error("Conv node must have 2 or 3 inputs");
@@ -834,16 +1503,15 @@ void Codegen::genConvNode(
     if (node.outputs().size() != 1) {
         throw std::runtime_error("Conv node must have exactly 1 output");
     }
-    const std::string &inputName = node.inputs()[0];
     const std::string &filterName = node.inputs()[1];
-    const std::string &outName = node.outputs()[0];
+    const TensorId outId = node.outputIds()[0];
     bool hasBias = node.inputs().size() == 3 && !node.inputs()[2].empty();
 
-    mlir::Value input = getBoundValue(values, inputName, "Conv");
-    mlir::Value filter = getBoundValue(values, filterName, "Conv");
+    mlir::Value input = getBoundValue(values, node, 0, "Conv");
+    mlir::Value filter = getBoundValue(values, node, 1, "Conv");
     mlir::Value bias;
     if (hasBias) {
-        bias = getBoundValue(values, node.inputs()[2], "Conv");
+        bias = getBoundValue(values, node, 2, "Conv");
     }
 
     auto inputType =
@@ -879,8 +1547,8 @@ void Codegen::genConvNode(
     }
 
     int64_t group = getIntAttribute(node, "group", 1);
-    if (group != 1) {
-        throw std::runtime_error("Conv group != 1 is not supported yet");
+    if (group <= 0) {
+        throw std::runtime_error("Conv group must be positive");
     }
 
     auto strides = getIntVectorAttribute(node, "strides", {1, 1});
@@ -903,7 +1571,11 @@ void Codegen::genConvNode(
     int64_t kernelH = checkedPositiveDim(filterShape[2], "kernel height");
     int64_t kernelW = checkedPositiveDim(filterShape[3], "kernel width");
 
-    if (channels != filterChannels) {
+    if (channels % group != 0 || filters % group != 0) {
+        throw std::runtime_error(
+            "Conv channels and filters must be divisible by group");
+    }
+    if (channels != filterChannels * group) {
         throw std::runtime_error("Conv input/filter channel mismatch");
     }
     if (hasBias && !mlir::ShapedType::isDynamic(biasType.getShape()[0]) &&
@@ -947,6 +1619,32 @@ void Codegen::genConvNode(
         throw std::runtime_error("Conv computed non-positive output shape");
     }
 
+    if (options_.winograd != Winograd::none && group == 1 &&
+        kernelH == 3 && kernelW == 3 && strideH == 1 && strideW == 1 &&
+        dilationH == 1 && dilationW == 1 && inputShape[0] > 0 &&
+        filterTensor->isConstant()) {
+        auto filterData =
+            readFilterConstant(graph, filterName, filters * channels * 9);
+        if (filterData) {
+            const WinogradMatrices wm = getWinogradMatrices(options_.winograd);
+            const int64_t alpha = wm.m + 2;
+            std::vector<float> transformed =
+                transformWinogradFilter(wm, *filterData, filters, channels);
+            mlir::Value u = genWeights(
+                builder, loc,
+                mlir::RankedTensorType::get({alpha, alpha, filters, channels},
+                                            builder.getF32Type()),
+                std::string_view(
+                    reinterpret_cast<const char *>(transformed.data()),
+                    transformed.size() * sizeof(float)),
+                /*bytesOutliveModule=*/false);
+            values[outId] = genWinogradConvOp(
+                builder, loc, input, u, filters, bias, pads, outH, outW,
+                options_.winograd);
+            return;
+        }
+    }
+
     mlir::Value convInput = input;
     if (hasPadding(pads)) {
         std::vector<int64_t> paddedShape(inputShape.begin(), inputShape.end());
@@ -1023,6 +1721,27 @@ void Codegen::genConvNode(
         init = filled.getResult(0);
     }
 
+    const bool pointwise = kernelH == 1 && kernelW == 1 && strideH == 1 &&
+                           strideW == 1 && !hasPadding(pads);
+    if (group == 1 &&
+        preferIm2Col(options_.convLowering, pointwise, inputShape[0],
+                     channels * kernelH * kernelW, outH * outW)) {
+        values[outId] = genIm2ColConvOp(builder, loc, convInput, filter,
+                                          init, pointwise, strides, dilations);
+        return;
+    }
+
+    if (group == channels && filters == channels) {
+        values[outId] = genDepthwiseConvOp(builder, loc, convInput, filter,
+                                             init, strides, dilations);
+        return;
+    }
+    if (group != 1) {
+        values[outId] = genGroupedConvOp(builder, loc, convInput, filter,
+                                           init, group, strides, dilations);
+        return;
+    }
+
     auto conv = builder.create<mlir::linalg::Conv2DNchwFchwOp>(
         loc,
         mlir::TypeRange{outType},
@@ -1031,14 +1750,15 @@ void Codegen::genConvNode(
         getI64VectorAttr(builder, strides),
         getI64VectorAttr(builder, dilations));
 
-    values[outName] = conv.getResult(0);
+    values[outId] = conv.getResult(0);
 }
 
 void Codegen::genBatchNormalizationNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
+    const Graph &graph,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     if (node.inputs().size() != 5) {
         throw std::runtime_error(
@@ -1053,16 +1773,11 @@ void Codegen::genBatchNormalizationNode(
             "BatchNormalization training_mode is not supported");
     }
 
-    mlir::Value input = getBoundValue(values, node.inputs()[0],
-                                      "BatchNormalization");
-    mlir::Value scale = getBoundValue(values, node.inputs()[1],
-                                      "BatchNormalization");
-    mlir::Value bias = getBoundValue(values, node.inputs()[2],
-                                     "BatchNormalization");
-    mlir::Value mean = getBoundValue(values, node.inputs()[3],
-                                     "BatchNormalization");
-    mlir::Value var = getBoundValue(values, node.inputs()[4],
-                                    "BatchNormalization");
+    mlir::Value input = getBoundValue(values, node, 0, "BatchNormalization");
+    mlir::Value scale = getBoundValue(values, node, 1, "BatchNormalization");
+    mlir::Value bias = getBoundValue(values, node, 2, "BatchNormalization");
+    mlir::Value mean = getBoundValue(values, node, 3, "BatchNormalization");
+    mlir::Value var = getBoundValue(values, node, 4, "BatchNormalization");
 
     auto inputType =
         mlir::dyn_cast<mlir::RankedTensorType>(input.getType());
@@ -1092,12 +1807,63 @@ void Codegen::genBatchNormalizationNode(
     auto tensorMap = mlir::AffineMap::get(4, 0, {n, c, h, w}, ctx);
     auto channelMap = mlir::AffineMap::get(4, 0, {c}, ctx);
 
-    llvm::SmallVector<mlir::AffineMap> indexingMaps = {
-        tensorMap, channelMap, channelMap, channelMap, channelMap, tensorMap};
     llvm::SmallVector<mlir::utils::IteratorType> iteratorTypes(
         4, mlir::utils::IteratorType::parallel);
 
     float epsilon = getFloatAttribute(node, "epsilon", 1.0e-5f);
+
+    // With constant parameters the normalization collapses to a per-channel
+    // y = x * s + t, computed here instead of per element at runtime.
+    auto scaleData = readChannelConstant(graph, node.inputs()[1], channels);
+    auto biasData = readChannelConstant(graph, node.inputs()[2], channels);
+    auto meanData = readChannelConstant(graph, node.inputs()[3], channels);
+    auto varData = readChannelConstant(graph, node.inputs()[4], channels);
+    if (scaleData && biasData && meanData && varData) {
+        std::vector<float> channelScale(static_cast<size_t>(channels));
+        std::vector<float> channelShift(static_cast<size_t>(channels));
+        for (size_t i = 0; i < channelScale.size(); ++i) {
+            double s = (*scaleData)[i] /
+                       std::sqrt(static_cast<double>((*varData)[i]) + epsilon);
+            channelScale[i] = static_cast<float>(s);
+            channelShift[i] =
+                static_cast<float>((*biasData)[i] - (*meanData)[i] * s);
+        }
+
+        auto channelType =
+            mlir::RankedTensorType::get({channels}, builder.getF32Type());
+        auto scaleCst = builder.create<mlir::arith::ConstantOp>(
+            loc, channelType,
+            mlir::DenseElementsAttr::get(
+                channelType, llvm::ArrayRef<float>(channelScale)));
+        auto shiftCst = builder.create<mlir::arith::ConstantOp>(
+            loc, channelType,
+            mlir::DenseElementsAttr::get(
+                channelType, llvm::ArrayRef<float>(channelShift)));
+
+        auto affine = builder.create<mlir::linalg::GenericOp>(
+            loc,
+            mlir::TypeRange{inputType},
+            mlir::ValueRange{input, scaleCst.getResult(), shiftCst.getResult()},
+            mlir::ValueRange{empty.getResult()},
+            llvm::ArrayRef<mlir::AffineMap>{tensorMap, channelMap, channelMap,
+                                            tensorMap},
+            iteratorTypes,
+            [](mlir::OpBuilder &nestedBuilder, mlir::Location nestedLoc,
+               mlir::ValueRange args) {
+                auto scaled = nestedBuilder.create<mlir::arith::MulFOp>(
+                    nestedLoc, args[0], args[1]);
+                auto shifted = nestedBuilder.create<mlir::arith::AddFOp>(
+                    nestedLoc, scaled.getResult(), args[2]);
+                nestedBuilder.create<mlir::linalg::YieldOp>(
+                    nestedLoc, shifted.getResult());
+            });
+
+        values[node.outputIds()[0]] = affine.getResult(0);
+        return;
+    }
+
+    llvm::SmallVector<mlir::AffineMap> indexingMaps = {
+        tensorMap, channelMap, channelMap, channelMap, channelMap, tensorMap};
     auto generic = builder.create<mlir::linalg::GenericOp>(
         loc,
         mlir::TypeRange{inputType},
@@ -1131,14 +1897,14 @@ void Codegen::genBatchNormalizationNode(
                 nestedLoc, shifted.getResult());
         });
 
-    values[node.outputs()[0]] = generic.getResult(0);
+    values[node.outputIds()[0]] = generic.getResult(0);
 }
 
 void Codegen::genMaxPoolNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     if (node.inputs().size() != 1) {
         throw std::runtime_error("MaxPool node must have exactly 1 input");
@@ -1153,7 +1919,7 @@ void Codegen::genMaxPoolNode(
         throw std::runtime_error("MaxPool ceil_mode is not supported yet");
     }
 
-    mlir::Value input = getBoundValue(values, node.inputs()[0], "MaxPool");
+    mlir::Value input = getBoundValue(values, node, 0, "MaxPool");
     auto inputType =
         mlir::dyn_cast<mlir::RankedTensorType>(input.getType());
     if (!inputType || inputType.getRank() != 4 ||
@@ -1256,18 +2022,18 @@ void Codegen::genMaxPoolNode(
         getI64VectorAttr(builder, strides),
         getI64VectorAttr(builder, dilations));
 
-    values[node.outputs()[0]] = pool.getResult(0);
+    values[node.outputIds()[0]] = pool.getResult(0);
 }
 
 void Codegen::genReduceMeanNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     checkUnaryNodeShape(node, "ReduceMean");
 
-    mlir::Value input = getBoundValue(values, node.inputs()[0], "ReduceMean");
+    mlir::Value input = getBoundValue(values, node, 0, "ReduceMean");
     auto inputType =
         mlir::dyn_cast<mlir::RankedTensorType>(input.getType());
     if (!inputType || inputType.getRank() != 4 ||
@@ -1371,18 +2137,19 @@ void Codegen::genReduceMeanNode(
                 nestedLoc, scaled.getResult());
         });
 
-    values[node.outputs()[0]] = mean.getResult(0);
+    values[node.outputIds()[0]] = mean.getResult(0);
 }
 
 void Codegen::genReshapeNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
+    const Graph &graph,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     checkBinaryNodeShape(node, "Reshape");
-    mlir::Value input = getBoundValue(values, node.inputs()[0], "Reshape");
-    mlir::Value shapeVal = getBoundValue(values, node.inputs()[1], "Reshape");
+    mlir::Value input = getBoundValue(values, node, 0, "Reshape");
+    mlir::Value shapeVal = getBoundValue(values, node, 1, "Reshape");
 
     auto inputType = mlir::dyn_cast<mlir::RankedTensorType>(input.getType());
     auto shapeType = mlir::dyn_cast<mlir::RankedTensorType>(shapeVal.getType());
@@ -1390,21 +2157,86 @@ void Codegen::genReshapeNode(
         throw std::runtime_error("Reshape expects ranked inputs");
     }
 
-    std::vector<int64_t> resultShape;
-    if (auto constOp = shapeVal.getDefiningOp<mlir::arith::ConstantOp>()) {
-        if (auto dense = mlir::dyn_cast<mlir::DenseIntElementsAttr>(constOp.getValue())) {
-            for (int64_t v : dense.getValues<int64_t>()) resultShape.push_back(v);
-        }
-    }
-    if (resultShape.empty()) {
+    // The ONNX shape input may hold 0 (copy the input dim) and -1 (infer),
+    // which tensor.reshape does not understand. With a constant shape (an
+    // initializer or the result of constant folding) they are resolved:
+    // from the inferred output shape where it is static, from the input
+    // dims at run time otherwise.
+    const Tensor *shapeTensor = graph.tensor(node.inputIds()[1]);
+    if (!shapeTensor || !shapeTensor->isConstant() ||
+        shapeTensor->type() != onnx::TensorProto_DataType_INT64) {
         int64_t r = shapeType.getShape()[0];
         if (mlir::ShapedType::isDynamic(r)) throw std::runtime_error("Reshape: unknown rank");
-        resultShape.assign(static_cast<size_t>(r), mlir::ShapedType::kDynamic);
+        std::vector<int64_t> resultShape(static_cast<size_t>(r),
+                                         mlir::ShapedType::kDynamic);
+        auto resultType = mlir::RankedTensorType::get(resultShape, inputType.getElementType());
+        values[node.outputIds()[0]] = builder.create<mlir::tensor::ReshapeOp>(
+            loc, resultType, input, shapeVal).getResult();
+        return;
+    }
+
+    std::vector<int64_t> target(shapeTensor->data().size() / sizeof(int64_t));
+    std::memcpy(target.data(), shapeTensor->data().data(),
+                target.size() * sizeof(int64_t));
+    const bool allowZero = getIntAttribute(node, "allowzero", 0) != 0;
+
+    std::vector<int64_t> resultShape(target.size(), mlir::ShapedType::kDynamic);
+    const Tensor *output = graph.tensor(node.outputIds()[0]);
+    if (output && output->type() != onnx::TensorProto_DataType_UNDEFINED &&
+        output->shape().size() == target.size()) {
+        resultShape = output->shape();
+    } else {
+        for (size_t i = 0; i < target.size(); ++i) {
+            if (target[i] > 0 || (target[i] == 0 && allowZero)) {
+                resultShape[i] = target[i];
+            }
+        }
+    }
+
+    auto indexType = builder.getIndexType();
+    llvm::SmallVector<mlir::Value> dims;
+    std::optional<size_t> inferredDim;
+    for (size_t i = 0; i < target.size(); ++i) {
+        if (!mlir::ShapedType::isDynamic(resultShape[i])) {
+            dims.push_back(builder.create<mlir::arith::ConstantIndexOp>(
+                loc, resultShape[i]));
+        } else if (target[i] == 0 && !allowZero) {
+            if (i >= static_cast<size_t>(inputType.getRank())) {
+                throw std::runtime_error("Reshape copies a missing dimension");
+            }
+            dims.push_back(builder.create<mlir::tensor::DimOp>(
+                loc, input, static_cast<int64_t>(i)));
+        } else if (target[i] == -1) {
+            inferredDim = i;
+            dims.push_back(mlir::Value());
+        } else {
+            throw std::runtime_error("Reshape has an invalid shape entry");
+        }
+    }
+    if (inferredDim) {
+        mlir::Value total = builder.create<mlir::arith::ConstantIndexOp>(loc, 1);
+        for (int64_t i = 0; i < inputType.getRank(); ++i) {
+            mlir::Value dim = builder.create<mlir::tensor::DimOp>(loc, input, i);
+            total = builder.create<mlir::arith::MulIOp>(loc, total, dim);
+        }
+        mlir::Value known = builder.create<mlir::arith::ConstantIndexOp>(loc, 1);
+        for (size_t i = 0; i < dims.size(); ++i) {
+            if (i != *inferredDim) {
+                known = builder.create<mlir::arith::MulIOp>(loc, known, dims[i]);
+            }
+        }
+        dims[*inferredDim] =
+            builder.create<mlir::arith::DivUIOp>(loc, total, known);
     }
 
+    mlir::Value staticShape =
+        builder.create<mlir::tensor::FromElementsOp>(
+            loc, mlir::RankedTensorType::get(
+                     {static_cast<int64_t>(dims.size())}, indexType),
+            dims);
     auto resultType = mlir::RankedTensorType::get(resultShape, inputType.getElementType());
-    values[node.outputs()[0]] = builder.create<mlir::tensor::ReshapeOp>(
-        loc, resultType, input, shapeVal).getResult();
+    values[node.outputIds()[0]] = builder.create<mlir::tensor::ReshapeOp>(
+        loc, resultType, input, staticShape).getResult();
 }
 
 void Codegen::genSqueezeNode(
@@ -1412,7 +2244,7 @@ void Codegen::genSqueezeNode(
     mlir::Location loc,
     const Graph &graph,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     if (node.inputs().empty() || node.inputs().size() > 2) {
         throw std::runtime_error("Squeeze node must have 1 or 2 inputs");
@@ -1421,7 +2253,7 @@ void Codegen::genSqueezeNode(
         throw std::runtime_error("Squeeze node must have exactly 1 output");
     }
 
-    mlir::Value input = getBoundValue(values, node.inputs()[0], "Squeeze");
+    mlir::Value input = getBoundValue(values, node, 0, "Squeeze");
     auto inputType = mlir::dyn_cast<mlir::RankedTensorType>(input.getType());
     if (!inputType) {
         throw std::runtime_error("Squeeze expects ranked tensor input");
@@ -1439,7 +2271,7 @@ void Codegen::genSqueezeNode(
         }
         axes = *axisVector;
     } else if (node.inputs().size() == 2) {
-        const Tensor *axesTensor = graph.tensor(node.inputs()[1]);
+        const Tensor *axesTensor = graph.tensor(node.inputIds()[1]);
         if (!axesTensor || !axesTensor->isConstant()) {
             throw std::runtime_error(
                 "Squeeze axes input must be a constant initializer");
@@ -1499,7 +2331,7 @@ void Codegen::genSqueezeNode(
             loc, inputType.getElementType(), input, indices);
         auto tensor = builder.create<mlir::tensor::FromElementsOp>(
             loc, resultType, scalar.getResult());
-        values[node.outputs()[0]] = tensor.getResult();
+        values[node.outputIds()[0]] = tensor.getResult();
         return;
     }
 
@@ -1530,19 +2362,19 @@ void Codegen::genSqueezeNode(
 
     auto squeeze = builder.create<mlir::tensor::CollapseShapeOp>(
         loc, resultType, input, reassociation);
-    values[node.outputs()[0]] = squeeze.getResult();
+    values[node.outputIds()[0]] = squeeze.getResult();
 }
 
 void Codegen::genMatMulNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     checkBinaryNodeShape(node, "MatMul");
 
-    mlir::Value lhs = getBoundValue(values, node.inputs()[0], "MatMul");
-    mlir::Value rhs = getBoundValue(values, node.inputs()[1], "MatMul");
+    mlir::Value lhs = getBoundValue(values, node, 0, "MatMul");
+    mlir::Value rhs = getBoundValue(values, node, 1, "MatMul");
 
     auto lhsType = mlir::dyn_cast<mlir::RankedTensorType>(lhs.getType());
     auto rhsType = mlir::dyn_cast<mlir::RankedTensorType>(rhs.getType());
@@ -1593,18 +2425,18 @@ void Codegen::genMatMulNode(
         loc, mlir::TypeRange{resultType}, mlir::ValueRange{lhs, rhs},
         mlir::ValueRange{init.getResult(0)});
 
-    values[node.outputs()[0]] = matmul.getResult(0);
+    values[node.outputIds()[0]] = matmul.getResult(0);
 }
 
 void Codegen::genSoftmaxNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     checkUnaryNodeShape(node, "Softmax");
 
-    mlir::Value input = getBoundValue(values, node.inputs()[0], "Softmax");
+    mlir::Value input = getBoundValue(values, node, 0, "Softmax");
     auto inputType = mlir::dyn_cast<mlir::RankedTensorType>(input.getType());
     if (!inputType) {
         throw std::runtime_error("Softmax expects ranked tensor input");
@@ -1724,18 +2556,18 @@ void Codegen::genSoftmaxNode(
                 nestedLoc, div.getResult());
         });
 
-    values[node.outputs()[0]] = softmax.getResult(0);
+    values[node.outputIds()[0]] = softmax.getResult(0);
 }
 
 void Codegen::genArgMaxNode(
     mlir::OpBuilder &builder,
     mlir::Location loc,
     const Node &node,
-    std::unordered_map<std::string, mlir::Value> &values) const {
+    Values &values) const {
 
     checkUnaryNodeShape(node, "ArgMax");
 
-    mlir::Value input = getBoundValue(values, node.inputs()[0], "ArgMax");
+    mlir::Value input = getBoundValue(values, node, 0, "ArgMax");
     auto inputType = mlir::dyn_cast<mlir::RankedTensorType>(input.getType());
     if (!inputType) {
         throw std::runtime_error("ArgMax expects ranked tensor input");
@@ -1870,7 +2702,7 @@ void Codegen::genArgMaxNode(
         result = expanded.getResult();
     }
 
-    values[node.outputs()[0]] = result;
+    values[node.outputIds()[0]] = result;
 }
 
 } // namespace tensor_compiler
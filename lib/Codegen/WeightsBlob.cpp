@@ -0,0 +1,64 @@
+#include "Codegen/WeightsBlob.h"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace tensor_compiler {
+
+static_assert(kWeightsAlignment == 64, "asmSection emits .p2align 6");
+
+const std::string &WeightsBlob::append(std::string_view bytes) {
+    uint64_t offset = (data_.size() + kWeightsAlignment - 1) /
+                      kWeightsAlignment * kWeightsAlignment;
+    data_.resize(offset, '\0');
+    data_.append(bytes.data(), bytes.size());
+
+    Entry entry;
+    entry.symbol = std::string(kWeightsBaseSymbol) + "_" +
+                   std::to_string(entries_.size());
+    entry.offset = offset;
+    entry.size = bytes.size();
+    entries_.push_back(std::move(entry));
+    return entries_.back().symbol;
+}
+
+void WeightsBlob::clear() {
+    data_.clear();
+    entries_.clear();
+}
+
+void WeightsBlob::write(const std::string &path) const {
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("unable to open weights file: " + path);
+    }
+    out.write(data_.data(), static_cast<std::streamsize>(data_.size()));
+    if (!out) {
+        throw std::runtime_error("unable to write weights file: " + path);
+    }
+}
+
+std::string WeightsBlob::asmSection(const std::string &path) const {
+    std::string quoted;
+    for (char c : path) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+
+    std::string section;
+    section += "\t.section\t.rodata.tensorcomp_weights,\"a\",@progbits\n";
+    section += "\t.p2align\t6\n";
+    section += std::string(kWeightsBaseSymbol) + ":\n";
+    section += "\t.incbin\t\"" + quoted + "\"\n";
+    for (const Entry &entry : entries_) {
+        section += "\t.globl\t" + entry.symbol + "\n";
+        section += "\t.hidden\t" + entry.symbol + "\n";
+        section += "\t.set\t" + entry.symbol + ", " + kWeightsBaseSymbol +
+                   " + " + std::to_string(entry.offset) + "\n";
+    }
+    return section;
+}
+
+} // namespace tensor_compiler
@@ -1,46 +1,48 @@
 #include "Driver.h"
+#include "Cache/CompileCache.h"
 #include "Codegen/Codegen.h"
 #include "GraphDump/DumpPathGen.h"
 #include "GraphDump/GraphvizDumper.h"
+#include "JIT/JitModel.h"
 #include "Lowering/MLIRToLLVM.h"
 #include "Lowering/LLVMToASM.h"
 #include "Lowering/LLVMToLLVMIR.h"
 #include "onnx.pb.h"
 #include "Structure/Graph.h"
+#include "Structure/ModelFile.h"
+#include "Transforms/PassManager.h"
+#include "Transforms/Schedule.h"
+#include "Transforms/ShapeInference.h"
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <fstream>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <iostream>
+#include <limits>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
 
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/OwningOpRef.h"
 #include "mlir/Support/LogicalResult.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/TargetParser/Host.h"
+#include "llvm/TargetParser/Triple.h"
 #include "llvm/Support/raw_ostream.h"
 
-#include "mlir/Dialect/Arith/IR/Arith.h"
-#include "mlir/Dialect/Arith/Transforms/BufferizableOpInterfaceImpl.h"
-#include "mlir/Dialect/Bufferization/IR/Bufferization.h"
-#include "mlir/Dialect/Bufferization/Transforms/FuncBufferizableOpInterfaceImpl.h"
-#include "mlir/Dialect/ControlFlow/IR/ControlFlow.h"
-#include "mlir/Dialect/ControlFlow/Transforms/BufferizableOpInterfaceImpl.h"
-#include "mlir/Dialect/Func/IR/FuncOps.h"
-#include "mlir/Dialect/Linalg/IR/Linalg.h"
-#include "mlir/Dialect/Linalg/Transforms/BufferizableOpInterfaceImpl.h"
-#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
-#include "mlir/Dialect/Math/IR/Math.h"
-#include "mlir/Dialect/MemRef/IR/MemRef.h"
-#include "mlir/Dialect/SCF/IR/SCF.h"
-#include "mlir/Dialect/SCF/Transforms/BufferizableOpInterfaceImpl.h"
-#include "mlir/Dialect/Tensor/IR/Tensor.h"
-#include "mlir/Dialect/Tensor/IR/TensorInferTypeOpInterfaceImpl.h"
-#include "mlir/Dialect/Tensor/Transforms/BufferizableOpInterfaceImpl.h"
-#include "mlir/InitAllDialects.h"
-#include "mlir/Target/LLVMIR/Dialect/Builtin/BuiltinToLLVMIRTranslation.h"
-#include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
+#ifndef TENSOR_COMPILER_RUNTIME_LIB
+#define TENSOR_COMPILER_RUNTIME_LIB "libtensor_runtime.a"
+#endif
 
 // CLI arguments for controlling compilation
 namespace {
@@ -52,11 +54,23 @@ llvm::cl::opt<std::string> inputFile(
 
 llvm::cl::opt<std::string> emitTarget(
     "emit",
-    llvm::cl::desc("Compilation stage: mlir, llvm, or asm"),
+    llvm::cl::desc("Compilation stage: mlir, llvm, asm, obj or so"),
     llvm::cl::init("asm")
 );
 
-constexpr const char *outputFilename = "model.s";
+llvm::cl::opt<std::string> outputFilename(
+    "o",
+    llvm::cl::desc("Output file (default: model.s, model.o or "
+                   "libtensor_model.so; mlir and llvm go to stdout)"),
+    llvm::cl::value_desc("filename"),
+    llvm::cl::init("")
+);
+
+llvm::cl::opt<std::string> runtimeLibrary(
+    "runtime-lib",
+    llvm::cl::desc("Runtime static library linked into --emit=so output"),
+    llvm::cl::init(TENSOR_COMPILER_RUNTIME_LIB)
+);
 
 llvm::cl::opt<std::string> targetTriple(
     "mtriple",
@@ -64,29 +78,357 @@ llvm::cl::opt<std::string> targetTriple(
     llvm::cl::init("x86_64-pc-linux-gnu")
 );
 
+llvm::cl::opt<std::string> convLoweringName(
+    "conv-lowering",
+    llvm::cl::desc("Conv2D lowering: direct, im2col or auto"),
+    llvm::cl::init("direct")
+);
+
+llvm::cl::opt<std::string> winogradName(
+    "winograd",
+    llvm::cl::desc("Winograd for 3x3 stride-1 convs: none, 2 (F(2x2,3x3)) "
+                   "or 4 (F(4x4,3x3))"),
+    llvm::cl::init("none")
+);
+
+llvm::cl::opt<bool> externalWeights(
+    "external-weights",
+    llvm::cl::desc("Write large constants to a binary weights file pulled "
+                   "into the assembly with .incbin"),
+    llvm::cl::init(true)
+);
+
+llvm::cl::opt<bool> fuseEpilogues(
+    "fuse",
+    llvm::cl::desc("Fuse elementwise epilogues into Conv/MatMul loop nests "
+                   "(--emit=mlir then prints the fused module)"),
+    llvm::cl::init(false)
+);
+
+llvm::cl::opt<std::string> targetCPU(
+    "mcpu",
+    llvm::cl::desc("Target CPU for codegen, or 'native' for the host CPU"),
+    llvm::cl::init("")
+);
+
+llvm::cl::opt<std::string> targetFeatures(
+    "mattr",
+    llvm::cl::desc("Target features, e.g. +avx2,+fma,-avx512f"),
+    llvm::cl::init("")
+);
+
 llvm::cl::opt<unsigned> optLevel(
     "O",
     llvm::cl::desc("Optimization level (0-3)"),
     llvm::cl::init(2)
 );
 
+llvm::cl::opt<std::string> pipelineName(
+    "pipeline",
+    llvm::cl::desc("Linalg lowering pipeline: scalar or vectorized"),
+    llvm::cl::init("scalar")
+);
+
+llvm::cl::opt<std::string> runInput(
+    "run",
+    llvm::cl::desc("JIT-compile the model and run it on a raw f32 input file "
+                   "(all graph inputs back to back); -o receives the outputs"),
+    llvm::cl::value_desc("input.bin"),
+    llvm::cl::init("")
+);
+
+llvm::cl::opt<unsigned> runIterations(
+    "run-iterations",
+    llvm::cl::desc("Number of timed inferences for --run"),
+    llvm::cl::init(10)
+);
+
+llvm::cl::opt<std::string> cacheDirectory(
+    "cache-dir",
+    llvm::cl::desc("Compilation cache for obj, so and --run artifacts "
+                   "(default: $TC_CACHE_DIR; disabled if neither is set)"),
+    llvm::cl::value_desc("directory"),
+    llvm::cl::init("")
+);
+
+llvm::cl::opt<bool> parallelLoops(
+    "parallel",
+    llvm::cl::desc("Run parallel loops of the kernel on the runtime thread pool"),
+    llvm::cl::init(false)
+);
+
+llvm::cl::opt<unsigned> codegenThreads(
+    "j",
+    llvm::cl::desc("Threads for LLVM code generation of obj and so output "
+                   "(0: one per core); asm is always generated on one thread"),
+    llvm::cl::init(1)
+);
+
+llvm::cl::list<std::string> disabledPasses(
+    "disable-pass",
+    llvm::cl::desc("Graph passes to skip: fold-batch-norm, identity, "
+                   "constant-fold, cse, dce"),
+    llvm::cl::CommaSeparated
+);
+
+unsigned resolveCodegenThreads() {
+    if (codegenThreads != 0) {
+        return codegenThreads;
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// With -j > 1 the model object is an archive of per-thread objects: the
+// .so link step takes it whole, obj output merges it with `ld -r`.
+bool objectIsArchive() {
+    return resolveCodegenThreads() > 1;
+}
+
+std::string outputNameOr(const char *defaultName) {
+    return outputFilename.empty() ? std::string(defaultName)
+                                  : std::string(outputFilename);
+}
+
 } // anonymous namespace
 
 namespace tensor_compiler {
 
+namespace {
+
+size_t staticElementCount(const Graph &graph, const std::string &name) {
+    const Tensor *tensor = graph.tensor(name);
+    if (!tensor) {
+        throw std::runtime_error("tensor not found: " + name);
+    }
+    size_t count = 1;
+    for (int64_t d : tensor->shape()) {
+        if (d <= 0) {
+            throw std::runtime_error("--run needs static shapes: " + name);
+        }
+        count *= static_cast<size_t>(d);
+    }
+    return count;
+}
+
+// Everything that changes the generated code, so equal keys mean
+// interchangeable artifacts.
+std::string compileCacheKey(const ModelFile &modelFile,
+                            const TargetSpec &target,
+                            llvm::StringRef artifact) {
+    CacheKey key;
+    key.add(artifact);
+    key.addCompilerVersion();
+    const std::string_view modelBytes = modelFile.bytes();
+    key.add(llvm::StringRef(modelBytes.data(), modelBytes.size()));
+    // External weights are not part of the .onnx file.
+    for (const auto &[location, file] : modelFile.externalFiles()) {
+        const std::string_view bytes = file.bytes();
+        key.add(location).add(llvm::StringRef(bytes.data(), bytes.size()));
+    }
+    key.add(target.triple).add(target.cpu).add(target.features);
+    // JIT objects are compiled for the host CPU, with -mcpu/-mattr only
+    // steering the optimizer, and a cache directory may be shared between
+    // machines.
+    if (artifact == "jit") {
+        key.add(llvm::sys::getHostCPUName());
+        llvm::StringMap<bool> hostFeatures;
+        std::vector<std::string> features;
+        if (llvm::sys::getHostCPUFeatures(hostFeatures)) {
+            for (const auto &feature : hostFeatures) {
+                features.push_back((feature.second ? "+" : "-") +
+                                   feature.first().str());
+            }
+        }
+        std::sort(features.begin(), features.end());
+        for (const std::string &feature : features) {
+            key.add(feature);
+        }
+    }
+    key.add(static_cast<int64_t>(optLevel));
+    key.add(pipelineName).add(convLoweringName).add(winogradName);
+    key.add(static_cast<int64_t>(fuseEpilogues));
+    key.add(static_cast<int64_t>(parallelLoops));
+    key.add(static_cast<int64_t>(externalWeights));
+    for (const std::string &name : disabledPasses) {
+        key.add(name);
+    }
+    if (artifact == "obj") {
+        key.add(static_cast<int64_t>(resolveCodegenThreads()));
+    }
+    return key.finish();
+}
+
+// --run: feed the JIT-compiled model the input file and time it.
+int runJit(const Graph &graph,
+           llvm::Expected<std::unique_ptr<JitModel>> model) {
+    if (!model) {
+        llvm::errs() << "Error: JIT compilation failed: "
+                     << llvm::toString(model.takeError()) << "\n";
+        return 1;
+    }
+
+    std::vector<std::vector<float>> inputData;
+    size_t inputBytes = 0;
+    for (const std::string &name : graph.inputs()) {
+        inputData.emplace_back(staticElementCount(graph, name));
+        inputBytes += inputData.back().size() * sizeof(float);
+    }
+    std::vector<std::vector<float>> outputData;
+    for (const std::string &name : graph.outputs()) {
+        outputData.emplace_back(staticElementCount(graph, name));
+    }
+
+    std::ifstream in(runInput, std::ios::in | std::ios::binary);
+    in.seekg(0, std::ios::end);
+    if (!in || static_cast<size_t>(in.tellg()) != inputBytes) {
+        llvm::errs() << "Error: " << runInput << " must hold " << inputBytes
+                     << " bytes of f32 input data\n";
+        return 1;
+    }
+    in.seekg(0, std::ios::beg);
+    std::vector<const float *> inputs;
+    for (auto &data : inputData) {
+        in.read(reinterpret_cast<char *>(data.data()),
+                static_cast<std::streamsize>(data.size() * sizeof(float)));
+        inputs.push_back(data.data());
+    }
+    std::vector<float *> outputs;
+    for (auto &data : outputData) {
+        outputs.push_back(data.data());
+    }
+
+    // Warm-up: the first call also faults in the weights and workspace.
+    if (int status = (*model)->forward(inputs, outputs)) {
+        llvm::errs() << "Error: inference returned " << status << "\n";
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    double totalMs = 0.0;
+    double minMs = std::numeric_limits<double>::max();
+    for (unsigned i = 0; i < runIterations; ++i) {
+        auto start = Clock::now();
+        (*model)->forward(inputs, outputs);
+        double ms = std::chrono::duration<double, std::milli>(
+                        Clock::now() - start).count();
+        totalMs += ms;
+        minMs = std::min(minMs, ms);
+    }
+    if (runIterations > 0) {
+        llvm::outs() << "iterations: " << runIterations
+                     << ", mean: " << totalMs / runIterations
+                     << " ms, min: " << minMs << " ms\n";
+    }
+
+    if (!outputFilename.empty()) {
+        std::ofstream out(outputFilename, std::ios::out | std::ios::binary);
+        for (const auto &data : outputData) {
+            out.write(reinterpret_cast<const char *>(data.data()),
+                      static_cast<std::streamsize>(data.size() * sizeof(float)));
+        }
+        if (!out) {
+            llvm::errs() << "Error: cannot write " << outputFilename << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Turns the object of the model into the requested obj/so output.
+int finishObject(const std::string &objPath) {
+    if (emitTarget == "obj") {
+        std::string objName = outputNameOr("model.o");
+        if (objPath == objName) {
+            return 0;
+        }
+        if (objectIsArchive()) {
+            return mlir::failed(linkRelocatableObject(objPath, objName)) ? 1
+                                                                         : 0;
+        }
+        if (auto copyEc = llvm::sys::fs::copy_file(objPath, objName)) {
+            llvm::errs() << "Error: cannot write " << objName << ": "
+                         << copyEc.message() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+    return mlir::failed(linkSharedLibrary(
+               objPath, runtimeLibrary, outputNameOr("libtensor_model.so")))
+               ? 1
+               : 0;
+}
+
+} // namespace
+
 int driver(int argc, char *argv[]) {
     llvm::cl::ParseCommandLineOptions(argc, argv, "Tensor Compiler\n");
 
-    onnx::ModelProto model;
-    std::fstream input(inputFile, std::ios::in | std::ios::binary);
-    if (!input.good())
-        throw std::runtime_error(
-            "Failed to open ONNX model file: " + inputFile + "\n");
+    LoweringOptions loweringOptions;
+    if (pipelineName == "scalar") {
+        loweringOptions.pipeline = Pipeline::scalar;
+    } else if (pipelineName == "vectorized") {
+        loweringOptions.pipeline = Pipeline::vectorized;
+    } else {
+        llvm::errs() << "Unknown pipeline: " << pipelineName << "\n";
+        return 1;
+    }
+    loweringOptions.parallel = parallelLoops;
+
+    if (emitTarget != "mlir" && emitTarget != "llvm" && emitTarget != "asm" &&
+        emitTarget != "obj" && emitTarget != "so") {
+        llvm::errs() << "Unknown emit target: " << emitTarget << "\n";
+        return 1;
+    }
+    if (codegenThreads != 1 && emitTarget == "asm") {
+        llvm::errs() << "Warning: -j applies to --emit=obj and --emit=so "
+                        "only; asm output is generated on one thread\n";
+    }
 
-    if (!model.ParseFromIstream(&input))
-        throw std::runtime_error("Failed to parse ONNX model.\n");
+    CodegenOptions codegenOptions;
+    if (convLoweringName == "direct") {
+        codegenOptions.convLowering = ConvLowering::direct;
+    } else if (convLoweringName == "im2col") {
+        codegenOptions.convLowering = ConvLowering::im2col;
+    } else if (convLoweringName == "auto") {
+        codegenOptions.convLowering = ConvLowering::automatic;
+    } else {
+        llvm::errs() << "Unknown conv lowering: " << convLoweringName << "\n";
+        return 1;
+    }
+    if (winogradName == "none") {
+        codegenOptions.winograd = Winograd::none;
+    } else if (winogradName == "2") {
+        codegenOptions.winograd = Winograd::f2x2;
+    } else if (winogradName == "4") {
+        codegenOptions.winograd = Winograd::f4x4;
+    } else {
+        llvm::errs() << "Unknown Winograd variant: " << winogradName << "\n";
+        return 1;
+    }
+    codegenOptions.externalWeights = externalWeights;
+    loweringOptions.fuse = fuseEpilogues;
 
-    Graph compute_graph{model.graph()};
+    const TargetSpec target =
+        resolveTargetSpec(targetTriple, targetCPU, targetFeatures);
+    if (auto vectorWidth = getVectorWidth(target)) {
+        loweringOptions.vectorWidth = *vectorWidth;
+    }
+
+    // Initializers view the mapped file, so it outlives every use of the
+    // graph below.
+    const ModelFile modelFile(inputFile);
+    Graph compute_graph{modelFile.model().graph(), modelFile.rawData()};
+    sortTopologically(compute_graph);
+    inferShapes(compute_graph);
+    {
+        PassManager graphPasses;
+        addDefaultGraphPasses(graphPasses);
+        for (const std::string &name : disabledPasses) {
+            graphPasses.disable(name);
+        }
+        graphPasses.run(compute_graph);
+    }
+    scheduleForMemory(compute_graph);
 
 #ifdef GRAPH_DUMP
     // ____________GRAPH DUMP___________ //
@@ -102,33 +444,33 @@ int driver(int argc, char *argv[]) {
     GraphvizDumper::dump(compute_graph, gv);
 #endif
 
+    // Objects (obj/so) and JIT objects (--run) are cached; a hit skips
+    // Codegen, the MLIR pipeline and LLVM codegen.
+    std::optional<CompileCache> cache;
+    std::string cacheKey;
+    const bool cacheable =
+        !runInput.empty() || emitTarget == "obj" || emitTarget == "so";
+    const std::string cacheDir = cacheDirectory.empty()
+                                     ? CompileCache::defaultDirectory()
+                                     : std::string(cacheDirectory);
+    if (cacheable && !cacheDir.empty()) {
+        cache.emplace(cacheDir);
+        cacheKey = compileCacheKey(modelFile, target,
+                                   runInput.empty() ? "obj" : "jit");
+        if (!runInput.empty()) {
+            if (auto hit = cache->lookup(cacheKey)) {
+                return runJit(compute_graph, JitModel::load(*hit));
+            }
+        } else if (auto hit = cache->lookup(cacheKey)) {
+            return finishObject(*hit);
+        }
+    }
+
     mlir::MLIRContext context;
 
-    mlir::DialectRegistry registry;
-    registry.insert<mlir::func::FuncDialect>();
-    registry.insert<mlir::arith::ArithDialect>();
-    registry.insert<mlir::tensor::TensorDialect>();
-    registry.insert<mlir::linalg::LinalgDialect>();
-    registry.insert<mlir::scf::SCFDialect>();
-    registry.insert<mlir::memref::MemRefDialect>();
-    registry.insert<mlir::math::MathDialect>();
-    registry.insert<mlir::cf::ControlFlowDialect>();
-    registry.insert<mlir::LLVM::LLVMDialect>();
-    registry.insert<mlir::bufferization::BufferizationDialect>();
-    mlir::arith::registerBufferizableOpInterfaceExternalModels(registry);
-    mlir::bufferization::func_ext::registerBufferizableOpInterfaceExternalModels(
-        registry);
-    mlir::cf::registerBufferizableOpInterfaceExternalModels(registry);
-    mlir::linalg::registerBufferizableOpInterfaceExternalModels(registry);
-    mlir::scf::registerBufferizableOpInterfaceExternalModels(registry);
-    mlir::tensor::registerInferTypeOpInterfaceExternalModels(registry);
-    mlir::tensor::registerBufferizableOpInterfaceExternalModels(registry);
-    context.appendDialectRegistry(registry);
-    context.loadAllAvailableDialects();
-    mlir::registerBuiltinDialectTranslation(context);
-    mlir::registerLLVMDialectTranslation(context);
-
-    tensor_compiler::Codegen codegen{context};
+    registerCompilerDialects(context);
+
+    tensor_compiler::Codegen codegen{context, codegenOptions};
     auto mlirModule = codegen.generate(compute_graph);
     if (!mlirModule) {
         llvm::errs() << "Error: Codegen returned null module\n";
@@ -151,17 +493,72 @@ int driver(int argc, char *argv[]) {
                 "i64:64-f80:128-n8:16:32:64-S128"));
     }
 
+    std::error_code ec;
+    std::optional<llvm::raw_fd_ostream> outputFile;
+    // Textual stages go to stdout unless -o is given.
+    auto openTextOutput = [&]() -> llvm::raw_ostream * {
+        std::string name = outputNameOr("-");
+        if (name == "-") {
+            return &llvm::outs();
+        }
+        outputFile.emplace(name, ec, llvm::sys::fs::OF_Text);
+        if (ec) {
+            llvm::errs() << "Error: cannot open " << name << ": "
+                         << ec.message() << "\n";
+            return nullptr;
+        }
+        return &*outputFile;
+    };
+
+    // --emit=mlir prints the module as Codegen built it, unless --fuse asks
+    // for the fused loop nests, which only exist after optimizeTensorIR.
+    const bool optimizeBeforeEmit = fuseEpilogues;
+    auto optimize = [&]() {
+        if (mlir::failed(
+                optimizeTensorIR(context, mlirModule, loweringOptions))) {
+            llvm::errs() << "Error: MLIR tensor optimization failed\n";
+            return false;
+        }
+        return true;
+    };
+    if (optimizeBeforeEmit && !optimize()) {
+        return 1;
+    }
+
     if (emitTarget == "mlir") {
-        mlirModule->print(llvm::outs());
-        llvm::outs() << "\n";
+        llvm::raw_ostream *os = openTextOutput();
+        if (!os) {
+            return 1;
+        }
+        mlirModule->print(*os);
+        *os << "\n";
         return 0;
     }
 
-    if (mlir::failed(MLIRToLLVM(context, mlirModule))) {
+    if (!optimizeBeforeEmit && !optimize()) {
+        return 1;
+    }
+
+    if (mlir::failed(MLIRToLLVM(context, mlirModule, loweringOptions))) {
         llvm::errs() << "Error: MLIR to LLVM lowering failed\n";
         return 1;
     }
 
+    if (!runInput.empty()) {
+        std::string objPath = cache ? cache->createTemporary() : std::string();
+        std::optional<llvm::FileRemover> objRemover;
+        if (!objPath.empty()) {
+            objRemover.emplace(objPath);
+        }
+        auto jitModel =
+            JitModel::create(*mlirModule, codegen.weights(), optLevel,
+                             target.cpu, target.features, objPath);
+        if (jitModel && !objPath.empty()) {
+            cache->insert(cacheKey, objPath);
+        }
+        return runJit(compute_graph, std::move(jitModel));
+    }
+
     llvm::LLVMContext llvmCtx;
     auto llvmModule = LLVMToLLVMIR(llvmCtx, mlirModule);
     if (!llvmModule) {
@@ -170,27 +567,97 @@ int driver(int argc, char *argv[]) {
     }
 
     if (emitTarget == "llvm") {
-        llvmModule->print(llvm::outs(), nullptr);
+        llvm::raw_ostream *os = openTextOutput();
+        if (!os) {
+            return 1;
+        }
+        llvmModule->print(*os, nullptr);
         return 0;
     }
 
+    const WeightsBlob &weights = codegen.weights();
+
     if (emitTarget == "asm") {
-        std::error_code ec;
-        llvm::raw_fd_ostream asmStream(
-            outputFilename,
-            ec,
-            llvm::sys::fs::OF_None);
-
-        if (mlir::failed(generateAssembly(
-                llvmModule.get(), targetTriple, optLevel, asmStream))) {
+        std::string asmName = outputNameOr("model.s");
+
+        // The weights file sits next to the assembly; .incbin gets an
+        // absolute path since the assembler may run from another directory.
+        llvm::SmallString<256> weightsPath(asmName);
+        llvm::sys::path::replace_extension(weightsPath, "weights");
+        llvm::sys::fs::make_absolute(weightsPath);
+        if (!weights.empty()) {
+            if (!llvm::Triple(targetTriple).isOSBinFormatELF()) {
+                llvm::errs() << "Error: external weights need an ELF target; "
+                                "use --external-weights=false\n";
+                return 1;
+            }
+            weights.write(std::string(weightsPath));
+        }
+
+        llvm::raw_fd_ostream asmStream(asmName, ec, llvm::sys::fs::OF_Text);
+        if (ec) {
+            llvm::errs() << "Error: cannot open " << asmName << ": "
+                         << ec.message() << "\n";
+            return 1;
+        }
+        if (mlir::failed(generateAssembly(llvmModule.get(), target, optLevel,
+                                          asmStream))) {
             llvm::errs() << "Error: Assembly generation failed\n";
             return 1;
         }
+        if (!weights.empty()) {
+            asmStream << weights.asmSection(std::string(weightsPath));
+        }
         return 0;
     }
 
-    llvm::errs() << "Unknown emit target: " << emitTarget << "\n";
-    return 1;
+    // obj and so: straight from the TargetMachine, weights in the object.
+    // With a cache the object is written into it first.
+    embedWeights(*llvmModule, weights);
+
+    std::string objPath = cache ? cache->createTemporary() : std::string();
+    const bool writeOutputDirectly =
+        objPath.empty() && emitTarget == "obj" && !objectIsArchive();
+    if (writeOutputDirectly) {
+        objPath = outputNameOr("model.o");
+    } else if (objPath.empty()) {
+        int objFd = -1;
+        llvm::SmallString<256> tmpPath;
+        if (auto tmpEc = llvm::sys::fs::createTemporaryFile(
+                "tensor_model", "o", objFd, tmpPath)) {
+            llvm::errs() << "Error: cannot create temporary object: "
+                         << tmpEc.message() << "\n";
+            return 1;
+        }
+        llvm::sys::Process::SafelyCloseFileDescriptor(objFd);
+        objPath = std::string(tmpPath);
+    }
+    std::optional<llvm::FileRemover> objRemover;
+    if (!writeOutputDirectly) {
+        objRemover.emplace(objPath);
+    }
+
+    {
+        llvm::raw_fd_ostream objStream(objPath, ec, llvm::sys::fs::OF_None);
+        if (ec) {
+            llvm::errs() << "Error: cannot open " << objPath << ": "
+                         << ec.message() << "\n";
+            return 1;
+        }
+        const CodeGenFile fileKind = objectIsArchive() ? CodeGenFile::archive
+                                                       : CodeGenFile::object;
+        if (mlir::failed(generateCode(llvmModule.get(), target, optLevel,
+                                      fileKind, objStream,
+                                      resolveCodegenThreads()))) {
+            llvm::errs() << "Error: Object generation failed\n";
+            return 1;
+        }
+    }
+
+    if (cache && cache->insert(cacheKey, objPath)) {
+        objPath = *cache->lookup(cacheKey);
+    }
+    return finishObject(objPath);
 }
 
 } // namespace tensor_compiler
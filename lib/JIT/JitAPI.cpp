@@ -0,0 +1,43 @@
+#include "ModelAPI/JitAPI.h"
+#include "JIT/JitModel.h"
+
+#include "llvm/Support/Error.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <memory>
+#include <vector>
+
+struct TcJitModel {
+    std::unique_ptr<tensor_compiler::JitModel> model;
+};
+
+extern "C" {
+
+TcJitModel *tcJitLoad(const char *objectPath) {
+    if (!objectPath) {
+        return nullptr;
+    }
+    auto model = tensor_compiler::JitModel::load(objectPath);
+    if (!model) {
+        llvm::logAllUnhandledErrors(model.takeError(), llvm::errs(),
+                                    "tcJitLoad: ");
+        return nullptr;
+    }
+    return new TcJitModel{std::move(*model)};
+}
+
+int tcJitForward(TcJitModel *model, const float *const *inputs,
+                 size_t numInputs, float *const *outputs, size_t numOutputs) {
+    if (!model || (numInputs && !inputs) || (numOutputs && !outputs)) {
+        return -1;
+    }
+    const std::vector<const float *> inputList(inputs, inputs + numInputs);
+    const std::vector<float *> outputList(outputs, outputs + numOutputs);
+    return model->model->forward(inputList, outputList);
+}
+
+void tcJitFree(TcJitModel *model) {
+    delete model;
+}
+
+} // extern "C"
@@ -0,0 +1,283 @@
+#include "JIT/JitModel.h"
+#include "Lowering/LLVMToLLVMIR.h"
+#include "Lowering/MemoryPlanner.h"
+#include "ModelAPI/ModelAPI.h"
+
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/Target/LLVMIR/Export.h"
+
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/Mangling.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/TargetParser/SubtargetFeature.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+
+// Provided by lib/Runtime/MemRefCopy.c; only its address is taken here.
+extern "C" void memrefCopy(int64_t elemSize, void *src, void *dst);
+
+namespace tensor_compiler {
+
+namespace {
+
+constexpr const char *kEntryFuncName = "tensorCompForwardImpl";
+
+// Exported i64 holding the number of inputs plus outputs, so objects
+// loaded from the cache know it too.
+constexpr const char *kNumBuffersSymbol = "tensorCompNumBuffers";
+
+// ExecutionEngine wraps every function f in `void _mlir_f(void **args)`,
+// which takes pointers to the arguments followed by one to the result.
+constexpr const char *kPackedPrefix = "_mlir_";
+
+llvm::CodeGenOptLevel toCodeGenOptLevel(unsigned optLevel) {
+    switch (optLevel) {
+    case 0:
+        return llvm::CodeGenOptLevel::None;
+    case 1:
+        return llvm::CodeGenOptLevel::Less;
+    case 2:
+        return llvm::CodeGenOptLevel::Default;
+    default:
+        return llvm::CodeGenOptLevel::Aggressive;
+    }
+}
+
+// The generated code calls into the runtime, which is linked into the
+// compiler rather than loaded from a shared library.
+llvm::orc::SymbolMap runtimeSymbols(llvm::orc::MangleAndInterner interner) {
+    llvm::orc::SymbolMap symbols;
+    symbols[interner("tensorCompParallelFor")] = {
+        llvm::orc::ExecutorAddr::fromPtr(&tensorCompParallelFor),
+        llvm::JITSymbolFlags::Exported};
+    symbols[interner("memrefCopy")] = {
+        llvm::orc::ExecutorAddr::fromPtr(&memrefCopy),
+        llvm::JITSymbolFlags::Exported};
+    return symbols;
+}
+
+void initializeNativeTarget() {
+    static const bool initialized = [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        return true;
+    }();
+    (void)initialized;
+}
+
+} // namespace
+
+llvm::Expected<std::unique_ptr<JitModel>>
+JitModel::create(mlir::ModuleOp llvmDialectModule, const WeightsBlob &weights,
+                 unsigned optLevel, const std::string &cpu,
+                 const std::string &features, const std::string &objectPath) {
+    if (optLevel > 3) {
+        return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                       "invalid optimization level");
+    }
+
+    auto entry =
+        llvmDialectModule.lookupSymbol<mlir::LLVM::LLVMFuncOp>(kEntryFuncName);
+    if (!entry || entry.getNumArguments() == 0) {
+        return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                       "module has no lowered entry function");
+    }
+
+    initializeNativeTarget();
+
+    // The last argument of the entry function is the workspace.
+    const std::size_t numBuffers = entry.getNumArguments() - 1;
+
+    // The TargetMachine gives the vectorizers and the unroller the costs of
+    // the host rather than generic ones.
+    auto targetBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!targetBuilder) {
+        return targetBuilder.takeError();
+    }
+    if (!cpu.empty()) {
+        targetBuilder->setCPU(cpu);
+    }
+    targetBuilder->addFeatures(llvm::SubtargetFeatures(features).getFeatures());
+    targetBuilder->setCodeGenOptLevel(toCodeGenOptLevel(optLevel));
+    auto targetMachine = targetBuilder->createTargetMachine();
+    if (!targetMachine) {
+        return targetMachine.takeError();
+    }
+
+    mlir::ExecutionEngineOptions options;
+    options.jitCodeGenOptLevel = toCodeGenOptLevel(optLevel);
+    options.transformer = mlir::makeOptimizingTransformer(
+        optLevel, /*sizeLevel=*/0, targetMachine->get());
+    options.enableObjectDump = !objectPath.empty();
+    options.llvmModuleBuilder =
+        [&weights, numBuffers](mlir::Operation *op, llvm::LLVMContext &ctx)
+        -> std::unique_ptr<llvm::Module> {
+        auto module = mlir::translateModuleToLLVMIR(op, ctx, "tensor_network");
+        if (module) {
+            embedWeights(*module, weights);
+            auto *i64 = llvm::Type::getInt64Ty(ctx);
+            new llvm::GlobalVariable(
+                *module, i64, /*isConstant=*/true,
+                llvm::GlobalValue::ExternalLinkage,
+                llvm::ConstantInt::get(i64, numBuffers), kNumBuffersSymbol);
+        }
+        return module;
+    };
+
+    auto engine = mlir::ExecutionEngine::create(llvmDialectModule, options);
+    if (!engine) {
+        return engine.takeError();
+    }
+    (*engine)->registerSymbols(runtimeSymbols);
+
+    auto forward = (*engine)->lookupPacked(kEntryFuncName);
+    if (!forward) {
+        return forward.takeError();
+    }
+    auto workspaceSize = (*engine)->lookupPacked(kWorkspaceSizeFuncName);
+    if (!workspaceSize) {
+        return workspaceSize.takeError();
+    }
+    if (!objectPath.empty()) {
+        (*engine)->dumpToObjectFile(objectPath);
+    }
+
+    std::unique_ptr<JitModel> model(new JitModel());
+    model->engine_ = std::move(*engine);
+    if (llvm::Error error =
+            model->initialize(*forward, *workspaceSize, numBuffers)) {
+        return std::move(error);
+    }
+    return model;
+}
+
+llvm::Expected<std::unique_ptr<JitModel>>
+JitModel::load(const std::string &objectPath) {
+    initializeNativeTarget();
+
+    auto object = llvm::MemoryBuffer::getFile(objectPath);
+    if (!object) {
+        return llvm::createStringError(object.getError(),
+                                       "cannot read " + objectPath);
+    }
+
+    auto jit = llvm::orc::LLJITBuilder().create();
+    if (!jit) {
+        return jit.takeError();
+    }
+
+    // libc (malloc, free, ...) comes from the process, the runtime from the
+    // copy linked into the compiler.
+    llvm::orc::JITDylib &dylib = (*jit)->getMainJITDylib();
+    const llvm::DataLayout &layout = (*jit)->getDataLayout();
+    auto processSymbols =
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+            layout.getGlobalPrefix());
+    if (!processSymbols) {
+        return processSymbols.takeError();
+    }
+    dylib.addGenerator(std::move(*processSymbols));
+    llvm::orc::MangleAndInterner interner((*jit)->getExecutionSession(),
+                                          layout);
+    if (llvm::Error error = dylib.define(
+            llvm::orc::absoluteSymbols(runtimeSymbols(interner)))) {
+        return std::move(error);
+    }
+
+    if (llvm::Error error = (*jit)->addObjectFile(std::move(*object))) {
+        return std::move(error);
+    }
+
+    auto forward = (*jit)->lookup(std::string(kPackedPrefix) + kEntryFuncName);
+    if (!forward) {
+        return forward.takeError();
+    }
+    auto workspaceSize =
+        (*jit)->lookup(std::string(kPackedPrefix) + kWorkspaceSizeFuncName);
+    if (!workspaceSize) {
+        return workspaceSize.takeError();
+    }
+
+    // The entry function is in its bare-pointer form, so its arity comes
+    // from the symbol create() added.
+    auto numBuffers = (*jit)->lookup(kNumBuffersSymbol);
+    if (!numBuffers) {
+        return numBuffers.takeError();
+    }
+
+    std::unique_ptr<JitModel> model(new JitModel());
+    model->jit_ = std::move(*jit);
+    if (llvm::Error error = model->initialize(
+            forward->toPtr<PackedFunc>(), workspaceSize->toPtr<PackedFunc>(),
+            static_cast<std::size_t>(*numBuffers->toPtr<const int64_t *>()))) {
+        return std::move(error);
+    }
+    return model;
+}
+
+llvm::Error JitModel::initialize(PackedFunc forward, PackedFunc workspaceSize,
+                                 std::size_t numBuffers) {
+    forward_ = forward;
+    numBuffers_ = numBuffers;
+
+    int64_t size = 0;
+    void *sizeArgs[] = {&size};
+    workspaceSize(sizeArgs);
+
+    size_t rounded = (static_cast<size_t>(size) + kWorkspaceAlignment - 1) /
+                     kWorkspaceAlignment * kWorkspaceAlignment;
+    workspace_ = std::aligned_alloc(kWorkspaceAlignment,
+                                    rounded ? rounded : kWorkspaceAlignment);
+    if (!workspace_) {
+        return llvm::createStringError(
+            std::make_error_code(std::errc::not_enough_memory),
+            "cannot allocate the model workspace");
+    }
+    return llvm::Error::success();
+}
+
+JitModel::~JitModel() {
+    std::free(workspace_);
+}
+
+int JitModel::forward(const std::vector<const float *> &inputs,
+                      const std::vector<float *> &outputs) {
+    if (inputs.size() + outputs.size() != numBuffers_) {
+        return -1;
+    }
+
+    std::vector<void *> args;
+    args.reserve(inputs.size() + outputs.size() + 1);
+    for (const float *input : inputs) {
+        args.push_back(const_cast<float *>(input));
+    }
+    for (float *output : outputs) {
+        args.push_back(output);
+    }
+    args.push_back(workspace_);
+
+    int32_t result = 0;
+    std::vector<void *> argPtrs;
+    argPtrs.reserve(args.size() + 1);
+    for (void *&arg : args) {
+        argPtrs.push_back(&arg);
+    }
+    argPtrs.push_back(&result);
+
+    forward_(argPtrs.data());
+    return result;
+}
+
+} // namespace tensor_compiler
@@ -0,0 +1,234 @@
+#include "Lowering/Fusion.h"
+#include "Lowering/ParallelLoops.h"
+
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Linalg/Transforms/Transforms.h"
+#include "mlir/Dialect/Linalg/Utils/Utils.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/SCF/Transforms/TileUsingInterface.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Interfaces/TilingInterface.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include <algorithm>
+#include <optional>
+#include <tuple>
+
+using namespace mlir;
+
+namespace tensor_compiler {
+
+namespace {
+
+// Rows and channels computed per fused tile; the full width is kept so the
+// vectorizer still sees the contiguous dimension whole.
+constexpr int64_t kFusedRowTile = 8;
+constexpr int64_t kFusedChannelTile = 8;
+
+int64_t divisorTile(int64_t extent, int64_t bound) {
+    for (int64_t d = std::min(extent, bound); d > 1; --d) {
+        if (extent % d == 0) {
+            return d == extent ? 0 : d;
+        }
+    }
+    return extent == 1 ? 0 : 1;
+}
+
+// Ops worth anchoring a fused loop nest on: anything that reduces, such as
+// convolutions, matmuls and pooling.
+bool isHeavyProducer(Operation *op) {
+    auto linalgOp = mlir::dyn_cast_or_null<linalg::LinalgOp>(op);
+    return linalgOp && linalgOp.getNumReductionLoops() > 0;
+}
+
+std::optional<llvm::SmallVector<int64_t>>
+epilogueTileSizes(linalg::GenericOp op) {
+    llvm::SmallVector<int64_t> ranges = op.getStaticLoopRanges();
+    if (ranges.size() < 2 || llvm::any_of(ranges, ShapedType::isDynamic)) {
+        return std::nullopt;
+    }
+
+    const size_t rank = ranges.size();
+    llvm::SmallVector<int64_t> tiles(rank, 0);
+    for (size_t i = 0; i + 2 < rank; ++i) {
+        tiles[i] = divisorTile(ranges[i], 1);
+    }
+    if (rank >= 3) {
+        tiles[1] = divisorTile(ranges[1], kFusedChannelTile);
+    }
+    tiles[rank - 2] = divisorTile(ranges[rank - 2], kFusedRowTile);
+
+    if (llvm::all_of(tiles, [](int64_t t) { return t == 0; })) {
+        return std::nullopt;
+    }
+    return tiles;
+}
+
+// Producers that are cheap to recompute per tile: fills, pads and
+// broadcast or elementwise generics. Anything with a reduction iterator
+// would redo its halo for every tile.
+bool isCheapProducer(Operation *op) {
+    if (mlir::isa<linalg::FillOp, linalg::BroadcastOp, tensor::PadOp>(op)) {
+        return true;
+    }
+    auto generic = mlir::dyn_cast<linalg::GenericOp>(op);
+    return generic && generic.getNumReductionLoops() == 0;
+}
+
+// Producers of the anchor that are used by nothing outside the fused
+// group: the reduction ops the anchor reads directly, then, walking back,
+// only their fills, bias broadcasts and pads. Only these are pulled into
+// the tiles: recomputing a producer with other users would keep its
+// full-size op alive as well.
+llvm::DenseSet<Operation *> collectFusibleProducers(Operation *anchor) {
+    llvm::DenseSet<Operation *> group = {anchor};
+    llvm::SmallVector<Operation *> worklist = {anchor};
+    while (!worklist.empty()) {
+        Operation *op = worklist.pop_back_val();
+        for (Value operand : op->getOperands()) {
+            Operation *producer = operand.getDefiningOp();
+            if (!producer || group.contains(producer) ||
+                !mlir::isa<TilingInterface>(producer)) {
+                continue;
+            }
+            const bool fusible =
+                isCheapProducer(producer) ||
+                (op == anchor && isHeavyProducer(producer));
+            if (!fusible) {
+                continue;
+            }
+            bool onlyUsedInGroup = llvm::all_of(
+                producer->getUsers(),
+                [&](Operation *user) { return group.contains(user); });
+            if (onlyUsedInGroup) {
+                group.insert(producer);
+                worklist.push_back(producer);
+            }
+        }
+    }
+    group.erase(anchor);
+    return group;
+}
+
+bool isEpilogueAnchor(linalg::GenericOp op) {
+    if (!linalg::isElementwise(op) || op.getNumDpsInits() != 1) {
+        return false;
+    }
+    return llvm::any_of(op.getDpsInputs(), [](Value input) {
+        Operation *producer = input.getDefiningOp();
+        return isHeavyProducer(producer) && producer->hasOneUse();
+    });
+}
+
+class FuseEpiloguesPass
+    : public PassWrapper<FuseEpiloguesPass, OperationPass<func::FuncOp>> {
+public:
+    MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(FuseEpiloguesPass)
+
+    llvm::StringRef getArgument() const final {
+        return "tc-fuse-epilogues";
+    }
+
+    llvm::StringRef getDescription() const final {
+        return "Fuse elementwise epilogues into the loop nest of their producer";
+    }
+
+    void getDependentDialects(DialectRegistry &registry) const override {
+        registry.insert<affine::AffineDialect, arith::ArithDialect,
+                        linalg::LinalgDialect, scf::SCFDialect,
+                        tensor::TensorDialect>();
+    }
+
+    void runOnOperation() override {
+        func::FuncOp func = getOperation();
+        MLIRContext *ctx = &getContext();
+
+        RewritePatternSet patterns(ctx);
+        linalg::ControlFusionFn fuseSingleUse = [](OpOperand *fusedOperand) {
+            Operation *producer = fusedOperand->get().getDefiningOp();
+            return producer && producer->hasOneUse();
+        };
+        linalg::populateElementwiseOpsFusionPatterns(patterns, fuseSingleUse);
+        if (failed(applyPatternsAndFoldGreedily(func, std::move(patterns)))) {
+            return signalPassFailure();
+        }
+
+        llvm::SmallVector<linalg::GenericOp> anchors;
+        func.walk([&](linalg::GenericOp op) {
+            if (isEpilogueAnchor(op)) {
+                anchors.push_back(op);
+            }
+        });
+
+        IRRewriter rewriter(ctx);
+        for (linalg::GenericOp anchor : anchors) {
+            fuseIntoTiles(anchor, rewriter);
+        }
+    }
+
+private:
+    static void fuseIntoTiles(linalg::GenericOp anchor, IRRewriter &rewriter) {
+        auto tileSizes = epilogueTileSizes(anchor);
+        if (!tileSizes) {
+            return;
+        }
+
+        scf::SCFTilingOptions tilingOptions;
+        tilingOptions.setTileSizes(
+            getAsIndexOpFoldResult(rewriter.getContext(), *tileSizes));
+
+        llvm::DenseSet<Operation *> fusible =
+            collectFusibleProducers(anchor.getOperation());
+
+        scf::SCFTileAndFuseOptions options;
+        options.setTilingOptions(tilingOptions);
+        options.setFusionControlFn(
+            [&](tensor::ExtractSliceOp, OpResult producer, bool) {
+                return std::make_tuple(
+                    fusible.contains(producer.getOwner()), false);
+            });
+
+        rewriter.setInsertionPoint(anchor);
+        FailureOr<scf::SCFTileAndFuseResult> fused =
+            scf::tileConsumerAndFuseProducerGreedilyUsingSCFForOp(
+                rewriter, mlir::cast<TilingInterface>(anchor.getOperation()),
+                options);
+        if (failed(fused)) {
+            return;
+        }
+
+        // The epilogue loops only walk parallel dimensions.
+        if (!fused->loops.empty()) {
+            fused->loops.front()->setAttr(kParallelLoopAttrName,
+                                          rewriter.getUnitAttr());
+        }
+
+        for (OpResult result : anchor->getResults()) {
+            auto it = fused->replacements.find(result);
+            if (it != fused->replacements.end()) {
+                rewriter.replaceAllUsesWith(result, it->second);
+            }
+        }
+        if (anchor->use_empty()) {
+            rewriter.eraseOp(anchor);
+        }
+    }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> createFuseEpiloguesPass() {
+    return std::make_unique<FuseEpiloguesPass>();
+}
+
+} // namespace tensor_compiler
@@ -1,54 +1,244 @@
 #include "Lowering/LLVMToASM.h"
 
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/MC/TargetRegistry.h"
+#include "llvm/Object/ArchiveWriter.h"
+#include "llvm/Passes/OptimizationLevel.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Program.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/CodeGen/CommandFlags.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Error.h"
+#include "llvm/TargetParser/Host.h"
+#include "llvm/TargetParser/SubtargetFeature.h"
 #include "llvm/TargetParser/Triple.h"
 
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 using namespace mlir;
 
 namespace tensor_compiler {
 
-LogicalResult generateAssembly(llvm::Module *llvmModule,
-                                      const std::string &triple,
-                                      unsigned optLevel,
-                                      llvm::raw_pwrite_stream &os) {
-  llvm::InitializeAllTargetInfos();
-  llvm::InitializeAllTargets();
-  llvm::InitializeAllTargetMCs();
-  llvm::InitializeAllAsmParsers();
-  llvm::InitializeAllAsmPrinters();
+namespace {
+
+void initializeTargets() {
+  static const bool initialized = [] {
+    llvm::InitializeAllTargetInfos();
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmParsers();
+    llvm::InitializeAllAsmPrinters();
+    return true;
+  }();
+  (void)initialized;
+}
+
+llvm::CodeGenOptLevel toCodeGenOptLevel(unsigned optLevel) {
+  switch (optLevel) {
+  case 0:
+    return llvm::CodeGenOptLevel::None;
+  case 1:
+    return llvm::CodeGenOptLevel::Less;
+  case 2:
+    return llvm::CodeGenOptLevel::Default;
+  default:
+    return llvm::CodeGenOptLevel::Aggressive;
+  }
+}
+
+llvm::OptimizationLevel toOptimizationLevel(unsigned optLevel) {
+  switch (optLevel) {
+  case 0:
+    return llvm::OptimizationLevel::O0;
+  case 1:
+    return llvm::OptimizationLevel::O1;
+  case 2:
+    return llvm::OptimizationLevel::O2;
+  default:
+    return llvm::OptimizationLevel::O3;
+  }
+}
+
+// Runs the new pass manager default pipeline for the given -O level, the same
+// mid-end clang runs before codegen (inlining, LICM, unrolling, loop and SLP
+// vectorization at O2 and above).
+void optimizeModule(llvm::Module &module, llvm::TargetMachine &TM,
+                    unsigned optLevel) {
+  llvm::LoopAnalysisManager LAM;
+  llvm::FunctionAnalysisManager FAM;
+  llvm::CGSCCAnalysisManager CGAM;
+  llvm::ModuleAnalysisManager MAM;
+
+  llvm::PipelineTuningOptions tuning;
+  tuning.LoopUnrolling = optLevel >= 1;
+  tuning.LoopVectorization = optLevel >= 2;
+  tuning.SLPVectorization = optLevel >= 2;
+
+  llvm::PassBuilder PB(&TM, tuning);
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  const llvm::OptimizationLevel level = toOptimizationLevel(optLevel);
+  llvm::ModulePassManager MPM = optLevel == 0
+                                    ? PB.buildO0DefaultPipeline(level)
+                                    : PB.buildPerModuleDefaultPipeline(level);
+  MPM.run(module, MAM);
+}
+
+// Runs program (`cc` or `ld`) from PATH to produce outputFile.
+LogicalResult runLinker(llvm::StringRef program,
+                        llvm::ArrayRef<llvm::StringRef> arguments,
+                        llvm::StringRef outputFile) {
+  llvm::ErrorOr<std::string> linker = llvm::sys::findProgramByName(program);
+  if (!linker) {
+    llvm::errs() << "Error: '" << program << "' not found in PATH\n";
+    return failure();
+  }
+
+  llvm::SmallVector<llvm::StringRef> args = {*linker};
+  args.append(arguments.begin(), arguments.end());
 
   std::string error;
+  int status = llvm::sys::ExecuteAndWait(*linker, args, std::nullopt, {},
+                                         /*SecondsToWait=*/0,
+                                         /*MemoryLimit=*/0, &error);
+  if (status != 0) {
+    llvm::errs() << "Error: linking " << outputFile << " failed";
+    if (!error.empty()) {
+      llvm::errs() << ": " << error;
+    }
+    llvm::errs() << "\n";
+    return failure();
+  }
+  return success();
+}
 
-  std::string targetTripleStr = triple.empty() ? llvmModule->getTargetTriple() : triple;
-  llvm::Triple targetTriple(targetTripleStr);
+// Most partitions for codegen. splitCodeGen never splits a function, so
+// there are at most as many as definitions: the entry point, one function
+// per layer and the outlined parallel loop bodies.
+unsigned partitionLimit(const llvm::Module &module) {
+  unsigned definitions = 0;
+  for (const llvm::Function &function : module) {
+    if (!function.isDeclaration()) {
+      ++definitions;
+    }
+  }
+  return std::max(1u, definitions);
+}
 
-  const llvm::Target *target = llvm::TargetRegistry::lookupTarget(
+} // namespace
+
+TargetSpec resolveTargetSpec(const std::string &triple, const std::string &cpu,
+                             const std::string &features) {
+  TargetSpec target{triple, cpu, features};
+  if (cpu != "native") {
+    return target;
+  }
+
+  target.cpu = llvm::sys::getHostCPUName().str();
+
+  llvm::SubtargetFeatures hostFeatures;
+  llvm::StringMap<bool> hostFeatureMap;
+  if (llvm::sys::getHostCPUFeatures(hostFeatureMap)) {
+    for (const auto &feature : hostFeatureMap) {
+      hostFeatures.AddFeature(feature.first(), feature.second);
+    }
+  }
+  // Later entries win, so explicit -mattr overrides what the host reports.
+  for (const std::string &feature :
+       llvm::SubtargetFeatures(features).getFeatures()) {
+    hostFeatures.AddFeature(feature);
+  }
+  target.features = hostFeatures.getString();
+  return target;
+}
+
+std::optional<int64_t> getVectorWidth(const TargetSpec &target) {
+  initializeTargets();
+
+  std::string error;
+  const llvm::Target *llvmTarget =
+      llvm::TargetRegistry::lookupTarget(target.triple, error);
+  if (!llvmTarget) {
+    return std::nullopt;
+  }
+
+  std::unique_ptr<llvm::MCSubtargetInfo> STI(
+      llvmTarget->createMCSubtargetInfo(target.triple, target.cpu,
+                                        target.features));
+  if (!STI) {
+    return std::nullopt;
+  }
+
+  if (llvm::Triple(target.triple).isX86()) {
+    if (STI->checkFeatures("+avx512f")) {
+      return 16;
+    }
+    if (STI->checkFeatures("+avx")) {
+      return 8;
+    }
+  }
+  // SSE2, NEON and most other SIMD units hold 128 bits.
+  return 4;
+}
+
+LogicalResult generateCode(llvm::Module *llvmModule, const TargetSpec &target,
+                           unsigned optLevel, CodeGenFile fileKind,
+                           llvm::raw_pwrite_stream &os, unsigned threads) {
+  initializeTargets();
+
+  if (optLevel > 3) {
+    llvm::errs() << "Error: Invalid optimization level: -O" << optLevel << "\n";
+    return failure();
+  }
+
+  std::string error;
+
+  std::string targetTripleStr =
+      target.triple.empty() ? llvmModule->getTargetTriple() : target.triple;
+
+  const llvm::Target *llvmTarget = llvm::TargetRegistry::lookupTarget(
       targetTripleStr, error);
-  if (!target) {
+  if (!llvmTarget) {
     llvm::errs() << "Error: " << error << "\n";
     return failure();
   }
 
-  llvm::TargetOptions opt;
-  auto RM = std::optional<llvm::Reloc::Model>(llvm::Reloc::PIC_);
+  // Archive members are compiled by TargetMachines of their own.
+  auto createTargetMachine = [&]() {
+    llvm::TargetOptions opt;
+    auto RM = std::optional<llvm::Reloc::Model>(llvm::Reloc::PIC_);
+    return std::unique_ptr<llvm::TargetMachine>(
+        llvmTarget->createTargetMachine(targetTripleStr,
+                                  target.cpu,
+                                  target.features,
+                                  opt,
+                                  RM,
+                                  /*CM=*/std::nullopt,
+                                  toCodeGenOptLevel(optLevel)));
+  };
 
-  std::unique_ptr<llvm::TargetMachine> TM(
-      target->createTargetMachine(targetTripleStr,
-                                /*CPU=*/"",
-                                /*Features=*/"",
-                                opt,
-                                RM));
+  std::unique_ptr<llvm::TargetMachine> TM = createTargetMachine();
   if (!TM) {
     llvm::errs() << "Error: Could not create TargetMachine\n";
     return failure();
@@ -57,16 +247,107 @@ LogicalResult generateAssembly(llvm::Module *llvmModule,
   llvmModule->setDataLayout(TM->createDataLayout());
   llvmModule->setTargetTriple(targetTripleStr);
 
-  llvm::legacy::PassManager PM;
-  llvm::CodeGenFileType fileType = llvm::CodeGenFileType::AssemblyFile;
+  optimizeModule(*llvmModule, *TM, optLevel);
 
-  if (TM->addPassesToEmitFile(PM, os, nullptr, fileType)) {
-    llvm::errs() << "Error: Target does not support assembly emission\n";
-    return failure();
+  llvm::CodeGenFileType fileType = fileKind == CodeGenFile::assembly
+                                       ? llvm::CodeGenFileType::AssemblyFile
+                                       : llvm::CodeGenFileType::ObjectFile;
+  auto addEmitPasses = [&](llvm::legacy::PassManager &PM,
+                           llvm::raw_pwrite_stream &stream) {
+    if (TM->addPassesToEmitFile(PM, stream, nullptr, fileType)) {
+      llvm::errs() << "Error: Target does not support "
+                   << (fileKind == CodeGenFile::assembly ? "assembly"
+                                                         : "object")
+                   << " emission\n";
+      return false;
+    }
+    return true;
+  };
+
+  if (fileKind != CodeGenFile::archive) {
+    llvm::legacy::PassManager PM;
+    if (!addEmitPasses(PM, os)) {
+      return failure();
+    }
+    PM.run(*llvmModule);
+    return success();
   }
 
-  PM.run(*llvmModule);
+  const unsigned partitions =
+      std::max(1u, std::min(threads, partitionLimit(*llvmModule)));
+  if (threads > 1 && partitions == 1) {
+    llvm::errs() << "Warning: code generation runs on one thread: the module "
+                    "defines a single function\n";
+  }
+
+  {
+    // splitCodeGen aborts if a partition cannot be emitted, so check once.
+    llvm::legacy::PassManager PM;
+    llvm::SmallString<0> scratch;
+    llvm::raw_svector_ostream scratchStream(scratch);
+    if (!addEmitPasses(PM, scratchStream)) {
+      return failure();
+    }
+  }
+
+  // Each partition is emitted into a buffer on a thread of its own.
+  std::vector<llvm::SmallString<0>> buffers(partitions);
+  std::vector<std::unique_ptr<llvm::raw_svector_ostream>> streams;
+  std::vector<llvm::raw_pwrite_stream *> outputs;
+  for (llvm::SmallString<0> &buffer : buffers) {
+    streams.push_back(std::make_unique<llvm::raw_svector_ostream>(buffer));
+    outputs.push_back(streams.back().get());
+  }
+  llvm::splitCodeGen(*llvmModule, outputs, /*BCOSs=*/{}, createTargetMachine,
+                     fileType);
+
+  // The members are named after their partition; the archive is
+  // deterministic, so equal modules give byte-identical files.
+  std::vector<std::string> names;
+  for (unsigned i = 0; i < partitions; ++i) {
+    names.push_back("partition" + std::to_string(i) + ".o");
+  }
+  std::vector<llvm::NewArchiveMember> members;
+  for (unsigned i = 0; i < partitions; ++i) {
+    members.emplace_back(llvm::MemoryBufferRef(buffers[i], names[i]));
+  }
+  auto archive = llvm::writeArchiveToBuffer(
+      members, llvm::SymtabWritingMode::NormalSymtab,
+      llvm::object::Archive::K_GNU, /*Deterministic=*/true, /*Thin=*/false);
+  if (!archive) {
+    llvm::errs() << "Error: cannot write object archive: "
+                 << llvm::toString(archive.takeError()) << "\n";
+    return failure();
+  }
+  os << (*archive)->getBuffer();
   return success();
 }
 
+LogicalResult generateAssembly(llvm::Module *llvmModule,
+                               const TargetSpec &target, unsigned optLevel,
+                               llvm::raw_pwrite_stream &os) {
+  return generateCode(llvmModule, target, optLevel, CodeGenFile::assembly, os);
+}
+
+LogicalResult linkSharedLibrary(const std::string &objectFile,
+                                const std::string &runtimeLibrary,
+                                const std::string &outputFile) {
+  // The runtime archive is linked whole: nothing in the model object
+  // references tensorCompForward, yet it must be exported. So is a model
+  // archive, whose partitions nothing may reference either.
+  return runLinker("cc",
+                   {"-shared", "-o", outputFile, "-Wl,--whole-archive",
+                    objectFile, runtimeLibrary, "-Wl,--no-whole-archive",
+                    "-lpthread", "-lm"},
+                   outputFile);
+}
+
+LogicalResult linkRelocatableObject(const std::string &archiveFile,
+                                    const std::string &outputFile) {
+  return runLinker("ld",
+                   {"-r", "-o", outputFile, "--whole-archive", archiveFile,
+                    "--no-whole-archive"},
+                   outputFile);
+}
+
 } // namespace tensor_compiler
@@ -1,4 +1,7 @@
 #include "Lowering/LLVMToLLVMIR.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/Module.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "llvm/Support/raw_ostream.h"
@@ -33,4 +36,40 @@ std::unique_ptr<llvm::Module> LLVMToLLVMIR(
     return llvmModule;
 }
 
+void embedWeights(llvm::Module &llvmModule, const WeightsBlob &weights) {
+    if (weights.empty()) {
+        return;
+    }
+
+    llvm::LLVMContext &ctx = llvmModule.getContext();
+    llvm::Type *i8Type = llvm::Type::getInt8Ty(ctx);
+    llvm::Type *i64Type = llvm::Type::getInt64Ty(ctx);
+    llvm::StringRef bytes(weights.data().data(), weights.data().size());
+
+    llvm::Constant *data =
+        llvm::ConstantDataArray::getRaw(bytes, bytes.size(), i8Type);
+    auto *base = new llvm::GlobalVariable(
+        llvmModule, data->getType(), /*isConstant=*/true,
+        llvm::GlobalValue::PrivateLinkage, data, kWeightsBaseSymbol);
+    base->setAlignment(llvm::Align(kWeightsAlignment));
+
+    for (const WeightsBlob::Entry &entry : weights.entries()) {
+        // Constants that canonicalization folded away have no declaration.
+        llvm::GlobalVariable *decl =
+            llvmModule.getGlobalVariable(entry.symbol);
+        if (!decl || !decl->isDeclaration()) {
+            continue;
+        }
+
+        llvm::Constant *address = llvm::ConstantExpr::getInBoundsGetElementPtr(
+            i8Type, base, llvm::ConstantInt::get(i64Type, entry.offset));
+        auto *alias = llvm::GlobalAlias::create(
+            decl->getValueType(), decl->getAddressSpace(),
+            llvm::GlobalValue::PrivateLinkage, "", address, &llvmModule);
+        decl->replaceAllUsesWith(alias);
+        alias->takeName(decl);
+        decl->eraseFromParent();
+    }
+}
+
 } // namespace tensor_compiler
@@ -1,4 +1,9 @@
 #include "Lowering/MLIRToLLVM.h"
+#include "Lowering/Fusion.h"
+#include "Lowering/MemoryPlanner.h"
+#include "Lowering/OutlineLayers.h"
+#include "Lowering/ParallelLoops.h"
+#include "Lowering/TileAndVectorize.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/Pass/PassManager.h"
@@ -31,12 +36,56 @@
 #include "mlir/Conversion/LLVMCommon/ConversionTarget.h"
 #include "mlir/Conversion/LLVMCommon/TypeConverter.h"
 #include "mlir/Conversion/FuncToLLVM/ConvertFuncToLLVMPass.h"
+#include "mlir/Dialect/Arith/Transforms/BufferizableOpInterfaceImpl.h"
+#include "mlir/Dialect/Bufferization/Transforms/FuncBufferizableOpInterfaceImpl.h"
+#include "mlir/Dialect/ControlFlow/Transforms/BufferizableOpInterfaceImpl.h"
+#include "mlir/Dialect/Linalg/Transforms/BufferizableOpInterfaceImpl.h"
+#include "mlir/Dialect/Linalg/Transforms/TilingInterfaceImpl.h"
+#include "mlir/Dialect/SCF/Transforms/BufferizableOpInterfaceImpl.h"
+#include "mlir/Dialect/Tensor/IR/TensorInferTypeOpInterfaceImpl.h"
+#include "mlir/Dialect/Tensor/IR/TensorTilingInterfaceImpl.h"
+#include "mlir/Dialect/Tensor/Transforms/BufferizableOpInterfaceImpl.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/Dialect/Vector/Transforms/BufferizableOpInterfaceImpl.h"
+#include "mlir/Target/LLVMIR/Dialect/Builtin/BuiltinToLLVMIRTranslation.h"
+#include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
 
 using namespace mlir;
 
 namespace tensor_compiler {
-LogicalResult MLIRToLLVM(MLIRContext &context,
-                        OwningOpRef<ModuleOp> &mlirModule) {
+void registerCompilerDialects(MLIRContext &context) {
+    DialectRegistry registry;
+    registry.insert<func::FuncDialect>();
+    registry.insert<arith::ArithDialect>();
+    registry.insert<tensor::TensorDialect>();
+    registry.insert<linalg::LinalgDialect>();
+    registry.insert<scf::SCFDialect>();
+    registry.insert<memref::MemRefDialect>();
+    registry.insert<math::MathDialect>();
+    registry.insert<cf::ControlFlowDialect>();
+    registry.insert<LLVM::LLVMDialect>();
+    registry.insert<bufferization::BufferizationDialect>();
+    registry.insert<vector::VectorDialect>();
+    arith::registerBufferizableOpInterfaceExternalModels(registry);
+    bufferization::func_ext::registerBufferizableOpInterfaceExternalModels(
+        registry);
+    cf::registerBufferizableOpInterfaceExternalModels(registry);
+    linalg::registerBufferizableOpInterfaceExternalModels(registry);
+    linalg::registerTilingInterfaceExternalModels(registry);
+    scf::registerBufferizableOpInterfaceExternalModels(registry);
+    tensor::registerInferTypeOpInterfaceExternalModels(registry);
+    tensor::registerTilingInterfaceExternalModels(registry);
+    tensor::registerBufferizableOpInterfaceExternalModels(registry);
+    vector::registerBufferizableOpInterfaceExternalModels(registry);
+    context.appendDialectRegistry(registry);
+    context.loadAllAvailableDialects();
+    registerBuiltinDialectTranslation(context);
+    registerLLVMDialectTranslation(context);
+}
+
+LogicalResult optimizeTensorIR(MLIRContext &context,
+                               OwningOpRef<ModuleOp> &mlirModule,
+                               const LoweringOptions &options) {
     if (!mlirModule) {
         llvm::errs() << "Error: Received null MLIR module\n";
         return failure();
@@ -49,14 +98,62 @@ LogicalResult MLIRToLLVM(MLIRContext &context,
 
     pm.addNestedPass<func::FuncOp>(createConvertElementwiseToLinalgPass());
 
+    if (options.fuse) {
+        pm.addNestedPass<func::FuncOp>(createFuseEpiloguesPass());
+        pm.addPass(createCanonicalizerPass());
+        pm.addPass(createCSEPass());
+    }
+
+    if (options.pipeline == Pipeline::vectorized) {
+        TileAndVectorizeOptions tileOptions;
+        tileOptions.vectorWidth = options.vectorWidth;
+        pm.addNestedPass<func::FuncOp>(createTileAndVectorizePass(tileOptions));
+        pm.addPass(createCanonicalizerPass());
+        pm.addPass(createCSEPass());
+    }
+
+    if (failed(pm.run(*mlirModule))) {
+        llvm::errs() << "=== FAILED: tensor optimization ===\n";
+        mlirModule->print(llvm::errs());
+        return failure();
+    }
+
+    return success();
+}
+
+LogicalResult MLIRToLLVM(MLIRContext &context,
+                        OwningOpRef<ModuleOp> &mlirModule,
+                        const LoweringOptions &options) {
+    if (!mlirModule) {
+        llvm::errs() << "Error: Received null MLIR module\n";
+        return failure();
+    }
+
+    PassManager pm(&context);
+
+    const bool vectorized = options.pipeline == Pipeline::vectorized;
+
     bufferization::OneShotBufferizationOptions bufferizationOptions;
     bufferizationOptions.bufferizeFunctionBoundaries = true;
     bufferizationOptions.setFunctionBoundaryTypeConversion(
         bufferization::LayoutMapOption::IdentityLayoutMap);
 
     pm.addPass(bufferization::createOneShotBufferizePass(bufferizationOptions));
-
-    pm.addNestedPass<func::FuncOp>(createConvertLinalgToLoopsPass());
+    pm.addPass(createMemoryPlannerPass());
+    // One function per layer, so codegen can split the module by layer.
+    pm.addPass(createOutlineLayersPass());
+
+    // Whatever the vectorizer left behind still goes through scalar loops.
+    if (options.parallel) {
+        pm.addNestedPass<func::FuncOp>(createConvertLinalgToParallelLoopsPass());
+        pm.addPass(createCanonicalizerPass());
+        pm.addPass(createOutlineParallelLoopsPass());
+    } else {
+        pm.addNestedPass<func::FuncOp>(createConvertLinalgToLoopsPass());
+    }
+    if (vectorized) {
+        pm.addPass(createConvertVectorToSCFPass());
+    }
     pm.addPass(createConvertSCFToCFPass());
     pm.addPass(createLowerAffinePass());
 
@@ -68,6 +165,9 @@ LogicalResult MLIRToLLVM(MLIRContext &context,
     pm.addPass(createCanonicalizerPass());
     pm.addPass(createCSEPass());
 
+    if (vectorized) {
+        pm.addPass(createConvertVectorToLLVMPass());
+    }
     pm.addPass(createConvertMathToLLVMPass());
     pm.addPass(createArithToLLVMConversionPass());
     pm.addPass(createFinalizeMemRefToLLVMConversionPass());
@@ -78,6 +178,7 @@ LogicalResult MLIRToLLVM(MLIRContext &context,
 
     pm.addPass(mlir::createConvertFuncToLLVMPass(funcOptions));
     pm.addPass(createConvertIndexToLLVMPass());
+    pm.addPass(createReconcileUnrealizedCastsPass());
 
     pm.addPass(createCanonicalizerPass());
     pm.addPass(createCSEPass());
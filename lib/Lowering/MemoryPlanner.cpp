@@ -0,0 +1,235 @@
+#include "Lowering/MemoryPlanner.h"
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Pass/Pass.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MathExtras.h"
+
+#include <algorithm>
+#include <optional>
+
+using namespace mlir;
+
+namespace tensor_compiler {
+
+namespace {
+
+constexpr const char *kEntryFuncName = "tensorCompForwardImpl";
+
+struct Buffer {
+    memref::AllocOp alloc;
+    llvm::SmallVector<Operation *> deallocs;
+    int64_t size = 0;
+    // Indices of the first and last top-level op touching the buffer.
+    size_t begin = 0;
+    size_t end = 0;
+    int64_t offset = 0;
+};
+
+std::optional<int64_t> getAllocSize(MemRefType type) {
+    if (!type.hasStaticShape() || !type.getLayout().isIdentity() ||
+        type.getMemorySpace()) {
+        return std::nullopt;
+    }
+    Type elementType = type.getElementType();
+    if (!elementType.isIntOrFloat()) {
+        return std::nullopt;
+    }
+    int64_t elementBytes = (elementType.getIntOrFloatBitWidth() + 7) / 8;
+    return type.getNumElements() * elementBytes;
+}
+
+// Follows every value aliasing the allocation: results of view-like ops,
+// of loops yielding it, of anything taking it and returning a memref. The
+// live range covers the top-level ops containing any of their uses.
+bool computeLiveRange(Buffer &buffer, Block &block,
+                      const llvm::DenseMap<Operation *, size_t> &index) {
+    llvm::SmallVector<Value> worklist = {buffer.alloc.getResult()};
+    llvm::DenseSet<Value> visited;
+    bool used = false;
+
+    while (!worklist.empty()) {
+        Value value = worklist.pop_back_val();
+        if (!visited.insert(value).second) {
+            continue;
+        }
+
+        for (OpOperand &use : value.getUses()) {
+            Operation *user = use.getOwner();
+            if (mlir::isa<memref::DeallocOp>(user)) {
+                buffer.deallocs.push_back(user);
+                continue;
+            }
+            if (mlir::isa<func::ReturnOp>(user)) {
+                return false;
+            }
+
+            Operation *top = block.findAncestorOpInBlock(*user);
+            if (!top) {
+                return false;
+            }
+            size_t position = index.lookup(top);
+            buffer.begin = used ? std::min(buffer.begin, position) : position;
+            buffer.end = used ? std::max(buffer.end, position) : position;
+            used = true;
+
+            for (Operation *op = user;; op = op->getParentOp()) {
+                for (Value result : op->getResults()) {
+                    if (mlir::isa<BaseMemRefType>(result.getType())) {
+                        worklist.push_back(result);
+                    }
+                }
+                if (op == top) {
+                    break;
+                }
+            }
+        }
+    }
+
+    // A buffer nobody touches still needs a slot for the view to point at.
+    if (!used) {
+        buffer.begin = buffer.end = index.lookup(buffer.alloc);
+    }
+    return true;
+}
+
+// Greedy by size: larger buffers are placed first, each at the lowest
+// aligned offset not overlapping a placed buffer with an intersecting live
+// range. Returns the arena size.
+int64_t assignOffsets(llvm::MutableArrayRef<Buffer> buffers) {
+    llvm::SmallVector<Buffer *> order;
+    for (Buffer &buffer : buffers) {
+        order.push_back(&buffer);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [](const Buffer *lhs, const Buffer *rhs) {
+                         return lhs->size > rhs->size;
+                     });
+
+    int64_t arenaSize = 0;
+    llvm::SmallVector<Buffer *> placed;
+    for (Buffer *buffer : order) {
+        llvm::SmallVector<Buffer *> conflicts;
+        for (Buffer *other : placed) {
+            if (other->begin <= buffer->end && buffer->begin <= other->end) {
+                conflicts.push_back(other);
+            }
+        }
+        llvm::sort(conflicts, [](const Buffer *lhs, const Buffer *rhs) {
+            return lhs->offset < rhs->offset;
+        });
+
+        int64_t offset = 0;
+        for (Buffer *other : conflicts) {
+            if (offset + buffer->size <= other->offset) {
+                break;
+            }
+            offset = std::max<int64_t>(
+                offset, llvm::alignTo(other->offset + other->size,
+                                      kWorkspaceAlignment));
+        }
+
+        buffer->offset = offset;
+        arenaSize = std::max(arenaSize, offset + buffer->size);
+        placed.push_back(buffer);
+    }
+    return llvm::alignTo(arenaSize, kWorkspaceAlignment);
+}
+
+class MemoryPlannerPass
+    : public PassWrapper<MemoryPlannerPass, OperationPass<ModuleOp>> {
+public:
+    MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(MemoryPlannerPass)
+
+    llvm::StringRef getArgument() const final {
+        return "tc-memory-planner";
+    }
+
+    llvm::StringRef getDescription() const final {
+        return "Place intermediate buffers into one caller-provided workspace";
+    }
+
+    void getDependentDialects(DialectRegistry &registry) const override {
+        registry.insert<arith::ArithDialect, func::FuncDialect,
+                        memref::MemRefDialect>();
+    }
+
+    void runOnOperation() override {
+        ModuleOp module = getOperation();
+        auto func = module.lookupSymbol<func::FuncOp>(kEntryFuncName);
+        if (!func || func.isExternal()) {
+            return;
+        }
+
+        Block &block = func.getBody().front();
+        llvm::DenseMap<Operation *, size_t> index;
+        for (auto [position, op] : llvm::enumerate(block)) {
+            index[&op] = position;
+        }
+
+        llvm::SmallVector<Buffer> buffers;
+        for (auto alloc : block.getOps<memref::AllocOp>()) {
+            std::optional<int64_t> size = getAllocSize(alloc.getType());
+            if (!size) {
+                continue;
+            }
+            Buffer buffer;
+            buffer.alloc = alloc;
+            buffer.size = *size;
+            if (computeLiveRange(buffer, block, index)) {
+                buffers.push_back(std::move(buffer));
+            }
+        }
+
+        int64_t arenaSize = assignOffsets(buffers);
+
+        MLIRContext *ctx = &getContext();
+        Location loc = func.getLoc();
+        OpBuilder builder(ctx);
+
+        auto workspaceType =
+            MemRefType::get({arenaSize}, builder.getIntegerType(8));
+        func.insertArgument(func.getNumArguments(), workspaceType,
+                            DictionaryAttr::get(ctx), loc);
+        Value workspace = func.getArgument(func.getNumArguments() - 1);
+
+        for (Buffer &buffer : buffers) {
+            for (Operation *dealloc : buffer.deallocs) {
+                dealloc->erase();
+            }
+            builder.setInsertionPoint(buffer.alloc);
+            Value offset = builder.create<arith::ConstantIndexOp>(
+                buffer.alloc.getLoc(), buffer.offset);
+            Value view = builder.create<memref::ViewOp>(
+                buffer.alloc.getLoc(), buffer.alloc.getType(), workspace,
+                offset, ValueRange{});
+            buffer.alloc.getResult().replaceAllUsesWith(view);
+            buffer.alloc.erase();
+        }
+
+        builder.setInsertionPointToEnd(module.getBody());
+        auto sizeFunc = builder.create<func::FuncOp>(
+            loc, kWorkspaceSizeFuncName,
+            builder.getFunctionType({}, {builder.getI64Type()}));
+        builder.setInsertionPointToStart(sizeFunc.addEntryBlock());
+        Value size = builder.create<arith::ConstantOp>(
+            loc, builder.getI64IntegerAttr(arenaSize));
+        builder.create<func::ReturnOp>(loc, size);
+    }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> createMemoryPlannerPass() {
+    return std::make_unique<MemoryPlannerPass>();
+}
+
+} // namespace tensor_compiler
@@ -0,0 +1,173 @@
+#include "Lowering/OutlineLayers.h"
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/IRMapping.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/RegionUtils.h"
+
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include <optional>
+
+using namespace mlir;
+
+namespace tensor_compiler {
+
+namespace {
+
+constexpr const char *kEntryFuncName = "tensorCompForwardImpl";
+constexpr const char *kLayerName = "tensorCompLayer";
+
+// Values a layer needs from the entry function. Pure producers (constants,
+// views, globals) are re-materialized inside so the arguments keep the
+// bare pointer calling convention: static identity memrefs and scalars.
+struct Captures {
+    llvm::SetVector<Value> arguments;
+    llvm::SetVector<Operation *> sunk;
+};
+
+bool isArgumentType(Type type) {
+    if (auto memref = mlir::dyn_cast<MemRefType>(type)) {
+        return memref.hasStaticShape() && memref.getLayout().isIdentity() &&
+               !memref.getMemorySpace();
+    }
+    return type.isIntOrIndexOrFloat();
+}
+
+bool capture(Value value, Captures &captures) {
+    if (captures.arguments.contains(value)) {
+        return true;
+    }
+
+    Operation *def = value.getDefiningOp();
+    if (def && isPure(def) && def->getNumRegions() == 0) {
+        if (captures.sunk.contains(def)) {
+            return true;
+        }
+        for (Value operand : def->getOperands()) {
+            if (!capture(operand, captures)) {
+                return false;
+            }
+        }
+        captures.sunk.insert(def);
+        return true;
+    }
+
+    if (!isArgumentType(value.getType())) {
+        return false;
+    }
+    captures.arguments.insert(value);
+    return true;
+}
+
+std::optional<Captures> collectCaptures(Operation *layer) {
+    llvm::SetVector<Value> used;
+    for (Region &region : layer->getRegions()) {
+        getUsedValuesDefinedAbove(region, used);
+    }
+    used.insert(layer->operand_begin(), layer->operand_end());
+
+    Captures captures;
+    for (Value value : used) {
+        if (!capture(value, captures)) {
+            return std::nullopt;
+        }
+    }
+    return captures;
+}
+
+class OutlineLayersPass
+    : public PassWrapper<OutlineLayersPass, OperationPass<ModuleOp>> {
+public:
+    MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(OutlineLayersPass)
+
+    llvm::StringRef getArgument() const final {
+        return "tc-outline-layers";
+    }
+
+    llvm::StringRef getDescription() const final {
+        return "Outline the layers of the entry function into functions";
+    }
+
+    void getDependentDialects(DialectRegistry &registry) const override {
+        registry.insert<func::FuncDialect, memref::MemRefDialect>();
+    }
+
+    void runOnOperation() override {
+        ModuleOp module = getOperation();
+        auto func = module.lookupSymbol<func::FuncOp>(kEntryFuncName);
+        if (!func || func.isExternal()) {
+            return;
+        }
+
+        llvm::SmallVector<Operation *> layers;
+        for (Operation &op : func.getBody().getOps()) {
+            if (op.getNumRegions() != 0 && op.getNumResults() == 0) {
+                layers.push_back(&op);
+            }
+        }
+
+        SymbolTable symbolTable(module);
+        for (Operation *layer : layers) {
+            outline(layer, symbolTable);
+        }
+    }
+
+private:
+    void outline(Operation *layer, SymbolTable &symbolTable) {
+        std::optional<Captures> captures = collectCaptures(layer);
+        if (!captures) {
+            return;
+        }
+
+        MLIRContext *ctx = &getContext();
+        Location loc = layer->getLoc();
+        OpBuilder builder(ctx);
+
+        llvm::SmallVector<Type> argumentTypes;
+        for (Value argument : captures->arguments) {
+            argumentTypes.push_back(argument.getType());
+        }
+        auto function = func::FuncOp::create(
+            loc, kLayerName, builder.getFunctionType(argumentTypes, {}));
+        function.setPrivate();
+        // LLVM would inline a function with a single call site back into
+        // the entry point.
+        function->setAttr(
+            "passthrough",
+            builder.getArrayAttr({builder.getStringAttr("noinline")}));
+        symbolTable.insert(function);
+
+        Block *entry = function.addEntryBlock();
+        builder.setInsertionPointToStart(entry);
+        IRMapping mapping;
+        for (auto [argument, value] :
+             llvm::zip(entry->getArguments(), captures->arguments)) {
+            mapping.map(value, argument);
+        }
+        for (Operation *op : captures->sunk) {
+            builder.clone(*op, mapping);
+        }
+        builder.clone(*layer, mapping);
+        builder.create<func::ReturnOp>(loc);
+
+        builder.setInsertionPoint(layer);
+        builder.create<func::CallOp>(loc, function,
+                                     captures->arguments.getArrayRef());
+        layer->erase();
+    }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> createOutlineLayersPass() {
+    return std::make_unique<OutlineLayersPass>();
+}
+
+} // namespace tensor_compiler
@@ -0,0 +1,339 @@
+#include "Lowering/ParallelLoops.h"
+
+#include "mlir/Conversion/LLVMCommon/MemRefBuilder.h"
+#include "mlir/Conversion/LLVMCommon/TypeConverter.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/IRMapping.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/RegionUtils.h"
+
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include <algorithm>
+#include <optional>
+
+using namespace mlir;
+
+namespace tensor_compiler {
+
+namespace {
+
+constexpr const char *kRuntimeParallelFor = "tensorCompParallelFor";
+constexpr const char *kBodyName = "tensorCompParallelBody";
+
+// Values a loop body needs from the enclosing function. Memrefs travel as
+// raw pointers through the runtime context; pure scalar producers (mostly
+// constants) are re-materialized inside the outlined function.
+struct Captures {
+    llvm::SetVector<Value> memrefs;
+    llvm::SetVector<Operation *> sunk;
+};
+
+bool isPassableMemRef(MemRefType type) {
+    if (!type.hasStaticShape() || type.getMemorySpace()) {
+        return false;
+    }
+    llvm::SmallVector<int64_t> strides;
+    int64_t offset = 0;
+    if (failed(getStridesAndOffset(type, strides, offset))) {
+        return false;
+    }
+    return !ShapedType::isDynamic(offset) &&
+           llvm::none_of(strides, ShapedType::isDynamic);
+}
+
+bool capture(Value value, Captures &captures) {
+    if (captures.memrefs.contains(value)) {
+        return true;
+    }
+    if (auto type = mlir::dyn_cast<MemRefType>(value.getType())) {
+        if (!isPassableMemRef(type)) {
+            return false;
+        }
+        captures.memrefs.insert(value);
+        return true;
+    }
+
+    Operation *def = value.getDefiningOp();
+    if (!def || !isPure(def) || def->getNumRegions() != 0) {
+        return false;
+    }
+    if (captures.sunk.contains(def)) {
+        return true;
+    }
+    for (Value operand : def->getOperands()) {
+        if (!capture(operand, captures)) {
+            return false;
+        }
+    }
+    captures.sunk.insert(def);
+    return true;
+}
+
+std::optional<Captures> collectCaptures(Operation *loop,
+                                        llvm::ArrayRef<Value> extra) {
+    llvm::SetVector<Value> used;
+    getUsedValuesDefinedAbove(loop->getRegion(0), used);
+    used.insert(extra.begin(), extra.end());
+
+    Captures captures;
+    for (Value value : used) {
+        if (!capture(value, captures)) {
+            return std::nullopt;
+        }
+    }
+    return captures;
+}
+
+bool hasEnoughIterations(Value lb, Value ub, Value step) {
+    auto lbConst = getConstantIntValue(lb);
+    auto ubConst = getConstantIntValue(ub);
+    auto stepConst = getConstantIntValue(step);
+    if (!lbConst || !ubConst || !stepConst || *stepConst <= 0) {
+        return true;
+    }
+    return (*ubConst - *lbConst + *stepConst - 1) / *stepConst >= 2;
+}
+
+// Rebuilds a memref from the pointer stored in slot `slot` of the context.
+Value loadMemRef(OpBuilder &builder, Location loc,
+                 const LLVMTypeConverter &converter, Value context,
+                 int32_t slot, MemRefType type) {
+    auto ptrType = LLVM::LLVMPointerType::get(builder.getContext());
+    auto i64Type = builder.getI64Type();
+
+    Value address = builder.create<LLVM::GEPOp>(
+        loc, ptrType, i64Type, context, llvm::ArrayRef<LLVM::GEPArg>{slot});
+    Value raw = builder.create<LLVM::LoadOp>(loc, i64Type, address);
+    Value pointer = builder.create<LLVM::IntToPtrOp>(loc, ptrType, raw);
+
+    Value descriptor = MemRefDescriptor::fromStaticShape(
+        builder, loc, converter, type, pointer);
+    return builder.create<UnrealizedConversionCastOp>(loc, type, descriptor)
+        .getResult(0);
+}
+
+class OutlineParallelLoopsPass
+    : public PassWrapper<OutlineParallelLoopsPass, OperationPass<ModuleOp>> {
+public:
+    MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(OutlineParallelLoopsPass)
+
+    llvm::StringRef getArgument() const final {
+        return "tc-outline-parallel-loops";
+    }
+
+    llvm::StringRef getDescription() const final {
+        return "Outline top-level parallel loops into thread pool tasks";
+    }
+
+    void getDependentDialects(DialectRegistry &registry) const override {
+        registry.insert<arith::ArithDialect, func::FuncDialect,
+                        LLVM::LLVMDialect, memref::MemRefDialect,
+                        scf::SCFDialect>();
+    }
+
+    void runOnOperation() override {
+        ModuleOp module = getOperation();
+
+        llvm::SmallVector<Operation *> loops;
+        for (auto func : module.getOps<func::FuncOp>()) {
+            if (func.isExternal()) {
+                continue;
+            }
+            for (Operation &op : func.getBody().getOps()) {
+                if (isCandidate(&op)) {
+                    loops.push_back(&op);
+                }
+            }
+        }
+
+        if (loops.empty()) {
+            return;
+        }
+
+        SymbolTable symbolTable(module);
+        LLVMTypeConverter converter(&getContext());
+        for (Operation *loop : loops) {
+            outline(loop, symbolTable, converter);
+        }
+    }
+
+private:
+    static bool isCandidate(Operation *op) {
+        if (auto parallel = mlir::dyn_cast<scf::ParallelOp>(op)) {
+            return parallel.getNumResults() == 0;
+        }
+        if (auto forOp = mlir::dyn_cast<scf::ForOp>(op)) {
+            return forOp.getNumResults() == 0 &&
+                   forOp->hasAttr(kParallelLoopAttrName);
+        }
+        return false;
+    }
+
+    func::FuncOp getOrInsertRuntimeDecl(SymbolTable &symbolTable,
+                                        FunctionType bodyType) {
+        if (auto decl =
+                symbolTable.lookup<func::FuncOp>(kRuntimeParallelFor)) {
+            return decl;
+        }
+
+        OpBuilder builder(&getContext());
+        auto indexType = builder.getIndexType();
+        auto ptrType = LLVM::LLVMPointerType::get(&getContext());
+        auto type = builder.getFunctionType(
+            {bodyType, indexType, indexType, indexType, ptrType}, {});
+        auto decl = func::FuncOp::create(builder.getUnknownLoc(),
+                                         kRuntimeParallelFor, type);
+        decl.setPrivate();
+        symbolTable.insert(decl);
+        return decl;
+    }
+
+    void outline(Operation *loop, SymbolTable &symbolTable,
+                 const LLVMTypeConverter &converter) {
+        auto parallel = mlir::dyn_cast<scf::ParallelOp>(loop);
+        auto forOp = mlir::dyn_cast<scf::ForOp>(loop);
+
+        Value lb = parallel ? parallel.getLowerBound()[0]
+                            : forOp.getLowerBound();
+        Value ub = parallel ? parallel.getUpperBound()[0]
+                            : forOp.getUpperBound();
+        Value step = parallel ? parallel.getStep()[0] : forOp.getStep();
+        if (!hasEnoughIterations(lb, ub, step)) {
+            return;
+        }
+
+        // Everything except the distributed range must be rebuilt inside.
+        llvm::SmallVector<Value> extra = {step};
+        if (parallel) {
+            for (size_t d = 1; d < parallel.getNumLoops(); ++d) {
+                extra.push_back(parallel.getLowerBound()[d]);
+                extra.push_back(parallel.getUpperBound()[d]);
+                extra.push_back(parallel.getStep()[d]);
+            }
+        }
+
+        std::optional<Captures> captures = collectCaptures(loop, extra);
+        if (!captures) {
+            return;
+        }
+
+        MLIRContext *ctx = &getContext();
+        Location loc = loop->getLoc();
+        auto indexType = IndexType::get(ctx);
+        auto ptrType = LLVM::LLVMPointerType::get(ctx);
+        auto bodyType =
+            FunctionType::get(ctx, {indexType, indexType, ptrType}, {});
+
+        // ---- Outlined body: (begin, end, context) -> () ----
+        auto body = func::FuncOp::create(loc, kBodyName, bodyType);
+        body.setPrivate();
+        symbolTable.insert(body);
+
+        Block *entry = body.addEntryBlock();
+        OpBuilder builder = OpBuilder::atBlockBegin(entry);
+        IRMapping mapping;
+
+        for (auto [slot, memref] : llvm::enumerate(captures->memrefs)) {
+            mapping.map(memref,
+                        loadMemRef(builder, loc, converter,
+                                   entry->getArgument(2),
+                                   static_cast<int32_t>(slot),
+                                   mlir::cast<MemRefType>(memref.getType())));
+        }
+        for (Operation *op : captures->sunk) {
+            builder.clone(*op, mapping);
+        }
+
+        auto chunk = builder.create<scf::ForOp>(
+            loc, entry->getArgument(0), entry->getArgument(1),
+            mapping.lookup(step));
+        builder.setInsertionPointToStart(chunk.getBody());
+
+        if (forOp) {
+            mapping.map(forOp.getInductionVar(), chunk.getInductionVar());
+            for (Operation &op : forOp.getBody()->without_terminator()) {
+                builder.clone(op, mapping);
+            }
+        } else if (parallel.getNumLoops() == 1) {
+            mapping.map(parallel.getInductionVars()[0],
+                        chunk.getInductionVar());
+            for (Operation &op : parallel.getBody()->without_terminator()) {
+                builder.clone(op, mapping);
+            }
+        } else {
+            mapping.map(parallel.getInductionVars()[0],
+                        chunk.getInductionVar());
+            llvm::SmallVector<Value> lbs, ubs, steps;
+            for (size_t d = 1; d < parallel.getNumLoops(); ++d) {
+                lbs.push_back(mapping.lookup(parallel.getLowerBound()[d]));
+                ubs.push_back(mapping.lookup(parallel.getUpperBound()[d]));
+                steps.push_back(mapping.lookup(parallel.getStep()[d]));
+            }
+            builder.create<scf::ParallelOp>(
+                loc, lbs, ubs, steps,
+                [&](OpBuilder &nested, Location nestedLoc, ValueRange ivs) {
+                    for (auto [d, iv] : llvm::enumerate(ivs)) {
+                        mapping.map(parallel.getInductionVars()[d + 1], iv);
+                    }
+                    for (Operation &op :
+                         parallel.getBody()->without_terminator()) {
+                        nested.clone(op, mapping);
+                    }
+                });
+        }
+
+        builder.setInsertionPointAfter(chunk);
+        builder.create<func::ReturnOp>(loc);
+
+        // ---- Call site: pack pointers and hand the range to the pool ----
+        func::FuncOp runtime = getOrInsertRuntimeDecl(symbolTable, bodyType);
+
+        builder.setInsertionPoint(loop);
+        int64_t slots =
+            std::max<int64_t>(1, static_cast<int64_t>(captures->memrefs.size()));
+        Value context = builder.create<memref::AllocaOp>(
+            loc, MemRefType::get({slots}, indexType));
+        for (auto [slot, memref] : llvm::enumerate(captures->memrefs)) {
+            Value pointer =
+                builder.create<memref::ExtractAlignedPointerAsIndexOp>(loc,
+                                                                       memref);
+            Value index = builder.create<arith::ConstantIndexOp>(
+                loc, static_cast<int64_t>(slot));
+            builder.create<memref::StoreOp>(loc, pointer, context, index);
+        }
+        Value contextAddress =
+            builder.create<memref::ExtractAlignedPointerAsIndexOp>(loc,
+                                                                   context);
+        Value contextInt = builder.create<arith::IndexCastOp>(
+            loc, builder.getI64Type(), contextAddress);
+        Value contextPtr =
+            builder.create<LLVM::IntToPtrOp>(loc, ptrType, contextInt);
+
+        Value function = builder.create<func::ConstantOp>(
+            loc, bodyType, SymbolRefAttr::get(ctx, body.getSymName()));
+        builder.create<func::CallOp>(
+            loc, runtime,
+            ValueRange{function, lb, ub, step, contextPtr});
+
+        loop->erase();
+    }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> createOutlineParallelLoopsPass() {
+    return std::make_unique<OutlineParallelLoopsPass>();
+}
+
+} // namespace tensor_compiler
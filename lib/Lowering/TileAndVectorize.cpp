@@ -0,0 +1,255 @@
+#include "Lowering/TileAndVectorize.h"
+#include "Lowering/ParallelLoops.h"
+
+#include "mlir/Dialect/Affine/IR/AffineOps.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Linalg/Transforms/Transforms.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/SCF/Transforms/TileUsingInterface.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/Dialect/Vector/Transforms/LoweringPatterns.h"
+#include "mlir/Dialect/Vector/Transforms/VectorRewritePatterns.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Interfaces/TilingInterface.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include <algorithm>
+#include <optional>
+
+using namespace mlir;
+
+namespace tensor_compiler {
+
+namespace {
+
+// Tiled ops whose iteration space exceeds this many elements per squared
+// vector width are not vectorized: the resulting vectors would spill the
+// register file. Tiles grow with the vector width in two dimensions (see
+// computeTileSizes), and so does the register file: AVX-512 has twice the
+// lanes and twice the registers of AVX2. At 8 lanes the budget is 4096.
+constexpr int64_t kMaxVectorElementsPerLane2 = 64;
+
+// Reduction loops up to this extent are kept whole inside a tile.
+constexpr int64_t kMaxUntiledReduction = 1024;
+
+int64_t largestDivisorAtMost(int64_t extent, int64_t bound) {
+    for (int64_t d = std::min(extent, bound); d > 1; --d) {
+        if (extent % d == 0) {
+            return d;
+        }
+    }
+    return 1;
+}
+
+// Tiles always divide the loop extent, so every tile has a static shape and
+// the vectorizer never needs masking. A tile covering the whole loop is
+// reported as 0, which leaves that loop untiled.
+int64_t tileFor(int64_t extent, int64_t bound) {
+    int64_t tile = largestDivisorAtMost(extent, bound);
+    return tile == extent ? 0 : tile;
+}
+
+std::optional<llvm::SmallVector<int64_t>>
+computeTileSizes(linalg::LinalgOp op, const TileAndVectorizeOptions &options) {
+    llvm::SmallVector<int64_t> ranges = op.getStaticLoopRanges();
+    if (llvm::any_of(ranges, ShapedType::isDynamic)) {
+        return std::nullopt;
+    }
+
+    const int64_t vw = options.vectorWidth;
+    const int64_t rt = options.reductionTile;
+
+    // (n, f, oh, ow, c, kh, kw): unit oh/kh tiles let the conv decompose
+    // into a 1D convolution along the contiguous width dimension.
+    if (mlir::isa<linalg::Conv2DNchwFchwOp>(op.getOperation())) {
+        return llvm::SmallVector<int64_t>{
+            tileFor(ranges[0], 1),  tileFor(ranges[1], vw),
+            tileFor(ranges[2], 1),  tileFor(ranges[3], vw),
+            tileFor(ranges[4], rt), tileFor(ranges[5], 1),
+            0};
+    }
+
+    // (n, c, oh, ow, kh, kw)
+    if (mlir::isa<linalg::PoolingNchwMaxOp>(op.getOperation())) {
+        return llvm::SmallVector<int64_t>{
+            tileFor(ranges[0], 1), tileFor(ranges[1], vw),
+            tileFor(ranges[2], 1), tileFor(ranges[3], vw),
+            tileFor(ranges[4], 1), 0};
+    }
+
+    // (m, n, k)
+    if (mlir::isa<linalg::MatmulOp>(op.getOperation())) {
+        return llvm::SmallVector<int64_t>{tileFor(ranges[0], 4),
+                                          tileFor(ranges[1], 2 * vw),
+                                          tileFor(ranges[2], rt)};
+    }
+
+    // Elementwise and reduction generics, fills: vectorize along the
+    // innermost parallel loop and keep moderate reductions whole.
+    auto iterators = op.getIteratorTypesArray();
+    std::optional<size_t> innermostParallel;
+    for (size_t i = 0; i < iterators.size(); ++i) {
+        if (iterators[i] == utils::IteratorType::parallel) {
+            innermostParallel = i;
+        }
+    }
+
+    llvm::SmallVector<int64_t> tiles(ranges.size(), 0);
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        if (iterators[i] == utils::IteratorType::reduction) {
+            tiles[i] = ranges[i] > kMaxUntiledReduction
+                           ? tileFor(ranges[i], 16 * vw)
+                           : 0;
+        } else if (innermostParallel && i == *innermostParallel) {
+            tiles[i] = tileFor(ranges[i], 4 * vw);
+        } else {
+            tiles[i] = tileFor(ranges[i], 1);
+        }
+    }
+    return tiles;
+}
+
+// The outermost tile loop may run on the thread pool when it walks a
+// parallel dimension of the op.
+bool outerTileIsParallel(linalg::LinalgOp op,
+                         llvm::ArrayRef<int64_t> tileSizes) {
+    auto iterators = op.getIteratorTypesArray();
+    for (size_t i = 0; i < tileSizes.size(); ++i) {
+        if (tileSizes[i] != 0) {
+            return iterators[i] == utils::IteratorType::parallel;
+        }
+    }
+    return false;
+}
+
+bool fitsVectorBudget(linalg::LinalgOp op, int64_t vectorWidth) {
+    const int64_t budget =
+        kMaxVectorElementsPerLane2 * vectorWidth * vectorWidth;
+    int64_t elements = 1;
+    for (int64_t extent : op.getStaticLoopRanges()) {
+        if (ShapedType::isDynamic(extent)) {
+            return false;
+        }
+        elements *= extent;
+        if (elements > budget) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class TileAndVectorizePass
+    : public PassWrapper<TileAndVectorizePass, OperationPass<func::FuncOp>> {
+public:
+    MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(TileAndVectorizePass)
+
+    explicit TileAndVectorizePass(const TileAndVectorizeOptions &options)
+        : options_(options) {}
+
+    llvm::StringRef getArgument() const final {
+        return "tc-tile-and-vectorize";
+    }
+
+    llvm::StringRef getDescription() const final {
+        return "Tile linalg ops on tensors and rewrite tiles into vector ops";
+    }
+
+    void getDependentDialects(DialectRegistry &registry) const override {
+        registry.insert<affine::AffineDialect, arith::ArithDialect,
+                        linalg::LinalgDialect, scf::SCFDialect,
+                        tensor::TensorDialect, vector::VectorDialect>();
+    }
+
+    void runOnOperation() override {
+        func::FuncOp func = getOperation();
+        MLIRContext *ctx = &getContext();
+        IRRewriter rewriter(ctx);
+
+        tile(func, rewriter);
+
+        RewritePatternSet decompose(ctx);
+        linalg::populateDecomposeConvolutionPatterns(decompose);
+        (void)applyPatternsAndFoldGreedily(func, std::move(decompose));
+
+        vectorize(func, rewriter);
+
+        RewritePatternSet cleanup(ctx);
+        vector::populateVectorTransferPermutationMapLoweringPatterns(cleanup);
+        vector::populateVectorReductionToContractPatterns(cleanup);
+        vector::TransferReadOp::getCanonicalizationPatterns(cleanup, ctx);
+        vector::TransferWriteOp::getCanonicalizationPatterns(cleanup, ctx);
+        (void)applyPatternsAndFoldGreedily(func, std::move(cleanup));
+    }
+
+private:
+    void tile(func::FuncOp func, IRRewriter &rewriter) {
+        llvm::SmallVector<linalg::LinalgOp> targets;
+        func.walk([&](linalg::LinalgOp op) { targets.push_back(op); });
+
+        for (linalg::LinalgOp op : targets) {
+            auto tilingOp =
+                mlir::dyn_cast<TilingInterface>(op.getOperation());
+            if (!tilingOp) {
+                continue;
+            }
+
+            auto tileSizes = computeTileSizes(op, options_);
+            if (!tileSizes || llvm::all_of(*tileSizes, [](int64_t t) {
+                    return t == 0;
+                })) {
+                continue;
+            }
+
+            scf::SCFTilingOptions tilingOptions;
+            tilingOptions.setTileSizes(
+                getAsIndexOpFoldResult(func.getContext(), *tileSizes));
+
+            rewriter.setInsertionPoint(op);
+            FailureOr<scf::SCFTilingResult> tiled =
+                scf::tileUsingSCFForOp(rewriter, tilingOp, tilingOptions);
+            if (failed(tiled)) {
+                continue;
+            }
+            if (!tiled->loops.empty() && outerTileIsParallel(op, *tileSizes)) {
+                tiled->loops.front()->setAttr(kParallelLoopAttrName,
+                                              rewriter.getUnitAttr());
+            }
+            rewriter.replaceOp(op, tiled->replacements);
+        }
+    }
+
+    void vectorize(func::FuncOp func, IRRewriter &rewriter) {
+        llvm::SmallVector<linalg::LinalgOp> candidates;
+        func.walk([&](linalg::LinalgOp op) {
+            if (fitsVectorBudget(op, options_.vectorWidth)) {
+                candidates.push_back(op);
+            }
+        });
+
+        for (linalg::LinalgOp op : candidates) {
+            rewriter.setInsertionPoint(op);
+            // Ops without a vector form stay as linalg and are lowered to
+            // scalar loops after bufferization.
+            (void)linalg::vectorize(rewriter, op);
+        }
+    }
+
+    TileAndVectorizeOptions options_;
+};
+
+} // namespace
+
+std::unique_ptr<Pass>
+createTileAndVectorizePass(const TileAndVectorizeOptions &options) {
+    return std::make_unique<TileAndVectorizePass>(options);
+}
+
+} // namespace tensor_compiler
@@ -1,9 +1,51 @@
 #include "ModelAPI/ModelAPI.h"
-#include <string.h>
+#include <pthread.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { kWorkspaceAlignment = 64 };
+
+extern int tensorCompForwardImpl(float* input, float* output, void* workspace);
+extern int64_t tensorCompWorkspaceSizeImpl(void);
+
+static pthread_key_t workspaceKey;
+static pthread_once_t workspaceKeyOnce = PTHREAD_ONCE_INIT;
+
+static void createWorkspaceKey(void) {
+    pthread_key_create(&workspaceKey, free);
+}
+
+// Workspace owned by the calling thread, allocated on its first inference
+// and released when the thread exits.
+static void* threadWorkspace(size_t size) {
+    pthread_once(&workspaceKeyOnce, createWorkspaceKey);
+    void* workspace = pthread_getspecific(workspaceKey);
+    if (!workspace) {
+        size_t rounded = (size + kWorkspaceAlignment - 1) /
+                         kWorkspaceAlignment * kWorkspaceAlignment;
+        workspace = aligned_alloc(kWorkspaceAlignment,
+                                  rounded ? rounded : kWorkspaceAlignment);
+        if (workspace) {
+            pthread_setspecific(workspaceKey, workspace);
+        }
+    }
+    return workspace;
+}
 
-extern int tensorCompForwardImpl(float* input, float* output);
+size_t tensorCompWorkspaceSize(void) {
+    return (size_t)tensorCompWorkspaceSizeImpl();
+}
+
+int tensorCompForwardWithWorkspace(const float* input, float* output,
+                                   void* workspace) {
+    return tensorCompForwardImpl((float*)input, output, workspace);
+}
 
 int tensorCompForward(const float* input, float* output) {
-    return tensorCompForwardImpl((float*)input, output);
+    void* workspace = threadWorkspace(tensorCompWorkspaceSize());
+    if (!workspace) {
+        return -1;
+    }
+    return tensorCompForwardImpl((float*)input, output, workspace);
 }
@@ -0,0 +1,303 @@
+#include "ModelAPI/ModelAPI.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Every worker owns a small deque of chunks. It pops from the tail of its
+// own deque and steals from the head of the others once it runs dry, so
+// uneven kernels (padding borders, short last tiles) still keep all cores
+// busy until the loop is done.
+
+enum { kChunksPerThread = 4 };
+
+typedef struct {
+    int64_t begin;
+    int64_t end;
+} Chunk;
+
+typedef struct {
+    pthread_mutex_t lock;
+    Chunk chunks[kChunksPerThread];
+    int head;
+    int tail;
+} WorkQueue;
+
+typedef struct {
+    TensorCompParallelBody body;
+    void *ctx;
+    int64_t lb;
+    int64_t ub;
+    int64_t step;
+} Job;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_t *threads;
+    WorkQueue *queues;
+    int numThreads;
+    int started;
+    int shutdown;
+    uint64_t generation;
+    const Job *job;
+    int active;
+    atomic_int_fast64_t pending;
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+// Serializes parallel loops and pool restarts. A loop issued while another
+// one is running (concurrent inference calls) runs on the calling thread.
+static pthread_mutex_t jobLock = PTHREAD_MUTEX_INITIALIZER;
+static int requestedThreads = 0;
+static _Thread_local int inParallelRegion = 0;
+
+static int defaultNumThreads(void) {
+    const char *env = getenv("TC_NUM_THREADS");
+    if (env) {
+        int value = atoi(env);
+        if (value > 0) {
+            return value;
+        }
+    }
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+static int popChunk(WorkQueue *queue, Chunk *chunk) {
+    int found = 0;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->tail > queue->head) {
+        *chunk = queue->chunks[--queue->tail];
+        found = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+static int stealChunk(WorkQueue *queue, Chunk *chunk) {
+    int found = 0;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->tail > queue->head) {
+        *chunk = queue->chunks[queue->head++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+static int nextChunk(int self, Chunk *chunk) {
+    if (popChunk(&pool.queues[self], chunk)) {
+        return 1;
+    }
+    for (int i = 1; i < pool.numThreads; ++i) {
+        if (stealChunk(&pool.queues[(self + i) % pool.numThreads], chunk)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void runChunks(const Job *job, int self) {
+    Chunk chunk;
+    while (nextChunk(self, &chunk)) {
+        int64_t begin = job->lb + chunk.begin * job->step;
+        int64_t end = job->lb + chunk.end * job->step;
+        job->body(begin, end < job->ub ? end : job->ub, job->ctx);
+
+        if (atomic_fetch_sub(&pool.pending, 1) == 1) {
+            pthread_mutex_lock(&pool.lock);
+            pthread_cond_broadcast(&pool.done);
+            pthread_mutex_unlock(&pool.lock);
+        }
+    }
+}
+
+static void *workerMain(void *arg) {
+    int self = (int)(intptr_t)arg;
+    uint64_t seen = 0;
+    inParallelRegion = 1;
+
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (!pool.shutdown && pool.generation == seen) {
+            pthread_cond_wait(&pool.wake, &pool.lock);
+        }
+        if (pool.shutdown) {
+            break;
+        }
+        seen = pool.generation;
+
+        // Woke up after the job was already finished by the others.
+        const Job *job = pool.job;
+        if (!job) {
+            continue;
+        }
+
+        ++pool.active;
+        pthread_mutex_unlock(&pool.lock);
+        runChunks(job, self);
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.active == 0) {
+            pthread_cond_broadcast(&pool.done);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+// Both helpers are called with jobLock held.
+static void startPool(void) {
+    int numThreads =
+        requestedThreads > 0 ? requestedThreads : defaultNumThreads();
+
+    pool.queues = calloc((size_t)numThreads, sizeof(WorkQueue));
+    pool.threads = calloc((size_t)numThreads, sizeof(pthread_t));
+    if (!pool.queues || !pool.threads) {
+        free(pool.queues);
+        free(pool.threads);
+        pool.queues = NULL;
+        pool.threads = NULL;
+        numThreads = 1;
+    }
+    pool.numThreads = numThreads;
+    pool.shutdown = 0;
+    pool.started = 1;
+
+    for (int i = 0; i < numThreads && pool.queues; ++i) {
+        pthread_mutex_init(&pool.queues[i].lock, NULL);
+    }
+
+    // The calling thread acts as worker 0.
+    for (int i = 1; i < numThreads; ++i) {
+        if (pthread_create(&pool.threads[i], NULL, workerMain,
+                           (void *)(intptr_t)i) != 0) {
+            pool.numThreads = i;
+            break;
+        }
+    }
+}
+
+static void stopPool(void) {
+    if (!pool.started) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.shutdown = 1;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (int i = 1; i < pool.numThreads; ++i) {
+        pthread_join(pool.threads[i], NULL);
+    }
+    for (int i = 0; i < pool.numThreads && pool.queues; ++i) {
+        pthread_mutex_destroy(&pool.queues[i].lock);
+    }
+
+    free(pool.queues);
+    free(pool.threads);
+    pool.queues = NULL;
+    pool.threads = NULL;
+    pool.numThreads = 0;
+    pool.generation = 0;
+    pool.started = 0;
+}
+
+// The workers run code of this library: they must be joined before dlclose
+// unmaps it, not return into it later.
+__attribute__((destructor)) static void destroyPool(void) {
+    pthread_mutex_lock(&jobLock);
+    stopPool();
+    pthread_mutex_unlock(&jobLock);
+}
+
+static void runSerial(TensorCompParallelBody body, int64_t lb, int64_t ub,
+                      void *ctx) {
+    body(lb, ub, ctx);
+}
+
+void tensorCompParallelFor(TensorCompParallelBody body, int64_t lb,
+                           int64_t ub, int64_t step, void *ctx) {
+    if (ub <= lb || step <= 0) {
+        return;
+    }
+
+    int64_t tripCount = (ub - lb + step - 1) / step;
+    if (tripCount < 2 || inParallelRegion ||
+        pthread_mutex_trylock(&jobLock) != 0) {
+        runSerial(body, lb, ub, ctx);
+        return;
+    }
+
+    if (!pool.started) {
+        startPool();
+    }
+    if (pool.numThreads < 2) {
+        pthread_mutex_unlock(&jobLock);
+        runSerial(body, lb, ub, ctx);
+        return;
+    }
+
+    int64_t numChunks = (int64_t)pool.numThreads * kChunksPerThread;
+    if (numChunks > tripCount) {
+        numChunks = tripCount;
+    }
+
+    // No worker touches the queues between jobs, so they are filled
+    // without locking; publishing the job under pool.lock orders the stores.
+    for (int i = 0; i < pool.numThreads; ++i) {
+        pool.queues[i].head = 0;
+        pool.queues[i].tail = 0;
+    }
+    for (int64_t i = 0; i < numChunks; ++i) {
+        WorkQueue *queue = &pool.queues[i % pool.numThreads];
+        queue->chunks[queue->tail].begin = i * tripCount / numChunks;
+        queue->chunks[queue->tail].end = (i + 1) * tripCount / numChunks;
+        ++queue->tail;
+    }
+
+    Job job = {body, ctx, lb, ub, step};
+    atomic_store(&pool.pending, numChunks);
+
+    pthread_mutex_lock(&pool.lock);
+    pool.job = &job;
+    ++pool.generation;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    inParallelRegion = 1;
+    runChunks(&job, 0);
+    inParallelRegion = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    while (atomic_load(&pool.pending) != 0 || pool.active != 0) {
+        pthread_cond_wait(&pool.done, &pool.lock);
+    }
+    pool.job = NULL;
+    pthread_mutex_unlock(&pool.lock);
+
+    pthread_mutex_unlock(&jobLock);
+}
+
+void tensorCompSetNumThreads(int numThreads) {
+    pthread_mutex_lock(&jobLock);
+    stopPool();
+    requestedThreads = numThreads > 0 ? numThreads : 0;
+    pthread_mutex_unlock(&jobLock);
+}
+
+int tensorCompGetNumThreads(void) {
+    pthread_mutex_lock(&jobLock);
+    int numThreads = pool.started ? pool.numThreads
+                     : requestedThreads > 0 ? requestedThreads
+                                            : defaultNumThreads();
+    pthread_mutex_unlock(&jobLock);
+    return numThreads;
+}
@@ -1,6 +1,9 @@
 #include "Structure/Graph.h"
 #include "Handlers.h"
+#include <algorithm>
+#include <iterator>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace tensor_compiler {
@@ -9,9 +12,10 @@ namespace tensor_compiler {
 // @section Implementations
 // Implementations
 // ----------------------------------------------------------------------------
-Graph::Graph(const onnx::GraphProto &graph) : name_{graph.name()} {
+Graph::Graph(const onnx::GraphProto &graph, const RawDataViews &rawData)
+    : name_{graph.name()} {
     for (const auto &initializer : graph.initializer()) {
-        auto tensor = handleTensor(initializer);
+        auto tensor = handleTensor(initializer, rawData);
         addTensor(std::move(tensor));
     }
 
@@ -35,50 +39,219 @@ Graph::Graph(const onnx::GraphProto &graph) : name_{graph.name()} {
 }
 
 const std::string &Graph::name() const { return name_; }
-const T_map &Graph::tensors() const { return tensors_; }
 const std::vector<Node> &Graph::nodes() const { return nodes_; }
-const std::vector<std::string> &Graph::inputs() const {
-    return inputs_;
-}
-const std::vector<std::string> &Graph::outputs() const {
-    return outputs_;
-}
+TensorNameList Graph::inputs() const { return {inputIds_, names_.get()}; }
+TensorNameList Graph::outputs() const { return {outputIds_, names_.get()}; }
+const std::vector<TensorId> &Graph::inputIds() const { return inputIds_; }
+const std::vector<TensorId> &Graph::outputIds() const { return outputIds_; }
 
 void Graph::setName(std::string name) { name_ = std::move(name); }
 
 void Graph::setInputs(const std::vector<std::string> &inputs) {
-    inputs_ = inputs;
+    inputIds_.clear();
+    for (const std::string &input : inputs)
+        addInput(input);
 }
 void Graph::setOutputs(const std::vector<std::string> &outputs) {
-    outputs_ = outputs;
+    outputIds_.clear();
+    for (const std::string &output : outputs)
+        addOutput(output);
+}
+
+TensorId Graph::intern(std::string_view name) {
+    const TensorId id = names_->intern(name);
+    reserveSlots(id);
+    return id;
+}
+
+void Graph::reserveSlots(TensorId id) {
+    if (id == kNoTensor || id < tensors_.size())
+        return;
+    tensors_.resize(id + 1);
+    producers_.resize(id + 1);
+    consumers_.resize(id + 1);
+}
+
+std::size_t Graph::tensorIdCount() const { return names_->size(); }
+
+std::optional<TensorId> Graph::tensorId(std::string_view name) const {
+    return names_->find(name);
+}
+
+const std::string &Graph::tensorName(TensorId id) const {
+    return names_->name(id);
 }
 
 void Graph::addTensor(Tensor tensor) {
-    tensors_.insert_or_assign(tensor.name(), std::move(tensor));
+    if (tensor.names_ != names_) {
+        tensor.id_ = intern(tensor.name());
+        tensor.names_ = names_;
+        tensor.name_.clear();
+    }
+    const TensorId id = tensor.id_;
+    if (id == kNoTensor)
+        return;
+    reserveSlots(id);
+    tensors_[id] = std::move(tensor);
+}
+
+void Graph::removeTensor(const std::string &name) {
+    auto id = tensorId(name);
+    if (id && *id < tensors_.size())
+        tensors_[*id].reset();
+}
+
+void Graph::setNodes(std::vector<Node> nodes) {
+    nodes_ = std::move(nodes);
+    for (auto &producer : producers_)
+        producer.reset();
+    for (auto &readers : consumers_)
+        readers.clear();
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        indexNode(i);
+    }
+}
+
+void Graph::addNode(Node node) {
+    nodes_.push_back(std::move(node));
+    indexNode(nodes_.size() - 1);
+}
+
+void Graph::indexNode(std::size_t idx) {
+    Node &node = nodes_[idx];
+    if (node.names_ != names_) {
+        // Plain names, or ids of another graph's table.
+        const TensorNameList inputs = node.inputs();
+        const TensorNameList outputs = node.outputs();
+        std::vector<TensorId> inputIds;
+        std::vector<TensorId> outputIds;
+        for (const std::string &name : inputs)
+            inputIds.push_back(intern(name));
+        for (const std::string &name : outputs)
+            outputIds.push_back(intern(name));
+        node.inputIds_ = std::move(inputIds);
+        node.outputIds_ = std::move(outputIds);
+        node.inputNames_.clear();
+        node.outputNames_.clear();
+        node.names_ = names_;
+    }
+
+    for (TensorId input : node.inputIds_) {
+        if (input == kNoTensor)
+            continue;
+        reserveSlots(input);
+        // Nodes are indexed in order, so a repeated input of the same node
+        // is always the last entry.
+        auto &readers = consumers_[input];
+        if (readers.empty() || readers.back() != idx)
+            readers.push_back(idx);
+    }
+    for (TensorId output : node.outputIds_) {
+        if (output == kNoTensor)
+            continue;
+        reserveSlots(output);
+        producers_[output] = idx;
+    }
+}
+
+void Graph::replaceUses(const std::string &from, const std::string &to) {
+    auto fromId = tensorId(from);
+    if (!fromId || from == to || consumers(*fromId).empty())
+        return;
+    const TensorId toId = intern(to);
+    std::vector<std::size_t> readers = std::move(consumers_[*fromId]);
+    consumers_[*fromId].clear();
+
+    for (std::size_t idx : readers) {
+        std::vector<TensorId> &inputIds = nodes_[idx].inputIds_;
+        std::replace(inputIds.begin(), inputIds.end(), *fromId, toId);
+    }
+
+    auto &merged = consumers_[toId];
+    std::vector<std::size_t> old = std::move(merged);
+    merged.clear();
+    std::set_union(old.begin(), old.end(), readers.begin(), readers.end(),
+                   std::back_inserter(merged));
+}
+
+std::size_t Graph::removeUnusedTensors() {
+    std::vector<bool> used(tensors_.size(), false);
+    for (const auto *ids : {&inputIds_, &outputIds_}) {
+        for (TensorId id : *ids) {
+            if (id < used.size())
+                used[id] = true;
+        }
+    }
+    for (std::size_t id = 0; id < tensors_.size(); ++id) {
+        if (!consumers_[id].empty() || producers_[id])
+            used[id] = true;
+    }
+
+    std::size_t removed = 0;
+    for (std::size_t id = 0; id < tensors_.size(); ++id) {
+        auto &slot = tensors_[id];
+        if (!slot || used[id])
+            continue;
+        Tensor_kind kind = slot->kind();
+        if (kind == Tensor_kind::constant ||
+            kind == Tensor_kind::intermediate) {
+            slot.reset();
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+std::optional<std::size_t> Graph::producer(const std::string &name) const {
+    auto id = tensorId(name);
+    return id ? producer(*id) : std::nullopt;
+}
+
+std::optional<std::size_t> Graph::producer(TensorId id) const {
+    if (id >= producers_.size())
+        return std::nullopt;
+    return producers_[id];
+}
+
+const std::vector<std::size_t> &
+Graph::consumers(const std::string &name) const {
+    auto id = tensorId(name);
+    return consumers(id ? *id : kNoTensor);
 }
 
-void Graph::addNode(Node node) { nodes_.push_back(std::move(node)); }
+const std::vector<std::size_t> &Graph::consumers(TensorId id) const {
+    static const std::vector<std::size_t> none;
+    return id < consumers_.size() ? consumers_[id] : none;
+}
 
 void Graph::addInput(const std::string &input) {
-    inputs_.push_back(input);
+    inputIds_.push_back(intern(input));
 }
 void Graph::addOutput(const std::string &output) {
-    outputs_.push_back(output);
+    outputIds_.push_back(intern(output));
 }
 
 const Tensor *Graph::tensor(const std::string &name) const {
-    auto it = tensors_.find(name);
-    if (it != tensors_.end())
-        return &(it->second);
-    return nullptr;
+    auto id = tensorId(name);
+    return id ? tensor(*id) : nullptr;
+}
+
+const Tensor *Graph::tensor(TensorId id) const {
+    if (id >= tensors_.size() || !tensors_[id])
+        return nullptr;
+    return &*tensors_[id];
 }
 
-Tensor Graph::handleTensor(const onnx::TensorProto &t) {
+Tensor Graph::handleTensor(const onnx::TensorProto &t,
+                           const RawDataViews &rawData) {
     Tensor tensor{};
     tensor.setName(t.name());
     tensor.setDim(t.dims());
     tensor.setType(t.data_type());
-    tensor.setData(extractTensorBytes(t));
+    if (auto it = rawData.find(t.name()); it != rawData.end())
+        tensor.setDataView(it->second);
+    else
+        tensor.setData(extractTensorBytes(t));
     tensor.setKind(Tensor_kind::constant);
     return tensor;
 }
@@ -0,0 +1,287 @@
+#include "Structure/ModelFile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fcntl.h>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tensor_compiler {
+
+namespace {
+
+// Field numbers from onnx.proto.
+constexpr uint32_t kModelGraphField = 7;
+constexpr uint32_t kGraphInitializerField = 5;
+constexpr uint32_t kTensorNameField = 8;
+constexpr uint32_t kTensorRawDataField = 9;
+
+enum WireType : uint32_t {
+    kVarint = 0,
+    kFixed64 = 1,
+    kLengthDelimited = 2,
+    kFixed32 = 5,
+};
+
+bool readVarint(std::string_view &in, uint64_t &value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && !in.empty(); shift += 7) {
+        auto byte = static_cast<uint8_t>(in.front());
+        in.remove_prefix(1);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void writeVarint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// One field of a message: its tag and, for length-delimited fields, the
+// payload; `raw` spans the whole field as it appears on the wire.
+struct Field {
+    uint32_t number = 0;
+    uint32_t wireType = 0;
+    std::string_view payload;
+    std::string_view raw;
+};
+
+bool readField(std::string_view &in, Field &field) {
+    const char *begin = in.data();
+    uint64_t tag = 0;
+    if (!readVarint(in, tag)) {
+        return false;
+    }
+    field.number = static_cast<uint32_t>(tag >> 3);
+    field.wireType = static_cast<uint32_t>(tag & 7);
+
+    uint64_t value = 0;
+    switch (field.wireType) {
+    case kVarint:
+        if (!readVarint(in, value)) {
+            return false;
+        }
+        break;
+    case kFixed64:
+    case kFixed32: {
+        size_t size = field.wireType == kFixed64 ? 8 : 4;
+        if (in.size() < size) {
+            return false;
+        }
+        in.remove_prefix(size);
+        break;
+    }
+    case kLengthDelimited:
+        if (!readVarint(in, value) || value > in.size()) {
+            return false;
+        }
+        field.payload = in.substr(0, value);
+        in.remove_prefix(value);
+        break;
+    default:
+        // Groups are not used by onnx.proto.
+        return false;
+    }
+    field.raw = std::string_view(begin, static_cast<size_t>(in.data() - begin));
+    return true;
+}
+
+void writeLengthDelimited(std::string &out, uint32_t number,
+                          std::string_view payload) {
+    writeVarint(out, (static_cast<uint64_t>(number) << 3) | kLengthDelimited);
+    writeVarint(out, payload.size());
+    out.append(payload);
+}
+
+bool stripTensor(std::string_view in, std::string &out, RawDataViews &rawData) {
+    std::string name;
+    std::string_view raw;
+    bool hasRaw = false;
+    Field field;
+    while (!in.empty()) {
+        if (!readField(in, field)) {
+            return false;
+        }
+        if (field.wireType == kLengthDelimited &&
+            field.number == kTensorRawDataField) {
+            raw = field.payload;
+            hasRaw = true;
+            continue;
+        }
+        if (field.wireType == kLengthDelimited &&
+            field.number == kTensorNameField) {
+            name.assign(field.payload);
+        }
+        out.append(field.raw);
+    }
+    if (hasRaw) {
+        rawData[name] = raw;
+    }
+    return true;
+}
+
+bool stripGraph(std::string_view in, std::string &out, RawDataViews &rawData) {
+    Field field;
+    std::string tensor;
+    while (!in.empty()) {
+        if (!readField(in, field)) {
+            return false;
+        }
+        if (field.wireType == kLengthDelimited &&
+            field.number == kGraphInitializerField) {
+            tensor.clear();
+            if (!stripTensor(field.payload, tensor, rawData)) {
+                return false;
+            }
+            writeLengthDelimited(out, field.number, tensor);
+            continue;
+        }
+        out.append(field.raw);
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseModelWithoutRawData(std::string_view bytes, onnx::ModelProto &model,
+                              RawDataViews &rawData) {
+    std::string skeleton;
+    Field field;
+    std::string graph;
+    while (!bytes.empty()) {
+        if (!readField(bytes, field)) {
+            return false;
+        }
+        if (field.wireType == kLengthDelimited &&
+            field.number == kModelGraphField) {
+            graph.clear();
+            if (!stripGraph(field.payload, graph, rawData)) {
+                return false;
+            }
+            writeLengthDelimited(skeleton, field.number, graph);
+            continue;
+        }
+        skeleton.append(field.raw);
+    }
+    return model.ParseFromString(skeleton);
+}
+
+MappedFile::MappedFile(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat file: " + path);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ > 0) {
+        mapping_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        throw std::runtime_error("Failed to map file: " + path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (mapping_) {
+        ::munmap(mapping_, size_);
+    }
+}
+
+std::string_view MappedFile::bytes() const {
+    return std::string_view(static_cast<const char *>(mapping_), size_);
+}
+
+ModelFile::ModelFile(const std::string &path) : file_(path) {
+    if (!parseModelWithoutRawData(file_.bytes(), model_, rawData_)) {
+        throw std::runtime_error("Failed to parse ONNX model: " + path);
+    }
+    resolveExternalData(path);
+}
+
+void ModelFile::resolveExternalData(const std::string &modelPath) {
+    const std::filesystem::path baseDir =
+        std::filesystem::path(modelPath).parent_path();
+
+    for (const onnx::TensorProto &tensor : model_.graph().initializer()) {
+        if (tensor.data_location() != onnx::TensorProto_DataLocation_EXTERNAL) {
+            continue;
+        }
+
+        std::string location;
+        std::optional<uint64_t> offset;
+        std::optional<uint64_t> length;
+        for (const auto &entry : tensor.external_data()) {
+            if (entry.key() == "location") {
+                location = entry.value();
+            } else if (entry.key() == "offset" || entry.key() == "length") {
+                uint64_t value = 0;
+                const std::string &text = entry.value();
+                auto [end, ec] = std::from_chars(
+                    text.data(), text.data() + text.size(), value);
+                if (ec != std::errc() || end != text.data() + text.size()) {
+                    throw std::runtime_error("Invalid external data " +
+                                             entry.key() + " of initializer '" +
+                                             tensor.name() + "'");
+                }
+                (entry.key() == "offset" ? offset : length) = value;
+            }
+        }
+
+        // Like the ONNX checker: data files live next to the model.
+        const std::filesystem::path relative(location);
+        if (location.empty() || relative.is_absolute() ||
+            std::find(relative.begin(), relative.end(), "..") !=
+                relative.end()) {
+            throw std::runtime_error("Invalid external data location '" +
+                                     location + "' of initializer '" +
+                                     tensor.name() + "'");
+        }
+
+        auto it = externalFiles_.find(location);
+        if (it == externalFiles_.end()) {
+            it = externalFiles_
+                     .try_emplace(location, (baseDir / relative).string())
+                     .first;
+        }
+
+        std::string_view data = it->second.bytes();
+        const uint64_t begin = offset.value_or(0);
+        if (begin > data.size() ||
+            (length && *length > data.size() - begin)) {
+            throw std::runtime_error("External data of initializer '" +
+                                     tensor.name() + "' is out of bounds of " +
+                                     location);
+        }
+        rawData_[tensor.name()] =
+            data.substr(begin, length.value_or(data.size() - begin));
+    }
+}
+
+std::string_view ModelFile::bytes() const { return file_.bytes(); }
+
+const std::map<std::string, MappedFile> &ModelFile::externalFiles() const {
+    return externalFiles_;
+}
+
+const onnx::ModelProto &ModelFile::model() const { return model_; }
+
+const RawDataViews &ModelFile::rawData() const { return rawData_; }
+
+} // namespace tensor_compiler
@@ -6,39 +6,46 @@ namespace tensor_compiler {
 // @section Implementations
 // Implementation of node methods.
 // ----------------------------------------------------------------------------
+Node::Node(const std::string &name, const std::string &opcode, node_id id)
+    : id_{id}, opcode_{opcode},
+      opId_{OpRegistry::instance().intern(opcode)}, name_{name} {}
+
 void Node::setName(const std::string &name) { name_ = name; }
 
 Node::node_id Node::id() const { return id_; }
 const std::string &Node::opcode() const { return opcode_; }
+OpId Node::opId() const { return opId_; }
 const std::string &Node::name() const { return name_; }
-const std::vector<std::string> &Node::inputs() const {
-    return inputs_;
+TensorNameList Node::inputs() const {
+    return names_ ? TensorNameList{inputIds_, names_.get()}
+                  : TensorNameList{inputNames_};
 }
-const std::vector<std::string> &Node::outputs() const {
-    return outputs_;
+TensorNameList Node::outputs() const {
+    return names_ ? TensorNameList{outputIds_, names_.get()}
+                  : TensorNameList{outputNames_};
 }
+const std::vector<TensorId> &Node::inputIds() const { return inputIds_; }
+const std::vector<TensorId> &Node::outputIds() const { return outputIds_; }
 const Attributes &Node::attributes() const { return attributes_; }
 
 void Node::setInputs(const std::vector<std::string> &inputs) {
-    inputs_ = inputs;
+    detach();
+    inputNames_ = inputs;
 }
 
 void Node::setInputs(const name_t &inputs) {
-    inputs_.clear();
-    inputs_.reserve(static_cast<std::size_t>(inputs.size()));
-    for (const auto &s : inputs)
-        inputs_.push_back(s);
+    detach();
+    inputNames_.assign(inputs.begin(), inputs.end());
 }
 
 void Node::setOutputs(const std::vector<std::string> &outputs) {
-    outputs_ = outputs;
+    detach();
+    outputNames_ = outputs;
 }
 
 void Node::setOutputs(const name_t &outputs) {
-    outputs_.clear();
-    outputs_.reserve(static_cast<std::size_t>(outputs.size()));
-    for (const auto &s : outputs)
-        outputs_.push_back(s);
+    detach();
+    outputNames_.assign(outputs.begin(), outputs.end());
 }
 
 void Node::parseAttributes(const onnx::NodeProto &node) {
@@ -86,10 +93,24 @@ void Node::parseAttributes(const onnx::NodeProto &node) {
 }
 
 void Node::addInput(const std::string &input) {
-    inputs_.push_back(input);
+    detach();
+    inputNames_.push_back(input);
 }
 void Node::addOutput(const std::string &output) {
-    outputs_.push_back(output);
+    detach();
+    outputNames_.push_back(output);
+}
+
+void Node::detach() {
+    if (!names_)
+        return;
+    const TensorNameList in = inputs();
+    const TensorNameList out = outputs();
+    inputNames_.assign(in.begin(), in.end());
+    outputNames_.assign(out.begin(), out.end());
+    inputIds_.clear();
+    outputIds_.clear();
+    names_.reset();
 }
 
 void Node::setAttribute(const std::string &name,
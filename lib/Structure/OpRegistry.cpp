@@ -0,0 +1,161 @@
+#include "Structure/OpRegistry.h"
+#include "Structure/Graph.h"
+
+#include <stdexcept>
+
+namespace tensor_compiler {
+
+namespace {
+
+// Elements of a tensor, or 0 if its shape is unknown or dynamic.
+std::uint64_t elements(const Graph &graph, const std::string &name) {
+    const Tensor *tensor = graph.tensor(name);
+    if (!tensor || tensor->type() == onnx::TensorProto_DataType_UNDEFINED) {
+        return 0;
+    }
+    std::uint64_t count = 1;
+    for (int64_t d : tensor->shape()) {
+        if (d < 0) {
+            return 0;
+        }
+        count *= static_cast<std::uint64_t>(d);
+    }
+    return count;
+}
+
+std::uint64_t inputElements(const Graph &graph, const Node &node) {
+    return node.inputs().empty() ? 0 : elements(graph, node.inputs()[0]);
+}
+
+std::uint64_t outputElements(const Graph &graph, const Node &node) {
+    return node.outputs().empty() ? 0 : elements(graph, node.outputs()[0]);
+}
+
+// A multiply-add per filter tap and output element.
+std::uint64_t convCost(const Graph &graph, const Node &node) {
+    const Tensor *filter =
+        node.inputs().size() > 1 ? graph.tensor(node.inputs()[1]) : nullptr;
+    if (!filter || filter->shape().empty() || filter->shape()[0] <= 0) {
+        return 0;
+    }
+    const std::uint64_t taps = elements(graph, node.inputs()[1]) /
+                               static_cast<std::uint64_t>(filter->shape()[0]);
+    return 2 * taps * outputElements(graph, node);
+}
+
+std::uint64_t matMulCost(const Graph &graph, const Node &node) {
+    const Tensor *lhs =
+        node.inputs().empty() ? nullptr : graph.tensor(node.inputs()[0]);
+    if (!lhs || lhs->shape().empty() || lhs->shape().back() < 0) {
+        return 0;
+    }
+    return 2 * static_cast<std::uint64_t>(lhs->shape().back()) *
+           outputElements(graph, node);
+}
+
+std::uint64_t maxPoolCost(const Graph &graph, const Node &node) {
+    std::uint64_t window = 1;
+    auto it = node.attributes().find("kernel_shape");
+    if (it != node.attributes().end()) {
+        if (const auto *kernel =
+                std::get_if<std::vector<int64_t>>(&it->second.value())) {
+            for (int64_t k : *kernel) {
+                window *= static_cast<std::uint64_t>(k > 0 ? k : 1);
+            }
+        }
+    }
+    return window * outputElements(graph, node);
+}
+
+std::uint64_t noCost(const Graph &, const Node &) { return 0; }
+
+} // namespace
+
+OpRegistry::OpRegistry() {
+    auto add = [this](std::string_view opcode, OpInfo info) {
+        registerOp(opcode, std::move(info));
+    };
+
+    for (std::string_view op : {"Add", "Sub", "Mul", "Div", "Relu"}) {
+        add(op, {nullptr, outputElements, true});
+    }
+    // Scale and shift per channel.
+    add("BatchNormalization",
+        {nullptr,
+         [](const Graph &graph, const Node &node) {
+             return 2 * outputElements(graph, node);
+         },
+         true});
+    for (std::string_view op : {"Identity", "Reshape", "Squeeze"}) {
+        add(op, {nullptr, noCost, false});
+    }
+    add("Conv", {nullptr, convCost, false});
+    add("MatMul", {nullptr, matMulCost, false});
+    add("MaxPool", {nullptr, maxPoolCost, false});
+    add("ReduceMean", {nullptr, inputElements, false});
+    add("ArgMax", {nullptr, inputElements, false});
+    // Max, subtract and exp, sum, divide.
+    add("Softmax",
+        {nullptr,
+         [](const Graph &graph, const Node &node) {
+             return 4 * inputElements(graph, node);
+         },
+         false});
+}
+
+OpRegistry &OpRegistry::instance() {
+    static OpRegistry registry;
+    return registry;
+}
+
+OpId OpRegistry::intern(std::string_view opcode) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ids_.find(std::string(opcode));
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    const OpId id = static_cast<OpId>(names_.size());
+    names_.emplace_back(opcode);
+    infos_.emplace_back();
+    ids_.emplace(names_.back(), id);
+    return id;
+}
+
+std::optional<OpId> OpRegistry::find(std::string_view opcode) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ids_.find(std::string(opcode));
+    if (it == ids_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+const std::string &OpRegistry::name(OpId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id >= names_.size()) {
+        throw std::out_of_range("unknown op id " + std::to_string(id));
+    }
+    return names_[id];
+}
+
+const OpInfo &OpRegistry::info(OpId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id >= infos_.size()) {
+        throw std::out_of_range("unknown op id " + std::to_string(id));
+    }
+    return infos_[id];
+}
+
+OpId OpRegistry::registerOp(std::string_view opcode, OpInfo info) {
+    const OpId id = intern(opcode);
+    std::lock_guard<std::mutex> lock(mutex_);
+    infos_[id] = std::move(info);
+    return id;
+}
+
+std::size_t OpRegistry::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return names_.size();
+}
+
+} // namespace tensor_compiler
@@ -2,6 +2,37 @@
 
 namespace tensor_compiler {
 
+// ----------------------------------------------------------------------------
+// @section Implementations
+// Implementation of tensor name table methods.
+// ----------------------------------------------------------------------------
+TensorId TensorNames::intern(std::string_view name) {
+    if (name.empty())
+        return kNoTensor;
+    auto it = ids_.find(name);
+    if (it != ids_.end())
+        return it->second;
+
+    const auto id = static_cast<TensorId>(names_.size());
+    names_.emplace_back(name);
+    ids_.emplace(names_.back(), id);
+    return id;
+}
+
+std::optional<TensorId> TensorNames::find(std::string_view name) const {
+    auto it = ids_.find(name);
+    if (it == ids_.end())
+        return std::nullopt;
+    return it->second;
+}
+
+const std::string &TensorNames::name(TensorId id) const {
+    static const std::string none;
+    return id == kNoTensor ? none : names_.at(id);
+}
+
+std::size_t TensorNames::size() const { return names_.size(); }
+
 // ----------------------------------------------------------------------------
 // @section Implementations
 // Implementation of tensor methods.
@@ -20,17 +51,31 @@ Tensor Tensor::create(const std::string &name,
                   kind);
 }
 
-const std::string &Tensor::name() const { return name_; }
+const std::string &Tensor::name() const {
+    return names_ ? names_->name(id_) : name_;
+}
 int Tensor::type() const { return type_; }
-const std::string &Tensor::data() const { return data_; }
+std::string_view Tensor::data() const { return data_; }
 const std::vector<int64_t> &Tensor::shape() const { return shape_; }
 Tensor_kind Tensor::kind() const { return kind_; }
 const dim_type Tensor::dim() const { return dim_; }
 
-void Tensor::setName(const std::string &name) { name_ = name; }
+void Tensor::setName(const std::string &name) {
+    names_.reset();
+    id_ = kNoTensor;
+    name_ = name;
+}
 void Tensor::setType(const int type) { type_ = type; }
 void Tensor::setKind(Tensor_kind kind) { kind_ = kind; }
-void Tensor::setData(const std::string &data) { data_ = data; }
+void Tensor::setData(std::string data) {
+    storage_ = std::make_shared<const std::string>(std::move(data));
+    data_ = *storage_;
+}
+
+void Tensor::setDataView(std::string_view data) {
+    storage_.reset();
+    data_ = data;
+}
 void Tensor::setShape(const std::vector<int64_t> &shape) {
     shape_ = shape;
     dim_.Clear();
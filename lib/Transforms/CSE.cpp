@@ -0,0 +1,122 @@
+#include "Transforms/PassManager.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace tensor_compiler {
+
+namespace {
+
+// Ops whose results differ between two evaluations with equal inputs.
+bool isNondeterministic(const std::string &opcode) {
+    static const std::unordered_set<std::string> ops = {
+        "RandomNormal", "RandomNormalLike", "RandomUniform",
+        "RandomUniformLike", "Multinomial", "Bernoulli"};
+    return ops.count(opcode) != 0;
+}
+
+bool sameAttributes(const Node &a, const Node &b) {
+    if (a.attributes().size() != b.attributes().size()) {
+        return false;
+    }
+    for (const auto &[name, attribute] : a.attributes()) {
+        auto it = b.attributes().find(name);
+        if (it == b.attributes().end() ||
+            it->second.value() != attribute.value()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string signature(const Node &node) {
+    std::string key = node.opcode();
+    for (const std::string &input : node.inputs()) {
+        key += '\0';
+        key += input;
+    }
+    return key;
+}
+
+class CSEPass final : public GraphPass {
+public:
+    std::string_view name() const override { return "cse"; }
+
+    bool run(Graph &graph) override {
+        const std::unordered_set<std::string> graphOutputs(
+            graph.outputs().begin(), graph.outputs().end());
+        // Signature -> indices of the kept nodes with it.
+        std::unordered_map<std::string, std::vector<size_t>> seen;
+        std::vector<bool> removed(graph.nodes().size(), false);
+        bool changed = false;
+
+        // Renaming uses while walking in order lets duplicates of merged
+        // nodes be found in the same sweep.
+        for (size_t i = 0; i < graph.nodes().size(); ++i) {
+            const Node &node = graph.nodes()[i];
+            if (node.outputs().empty() || isNondeterministic(node.opcode())) {
+                continue;
+            }
+
+            auto &candidates = seen[signature(node)];
+            auto match = std::find_if(
+                candidates.begin(), candidates.end(), [&](size_t j) {
+                    const Node &other = graph.nodes()[j];
+                    if (other.outputs().size() != node.outputs().size() ||
+                        !sameAttributes(other, node)) {
+                        return false;
+                    }
+                    // Every used output needs a counterpart to forward to.
+                    for (size_t k = 0; k < node.outputs().size(); ++k) {
+                        if (!node.outputs()[k].empty() &&
+                            other.outputs()[k].empty()) {
+                            return false;
+                        }
+                    }
+                    return true;
+                });
+            const bool outputIsReturned = std::any_of(
+                node.outputs().begin(), node.outputs().end(),
+                [&](const std::string &name) {
+                    return graphOutputs.count(name) != 0;
+                });
+            if (match == candidates.end() || outputIsReturned) {
+                candidates.push_back(i);
+                continue;
+            }
+
+            const std::vector<std::string> from = node.outputs();
+            const std::vector<std::string> to = graph.nodes()[*match].outputs();
+            for (size_t k = 0; k < from.size(); ++k) {
+                if (!from[k].empty()) {
+                    graph.replaceUses(from[k], to[k]);
+                }
+            }
+            removed[i] = true;
+            changed = true;
+        }
+
+        if (!changed) {
+            return false;
+        }
+        std::vector<Node> kept;
+        for (size_t i = 0; i < graph.nodes().size(); ++i) {
+            if (!removed[i]) {
+                kept.push_back(graph.nodes()[i]);
+            }
+        }
+        graph.setNodes(std::move(kept));
+        return true;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<GraphPass> createCSEPass() {
+    return std::make_unique<CSEPass>();
+}
+
+} // namespace tensor_compiler
@@ -0,0 +1,445 @@
+#include "Transforms/PassManager.h"
+#include "Transforms/ShapeInference.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace tensor_compiler {
+
+namespace {
+
+// Folding must not turn a small broadcast into a huge initializer; outputs
+// are limited to this many bytes at 8 bytes per element.
+constexpr size_t kMaxFoldedBytes = size_t{64} << 20;
+
+using Shape = std::vector<int64_t>;
+
+// A constant input: its metadata and bytes.
+struct ConstantValue {
+    int type;
+    Shape shape;
+    std::string_view data;
+};
+
+// Computes the bytes of a node's single output, whose type and static shape
+// come from shape inference, or std::nullopt if it cannot be folded.
+using FoldFn = std::optional<std::string> (*)(
+    const Node &node, const std::vector<ConstantValue> &inputs,
+    const Tensor &output);
+
+size_t elementCount(const Shape &shape) {
+    size_t count = 1;
+    for (int64_t d : shape) {
+        count *= static_cast<size_t>(d);
+    }
+    return count;
+}
+
+// Offset into an input broadcast to outShape for every output element.
+std::vector<size_t> broadcastOffsets(const Shape &outShape,
+                                     const Shape &inShape) {
+    const size_t rank = outShape.size();
+    std::vector<size_t> strides(rank, 0);
+    size_t stride = 1;
+    for (size_t i = 0; i < inShape.size(); ++i) {
+        size_t axis = rank - 1 - i;
+        int64_t dim = inShape[inShape.size() - 1 - i];
+        strides[axis] = dim == 1 ? 0 : stride;
+        stride *= static_cast<size_t>(dim);
+    }
+
+    std::vector<size_t> offsets(elementCount(outShape));
+    std::vector<int64_t> index(rank, 0);
+    size_t offset = 0;
+    for (size_t n = 0; n < offsets.size(); ++n) {
+        offsets[n] = offset;
+        for (size_t axis = rank; axis-- > 0;) {
+            offset += strides[axis];
+            if (++index[axis] < outShape[axis]) {
+                break;
+            }
+            offset -= strides[axis] * static_cast<size_t>(index[axis]);
+            index[axis] = 0;
+        }
+    }
+    return offsets;
+}
+
+template <typename T>
+std::vector<T> values(std::string_view data) {
+    std::vector<T> out(data.size() / sizeof(T));
+    std::memcpy(out.data(), data.data(), out.size() * sizeof(T));
+    return out;
+}
+
+template <typename T>
+std::string bytes(const std::vector<T> &values) {
+    return std::string(reinterpret_cast<const char *>(values.data()),
+                       values.size() * sizeof(T));
+}
+
+template <typename T>
+std::optional<std::string> foldBinary(const std::string &op,
+                                      const ConstantValue &lhs,
+                                      const ConstantValue &rhs,
+                                      const Shape &outShape) {
+    const std::vector<T> a = values<T>(lhs.data);
+    const std::vector<T> b = values<T>(rhs.data);
+    if (a.size() != elementCount(lhs.shape) ||
+        b.size() != elementCount(rhs.shape)) {
+        return std::nullopt;
+    }
+    const std::vector<size_t> aIdx = broadcastOffsets(outShape, lhs.shape);
+    const std::vector<size_t> bIdx = broadcastOffsets(outShape, rhs.shape);
+
+    // Add, Sub, Mul or Div.
+    const char kind = op[0];
+    std::vector<T> out(aIdx.size());
+    for (size_t i = 0; i < out.size(); ++i) {
+        T x = a[aIdx[i]];
+        T y = b[bIdx[i]];
+        switch (kind) {
+        case 'A':
+            out[i] = x + y;
+            break;
+        case 'S':
+            out[i] = x - y;
+            break;
+        case 'M':
+            out[i] = x * y;
+            break;
+        default:
+            if constexpr (std::is_integral_v<T>) {
+                if (y == 0) {
+                    return std::nullopt;
+                }
+            }
+            out[i] = x / y;
+        }
+    }
+    return bytes(out);
+}
+
+std::optional<std::string> foldElementwise(const Node &node,
+                                           const std::vector<ConstantValue> &in,
+                                           const Tensor &output) {
+    if (in.size() != 2 || in[0].type != in[1].type) {
+        return std::nullopt;
+    }
+    switch (in[0].type) {
+    case onnx::TensorProto_DataType_FLOAT:
+        return foldBinary<float>(node.opcode(), in[0], in[1], output.shape());
+    case onnx::TensorProto_DataType_INT64:
+        return foldBinary<int64_t>(node.opcode(), in[0], in[1],
+                                   output.shape());
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<std::string> foldRelu(const Node &,
+                                    const std::vector<ConstantValue> &in,
+                                    const Tensor &) {
+    if (in.size() != 1 || in[0].type != onnx::TensorProto_DataType_FLOAT) {
+        return std::nullopt;
+    }
+    std::vector<float> x = values<float>(in[0].data);
+    for (float &v : x) {
+        v = std::max(v, 0.0f);
+    }
+    return bytes(x);
+}
+
+// Reshape, Squeeze, Unsqueeze and Identity keep the bytes; the new shape
+// comes from shape inference.
+std::optional<std::string> foldCopy(const Node &,
+                                    const std::vector<ConstantValue> &in,
+                                    const Tensor &) {
+    if (in.empty()) {
+        return std::nullopt;
+    }
+    return std::string(in[0].data);
+}
+
+// Bytes per element of a constant, or 0 if its data does not match the shape.
+size_t byteWidth(const ConstantValue &value) {
+    const size_t count = elementCount(value.shape);
+    if (count == 0 || value.data.size() % count != 0) {
+        return 0;
+    }
+    return value.data.size() / count;
+}
+
+template <typename T>
+T attributeOr(const Node &node, const std::string &name, T defaultValue) {
+    auto it = node.attributes().find(name);
+    if (it == node.attributes().end()) {
+        return defaultValue;
+    }
+    const T *value = std::get_if<T>(&it->second.value());
+    return value ? *value : defaultValue;
+}
+
+// Only reads the static shape of its input, which need not be constant.
+std::optional<std::string> foldShape(const Node &node,
+                                     const std::vector<ConstantValue> &in,
+                                     const Tensor &output) {
+    if (in.size() != 1) {
+        return std::nullopt;
+    }
+    const Shape &shape = in[0].shape;
+    const int64_t rank = static_cast<int64_t>(shape.size());
+    int64_t start = attributeOr<int64_t>(node, "start", 0);
+    start = std::clamp<int64_t>(start < 0 ? start + rank : start, 0, rank);
+    if (output.shape().size() != 1 ||
+        start + output.shape()[0] > rank) {
+        return std::nullopt;
+    }
+    return bytes(Shape(shape.begin() + start,
+                       shape.begin() + start + output.shape()[0]));
+}
+
+std::optional<std::string> foldGather(const Node &node,
+                                      const std::vector<ConstantValue> &in,
+                                      const Tensor &) {
+    if (in.size() != 2 || in[0].shape.empty()) {
+        return std::nullopt;
+    }
+    std::vector<int64_t> indices;
+    if (in[1].type == onnx::TensorProto_DataType_INT64) {
+        indices = values<int64_t>(in[1].data);
+    } else if (in[1].type == onnx::TensorProto_DataType_INT32) {
+        for (int32_t i : values<int32_t>(in[1].data)) {
+            indices.push_back(i);
+        }
+    } else {
+        return std::nullopt;
+    }
+
+    const ConstantValue &data = in[0];
+    const size_t width = byteWidth(data);
+    const int64_t rank = static_cast<int64_t>(data.shape.size());
+    int64_t axis = attributeOr<int64_t>(node, "axis", 0);
+    axis = axis < 0 ? axis + rank : axis;
+    if (width == 0 || axis < 0 || axis >= rank) {
+        return std::nullopt;
+    }
+
+    const int64_t dim = data.shape[static_cast<size_t>(axis)];
+    const size_t outer = elementCount(
+        Shape(data.shape.begin(), data.shape.begin() + axis));
+    const size_t block = width * elementCount(Shape(
+        data.shape.begin() + axis + 1, data.shape.end()));
+
+    std::string out;
+    out.reserve(outer * indices.size() * block);
+    for (size_t o = 0; o < outer; ++o) {
+        for (int64_t index : indices) {
+            index = index < 0 ? index + dim : index;
+            if (index < 0 || index >= dim) {
+                return std::nullopt;
+            }
+            size_t offset = (o * static_cast<size_t>(dim) +
+                             static_cast<size_t>(index)) * block;
+            out.append(data.data.substr(offset, block));
+        }
+    }
+    return out;
+}
+
+std::optional<std::string> foldConcat(const Node &node,
+                                      const std::vector<ConstantValue> &in,
+                                      const Tensor &output) {
+    if (in.empty()) {
+        return std::nullopt;
+    }
+    const int64_t rank = static_cast<int64_t>(output.shape().size());
+    int64_t axis = attributeOr<int64_t>(node, "axis", 0);
+    axis = axis < 0 ? axis + rank : axis;
+    if (axis < 0 || axis >= rank) {
+        return std::nullopt;
+    }
+
+    // Every input contributes one contiguous block per outer index.
+    const size_t outer = elementCount(
+        Shape(output.shape().begin(), output.shape().begin() + axis));
+    std::vector<size_t> blocks;
+    for (const ConstantValue &value : in) {
+        if (value.type != in[0].type) {
+            return std::nullopt;
+        }
+        blocks.push_back(outer == 0 ? 0 : value.data.size() / outer);
+    }
+
+    std::string out;
+    for (size_t o = 0; o < outer; ++o) {
+        for (size_t i = 0; i < in.size(); ++i) {
+            out.append(in[i].data.substr(o * blocks[i], blocks[i]));
+        }
+    }
+    return out;
+}
+
+std::optional<std::string> foldTranspose(const Node &node,
+                                         const std::vector<ConstantValue> &in,
+                                         const Tensor &output) {
+    if (in.size() != 1) {
+        return std::nullopt;
+    }
+    const ConstantValue &x = in[0];
+    const size_t width = byteWidth(x);
+    const size_t rank = x.shape.size();
+    if (width == 0 || output.shape().size() != rank) {
+        return std::nullopt;
+    }
+
+    std::vector<int64_t> perm;
+    for (size_t i = rank; i-- > 0;) {
+        perm.push_back(static_cast<int64_t>(i));
+    }
+    perm = attributeOr<std::vector<int64_t>>(node, "perm", perm);
+
+    // Stride in the input of each output axis.
+    std::vector<size_t> inStrides(rank, 1);
+    for (size_t i = rank; i-- > 1;) {
+        inStrides[i - 1] = inStrides[i] * static_cast<size_t>(x.shape[i]);
+    }
+    std::vector<size_t> strides;
+    for (int64_t axis : perm) {
+        axis = axis < 0 ? axis + static_cast<int64_t>(rank) : axis;
+        if (axis < 0 || axis >= static_cast<int64_t>(rank)) {
+            return std::nullopt;
+        }
+        strides.push_back(inStrides[static_cast<size_t>(axis)]);
+    }
+
+    const Shape &outShape = output.shape();
+    std::string out(x.data.size(), '\0');
+    std::vector<int64_t> index(rank, 0);
+    size_t offset = 0;
+    for (size_t n = 0; n < elementCount(outShape); ++n) {
+        std::memcpy(out.data() + n * width, x.data.data() + offset * width,
+                    width);
+        for (size_t axis = rank; axis-- > 0;) {
+            offset += strides[axis];
+            if (++index[axis] < outShape[axis]) {
+                break;
+            }
+            offset -= strides[axis] * static_cast<size_t>(index[axis]);
+            index[axis] = 0;
+        }
+    }
+    return out;
+}
+
+const std::unordered_map<std::string, FoldFn> &foldFunctions() {
+    static const std::unordered_map<std::string, FoldFn> table = {
+        {"Add", foldElementwise},  {"Sub", foldElementwise},
+        {"Mul", foldElementwise},  {"Div", foldElementwise},
+        {"Relu", foldRelu},        {"Identity", foldCopy},
+        {"Reshape", foldCopy},     {"Squeeze", foldCopy},
+        {"Unsqueeze", foldCopy},   {"Shape", foldShape},
+        {"Gather", foldGather},    {"Concat", foldConcat},
+        {"Transpose", foldTranspose},
+    };
+    return table;
+}
+
+bool hasStaticShape(const Tensor &tensor) {
+    return std::all_of(tensor.shape().begin(), tensor.shape().end(),
+                       [](int64_t d) { return d >= 0; });
+}
+
+class ConstantFoldingPass final : public GraphPass {
+public:
+    std::string_view name() const override { return "constant-fold"; }
+
+    bool run(Graph &graph) override {
+        bool changed = false;
+        // A fold can make a later Reshape shape constant, which shape
+        // inference then resolves.
+        while (sweep(graph)) {
+            inferShapes(graph);
+            changed = true;
+        }
+        return changed;
+    }
+
+private:
+    // Folds what it can in one walk and drops the folded nodes.
+    bool sweep(Graph &graph) {
+        std::vector<Node> kept;
+        bool changed = false;
+
+        for (const Node &node : graph.nodes()) {
+            auto folded = fold(graph, node);
+            if (!folded) {
+                kept.push_back(node);
+                continue;
+            }
+            const std::string &outName = node.outputs()[0];
+            const Tensor *output = graph.tensor(outName);
+            graph.addTensor(Tensor(outName,
+                                   static_cast<data_type>(output->type()),
+                                   output->shape(), *folded,
+                                   Tensor_kind::constant));
+            changed = true;
+        }
+
+        if (changed) {
+            graph.setNodes(std::move(kept));
+        }
+        return changed;
+    }
+
+    static std::optional<std::string> fold(const Graph &graph,
+                                           const Node &node) {
+        auto fn = foldFunctions().find(node.opcode());
+        if (fn == foldFunctions().end() || node.outputs().size() != 1) {
+            return std::nullopt;
+        }
+        // Graph outputs are written by a node into the caller's buffer.
+        const auto &graphOutputs = graph.outputs();
+        if (std::find(graphOutputs.begin(), graphOutputs.end(),
+                      node.outputs()[0]) != graphOutputs.end()) {
+            return std::nullopt;
+        }
+        const Tensor *output = graph.tensor(node.outputs()[0]);
+        if (!output ||
+            output->type() == onnx::TensorProto_DataType_UNDEFINED ||
+            !hasStaticShape(*output) ||
+            elementCount(output->shape()) > kMaxFoldedBytes / sizeof(int64_t)) {
+            return std::nullopt;
+        }
+
+        // Shape only needs its input's static shape, so a Shape of an
+        // activation folds as well.
+        const bool needsData = node.opcode() != "Shape";
+        std::vector<ConstantValue> inputs;
+        for (const std::string &name : node.inputs()) {
+            const Tensor *tensor = graph.tensor(name);
+            if (!tensor ||
+                tensor->type() == onnx::TensorProto_DataType_UNDEFINED ||
+                (needsData && !tensor->isConstant()) ||
+                !hasStaticShape(*tensor)) {
+                return std::nullopt;
+            }
+            inputs.push_back({tensor->type(), tensor->shape(), tensor->data()});
+        }
+
+        return fn->second(node, inputs, *output);
+    }
+};
+
+} // namespace
+
+std::unique_ptr<GraphPass> createConstantFoldingPass() {
+    return std::make_unique<ConstantFoldingPass>();
+}
+
+} // namespace tensor_compiler
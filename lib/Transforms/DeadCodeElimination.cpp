@@ -0,0 +1,55 @@
+#include "Transforms/PassManager.h"
+
+#include <unordered_set>
+#include <vector>
+
+namespace tensor_compiler {
+
+namespace {
+
+class DeadCodeEliminationPass final : public GraphPass {
+public:
+    std::string_view name() const override { return "dce"; }
+
+    bool run(Graph &graph) override {
+        const std::vector<Node> &nodes = graph.nodes();
+        std::unordered_set<std::string> live(graph.outputs().begin(),
+                                             graph.outputs().end());
+        std::vector<bool> keep(nodes.size(), false);
+
+        // Consumers come after producers, so one backward sweep sees every
+        // use of a tensor before its producer.
+        for (size_t i = nodes.size(); i-- > 0;) {
+            for (const std::string &output : nodes[i].outputs()) {
+                if (live.count(output)) {
+                    keep[i] = true;
+                    break;
+                }
+            }
+            if (keep[i]) {
+                live.insert(nodes[i].inputs().begin(), nodes[i].inputs().end());
+            }
+        }
+
+        std::vector<Node> kept;
+        kept.reserve(nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (keep[i]) {
+                kept.push_back(nodes[i]);
+            }
+        }
+        if (kept.size() == nodes.size()) {
+            return false;
+        }
+        graph.setNodes(std::move(kept));
+        return true;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<GraphPass> createDeadCodeEliminationPass() {
+    return std::make_unique<DeadCodeEliminationPass>();
+}
+
+} // namespace tensor_compiler
@@ -0,0 +1,228 @@
+#include "Transforms/FoldBatchNorm.h"
+#include "Transforms/PassManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace tensor_compiler {
+
+namespace {
+
+std::optional<std::vector<float>> readConstantF32(const Graph &graph,
+                                                  const std::string &name,
+                                                  size_t rank) {
+    const Tensor *tensor = graph.tensor(name);
+    if (!tensor || !tensor->isConstant() ||
+        tensor->type() != onnx::TensorProto_DataType_FLOAT ||
+        tensor->shape().size() != rank) {
+        return std::nullopt;
+    }
+
+    size_t elementCount = 1;
+    for (int64_t d : tensor->shape()) {
+        if (d < 0) {
+            return std::nullopt;
+        }
+        elementCount *= static_cast<size_t>(d);
+    }
+
+    const auto &raw = tensor->data();
+    if (raw.size() != elementCount * sizeof(float)) {
+        return std::nullopt;
+    }
+
+    std::vector<float> data(elementCount);
+    std::memcpy(data.data(), raw.data(), raw.size());
+    return data;
+}
+
+template <typename T>
+T getAttributeOr(const Node &node, const std::string &name, T defaultValue) {
+    auto it = node.attributes().find(name);
+    if (it == node.attributes().end()) {
+        return defaultValue;
+    }
+    const T *value = std::get_if<T>(&it->second.value());
+    return value ? *value : defaultValue;
+}
+
+std::string uniqueTensorName(const Graph &graph, const std::string &base) {
+    std::string name = base;
+    for (size_t i = 1; graph.tensor(name); ++i) {
+        name = base + "_" + std::to_string(i);
+    }
+    return name;
+}
+
+// Reading nodes plus graph outputs.
+size_t useCount(const Graph &graph, const std::string &name) {
+    return graph.consumers(name).size() +
+           static_cast<size_t>(std::count(graph.outputs().begin(),
+                                          graph.outputs().end(), name));
+}
+
+bool isInferenceBatchNorm(const Node &node) {
+    if (node.opcode() != "BatchNormalization" || node.inputs().size() != 5 ||
+        node.outputs().empty() || node.outputs()[0].empty()) {
+        return false;
+    }
+    if (getAttributeOr<int64_t>(node, "training_mode", 0) != 0) {
+        return false;
+    }
+    // running_mean/running_var outputs only exist in training mode.
+    for (size_t i = 1; i < node.outputs().size(); ++i) {
+        if (!node.outputs()[i].empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+std::size_t foldConvBatchNorm(Graph &graph) {
+    // Rewrites go to a copy; the def-use index of graph keeps describing
+    // the original nodes, which have the same indices.
+    std::vector<Node> nodes = graph.nodes();
+
+    std::vector<bool> removed(nodes.size(), false);
+    std::unordered_set<std::string> replaced;
+    std::size_t folded = 0;
+
+    for (size_t bnIdx = 0; bnIdx < nodes.size(); ++bnIdx) {
+        const Node &bn = nodes[bnIdx];
+        if (!isInferenceBatchNorm(bn)) {
+            continue;
+        }
+
+        const std::string &convOut = bn.inputs()[0];
+        auto convIdx = graph.producer(convOut);
+        if (!convIdx || useCount(graph, convOut) != 1) {
+            continue;
+        }
+        Node &conv = nodes[*convIdx];
+        if (conv.opcode() != "Conv" || conv.outputs().size() != 1 ||
+            conv.inputs().size() < 2 || conv.inputs().size() > 3) {
+            continue;
+        }
+
+        auto weights = readConstantF32(graph, conv.inputs()[1], 4);
+        if (!weights) {
+            continue;
+        }
+        const std::vector<int64_t> filterShape =
+            graph.tensor(conv.inputs()[1])->shape();
+        const size_t filters = static_cast<size_t>(filterShape[0]);
+        if (filters == 0) {
+            continue;
+        }
+
+        std::vector<float> convBias(filters, 0.0f);
+        const bool hasBias =
+            conv.inputs().size() == 3 && !conv.inputs()[2].empty();
+        if (hasBias) {
+            auto bias = readConstantF32(graph, conv.inputs()[2], 1);
+            if (!bias || bias->size() != filters) {
+                continue;
+            }
+            convBias = *bias;
+        }
+
+        std::vector<std::vector<float>> params;
+        for (size_t i = 1; i < 5; ++i) {
+            auto param = readConstantF32(graph, bn.inputs()[i], 1);
+            if (!param || param->size() != filters) {
+                break;
+            }
+            params.push_back(std::move(*param));
+        }
+        if (params.size() != 4) {
+            continue;
+        }
+        const auto &scale = params[0];
+        const auto &beta = params[1];
+        const auto &mean = params[2];
+        const auto &var = params[3];
+        const double epsilon = getAttributeOr<float>(bn, "epsilon", 1.0e-5f);
+
+        const size_t perFilter = weights->size() / filters;
+        std::vector<float> newWeights(weights->size());
+        std::vector<float> newBias(filters);
+        for (size_t f = 0; f < filters; ++f) {
+            double s = scale[f] / std::sqrt(static_cast<double>(var[f]) + epsilon);
+            for (size_t k = 0; k < perFilter; ++k) {
+                size_t idx = f * perFilter + k;
+                newWeights[idx] = static_cast<float>((*weights)[idx] * s);
+            }
+            newBias[f] = static_cast<float>((convBias[f] - mean[f]) * s + beta[f]);
+        }
+
+        const std::string &bnOut = bn.outputs()[0];
+        std::string weightName = uniqueTensorName(graph, bnOut + "_folded_W");
+        graph.addTensor(Tensor::create(weightName, filterShape, newWeights,
+                                       Tensor_kind::constant));
+        std::string biasName = uniqueTensorName(graph, bnOut + "_folded_B");
+        graph.addTensor(Tensor::create(biasName,
+                                       {static_cast<int64_t>(filters)},
+                                       newBias, Tensor_kind::constant));
+
+        for (size_t i = 1; i < conv.inputs().size(); ++i) {
+            replaced.insert(conv.inputs()[i]);
+        }
+        for (size_t i = 1; i < 5; ++i) {
+            replaced.insert(bn.inputs()[i]);
+        }
+
+        conv.setInputs(std::vector<std::string>{conv.inputs()[0], weightName,
+                                                biasName});
+        conv.setOutputs(std::vector<std::string>{bnOut});
+        graph.removeTensor(convOut);
+        removed[bnIdx] = true;
+        ++folded;
+    }
+
+    if (folded == 0) {
+        return 0;
+    }
+
+    std::vector<Node> kept;
+    kept.reserve(nodes.size() - folded);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (!removed[i]) {
+            kept.push_back(std::move(nodes[i]));
+        }
+    }
+    graph.setNodes(std::move(kept));
+
+    // Old weights and BN parameters may still feed other nodes.
+    for (const std::string &name : replaced) {
+        const Tensor *tensor = graph.tensor(name);
+        if (tensor && tensor->isConstant() && useCount(graph, name) == 0) {
+            graph.removeTensor(name);
+        }
+    }
+
+    return folded;
+}
+
+namespace {
+
+class FoldBatchNormPass final : public GraphPass {
+public:
+    std::string_view name() const override { return "fold-batch-norm"; }
+
+    bool run(Graph &graph) override { return foldConvBatchNorm(graph) > 0; }
+};
+
+} // namespace
+
+std::unique_ptr<GraphPass> createFoldBatchNormPass() {
+    return std::make_unique<FoldBatchNormPass>();
+}
+
+} // namespace tensor_compiler
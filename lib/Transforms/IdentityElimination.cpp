@@ -0,0 +1,56 @@
+#include "Transforms/PassManager.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace tensor_compiler {
+
+namespace {
+
+class IdentityEliminationPass final : public GraphPass {
+public:
+    std::string_view name() const override { return "identity"; }
+
+    bool run(Graph &graph) override {
+        std::vector<bool> removed(graph.nodes().size(), false);
+        bool changed = false;
+
+        for (size_t i = 0; i < graph.nodes().size(); ++i) {
+            const Node &node = graph.nodes()[i];
+            if (node.opcode() != "Identity" || node.inputs().size() != 1 ||
+                node.outputs().size() != 1 || node.inputs()[0].empty()) {
+                continue;
+            }
+            const std::string input = node.inputs()[0];
+            const std::string output = node.outputs()[0];
+            const auto &outputs = graph.outputs();
+            if (std::find(outputs.begin(), outputs.end(), output) !=
+                outputs.end()) {
+                continue;
+            }
+            graph.replaceUses(output, input);
+            removed[i] = true;
+            changed = true;
+        }
+
+        if (!changed) {
+            return false;
+        }
+        std::vector<Node> kept;
+        for (size_t i = 0; i < graph.nodes().size(); ++i) {
+            if (!removed[i]) {
+                kept.push_back(graph.nodes()[i]);
+            }
+        }
+        graph.setNodes(std::move(kept));
+        return true;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<GraphPass> createIdentityEliminationPass() {
+    return std::make_unique<IdentityEliminationPass>();
+}
+
+} // namespace tensor_compiler
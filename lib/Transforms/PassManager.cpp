@@ -0,0 +1,55 @@
+#include "Transforms/PassManager.h"
+
+#include <stdexcept>
+
+namespace tensor_compiler {
+
+void PassManager::addPass(std::unique_ptr<GraphPass> pass) {
+    passes_.push_back(std::move(pass));
+}
+
+void PassManager::disable(const std::string &name) {
+    for (const auto &pass : passes_) {
+        if (pass->name() == name) {
+            disabled_.insert(name);
+            return;
+        }
+    }
+    throw std::runtime_error("unknown graph pass: " + name);
+}
+
+std::vector<std::string> PassManager::passNames() const {
+    std::vector<std::string> names;
+    names.reserve(passes_.size());
+    for (const auto &pass : passes_) {
+        names.emplace_back(pass->name());
+    }
+    return names;
+}
+
+bool PassManager::run(Graph &graph) const {
+    bool changed = false;
+    for (int round = 0; round < kMaxRounds; ++round) {
+        bool roundChanged = false;
+        for (const auto &pass : passes_) {
+            if (!disabled_.count(std::string(pass->name()))) {
+                roundChanged |= pass->run(graph);
+            }
+        }
+        if (!roundChanged) {
+            break;
+        }
+        changed = true;
+    }
+    return graph.removeUnusedTensors() > 0 || changed;
+}
+
+void addDefaultGraphPasses(PassManager &pm) {
+    pm.addPass(createFoldBatchNormPass());
+    pm.addPass(createIdentityEliminationPass());
+    pm.addPass(createConstantFoldingPass());
+    pm.addPass(createCSEPass());
+    pm.addPass(createDeadCodeEliminationPass());
+}
+
+} // namespace tensor_compiler
@@ -0,0 +1,261 @@
+#include "Transforms/Schedule.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace tensor_compiler {
+
+namespace {
+
+std::size_t elementSize(int type) {
+    switch (type) {
+    case onnx::TensorProto_DataType_BOOL:
+    case onnx::TensorProto_DataType_INT8:
+    case onnx::TensorProto_DataType_UINT8:
+        return 1;
+    case onnx::TensorProto_DataType_FLOAT16:
+    case onnx::TensorProto_DataType_BFLOAT16:
+    case onnx::TensorProto_DataType_INT16:
+    case onnx::TensorProto_DataType_UINT16:
+        return 2;
+    case onnx::TensorProto_DataType_FLOAT:
+    case onnx::TensorProto_DataType_INT32:
+    case onnx::TensorProto_DataType_UINT32:
+        return 4;
+    case onnx::TensorProto_DataType_DOUBLE:
+    case onnx::TensorProto_DataType_INT64:
+    case onnx::TensorProto_DataType_UINT64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+std::size_t tensorBytes(const Tensor *tensor) {
+    if (!tensor) {
+        return 0;
+    }
+    std::size_t bytes = elementSize(tensor->type());
+    for (int64_t d : tensor->shape()) {
+        if (d < 0) {
+            return 0;
+        }
+        bytes *= static_cast<std::size_t>(d);
+    }
+    return bytes;
+}
+
+std::vector<TensorId> distinct(const std::vector<TensorId> &ids) {
+    std::vector<TensorId> out;
+    for (TensorId id : ids) {
+        if (id != kNoTensor &&
+            std::find(out.begin(), out.end(), id) == out.end()) {
+            out.push_back(id);
+        }
+    }
+    return out;
+}
+
+// Live activation bookkeeping shared by the scheduler and
+// peakActivationBytes. Only tensors produced by a node and not returned
+// from the graph are tracked; the tables are indexed by TensorId.
+class LiveSet {
+private:
+    std::vector<bool> tracked_;
+    std::vector<std::size_t> bytes_;
+    std::vector<std::size_t> uses_;
+    std::size_t live_ = 0;
+    std::size_t peak_ = 0;
+
+    bool isTracked(TensorId id) const {
+        return id < tracked_.size() && tracked_[id];
+    }
+
+public:
+    explicit LiveSet(const Graph &graph)
+        : tracked_(graph.tensorIdCount(), false),
+          bytes_(graph.tensorIdCount(), 0),
+          uses_(graph.tensorIdCount(), 0) {
+        for (const Node &node : graph.nodes()) {
+            for (TensorId id : distinct(node.outputIds())) {
+                tracked_[id] = true;
+                bytes_[id] = tensorBytes(graph.tensor(id));
+                uses_[id] = graph.consumers(id).size();
+            }
+        }
+        for (TensorId id : graph.outputIds()) {
+            if (id != kNoTensor) {
+                tracked_[id] = false;
+            }
+        }
+    }
+
+    // Growth of the live set after running node.
+    int64_t delta(const Node &node) const {
+        int64_t delta = 0;
+        for (TensorId id : distinct(node.outputIds())) {
+            if (isTracked(id)) {
+                delta += static_cast<int64_t>(bytes_[id]);
+            }
+        }
+        for (TensorId id : distinct(node.inputIds())) {
+            if (isTracked(id) && uses_[id] == 1) {
+                delta -= static_cast<int64_t>(bytes_[id]);
+            }
+        }
+        return delta;
+    }
+
+    // Outputs are allocated while the inputs are still live.
+    void run(const Node &node) {
+        const std::vector<TensorId> outputs = distinct(node.outputIds());
+        for (TensorId id : outputs) {
+            if (isTracked(id)) {
+                live_ += bytes_[id];
+            }
+        }
+        peak_ = std::max(peak_, live_);
+
+        for (TensorId id : distinct(node.inputIds())) {
+            if (isTracked(id) && uses_[id] > 0 && --uses_[id] == 0) {
+                live_ -= bytes_[id];
+            }
+        }
+        for (TensorId id : outputs) {
+            if (isTracked(id) && uses_[id] == 0) {
+                live_ -= bytes_[id];
+            }
+        }
+    }
+
+    std::size_t peak() const { return peak_; }
+};
+
+// Kahn's algorithm picking the ready node with the lowest file index, or
+// with byMemory the one with the lowest live set growth and then the lowest
+// index. The ready list is a min-heap by index in the first case.
+std::vector<std::size_t> schedule(const Graph &graph, bool byMemory) {
+    const std::vector<Node> &nodes = graph.nodes();
+
+    std::vector<std::vector<std::size_t>> users(nodes.size());
+    std::vector<std::size_t> pending(nodes.size(), 0);
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        for (TensorId output : distinct(nodes[i].outputIds())) {
+            if (graph.producer(output) != i) {
+                continue;
+            }
+            const auto &readers = graph.consumers(output);
+            users[i].insert(users[i].end(), readers.begin(), readers.end());
+        }
+        for (TensorId input : distinct(nodes[i].inputIds())) {
+            if (graph.producer(input)) {
+                ++pending[i];
+            }
+        }
+    }
+
+    const std::greater<std::size_t> laterIndex;
+    std::vector<std::size_t> ready;
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        if (pending[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+    if (!byMemory) {
+        std::make_heap(ready.begin(), ready.end(), laterIndex);
+    }
+
+    LiveSet live(graph);
+    std::vector<std::size_t> order;
+    order.reserve(nodes.size());
+    while (!ready.empty()) {
+        if (byMemory) {
+            auto best = ready.begin();
+            int64_t bestDelta = live.delta(nodes[*best]);
+            for (auto it = std::next(ready.begin()); it != ready.end(); ++it) {
+                int64_t delta = live.delta(nodes[*it]);
+                if (delta < bestDelta || (delta == bestDelta && *it < *best)) {
+                    best = it;
+                    bestDelta = delta;
+                }
+            }
+            std::iter_swap(best, std::prev(ready.end()));
+        } else {
+            std::pop_heap(ready.begin(), ready.end(), laterIndex);
+        }
+
+        const std::size_t next = ready.back();
+        ready.pop_back();
+        order.push_back(next);
+        live.run(nodes[next]);
+        for (std::size_t user : users[next]) {
+            if (--pending[user] == 0) {
+                ready.push_back(user);
+                if (!byMemory) {
+                    std::push_heap(ready.begin(), ready.end(), laterIndex);
+                }
+            }
+        }
+    }
+
+    if (order.size() != nodes.size()) {
+        throw std::runtime_error("graph '" + graph.name() +
+                                 "' contains a cycle");
+    }
+    return order;
+}
+
+std::size_t peakBytes(const Graph &graph,
+                      const std::vector<std::size_t> &order) {
+    LiveSet live(graph);
+    for (std::size_t i : order) {
+        live.run(graph.nodes()[i]);
+    }
+    return live.peak();
+}
+
+void reorder(Graph &graph, const std::vector<std::size_t> &order) {
+    std::vector<Node> sorted;
+    sorted.reserve(order.size());
+    for (std::size_t i : order) {
+        sorted.push_back(graph.nodes()[i]);
+    }
+    graph.setNodes(std::move(sorted));
+}
+
+} // namespace
+
+void sortTopologically(Graph &graph) {
+    reorder(graph, schedule(graph, /*byMemory=*/false));
+}
+
+std::size_t scheduleForMemory(Graph &graph) {
+    // The greedy choice only looks one node ahead and can lose to the file
+    // order, e.g. by starting a small tensor that stays live across a spike.
+    const std::vector<std::size_t> sorted =
+        schedule(graph, /*byMemory=*/false);
+    const std::vector<std::size_t> greedy = schedule(graph, /*byMemory=*/true);
+    const std::size_t sortedPeak = peakBytes(graph, sorted);
+    const std::size_t greedyPeak = peakBytes(graph, greedy);
+    if (greedyPeak < sortedPeak) {
+        reorder(graph, greedy);
+        return greedyPeak;
+    }
+    reorder(graph, sorted);
+    return sortedPeak;
+}
+
+std::size_t peakActivationBytes(const Graph &graph) {
+    LiveSet live(graph);
+    for (const Node &node : graph.nodes()) {
+        live.run(node);
+    }
+    return live.peak();
+}
+
+} // namespace tensor_compiler
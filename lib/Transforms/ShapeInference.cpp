@@ -0,0 +1,627 @@
+#include "Transforms/ShapeInference.h"
+#include "Structure/OpRegistry.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tensor_compiler {
+
+namespace {
+
+using Shape = std::vector<int64_t>;
+
+bool isDynamic(int64_t dim) { return dim == kDynamicDim; }
+
+template <typename T>
+T getAttributeOr(const Node &node, const std::string &name, T defaultValue) {
+    auto it = node.attributes().find(name);
+    if (it == node.attributes().end()) {
+        return defaultValue;
+    }
+    const T *value = std::get_if<T>(&it->second.value());
+    return value ? *value : defaultValue;
+}
+
+std::optional<TypeAndShape> known(const Graph &graph, const Node &node,
+                                  size_t input) {
+    if (input >= node.inputs().size() || node.inputs()[input].empty()) {
+        return std::nullopt;
+    }
+    const Tensor *tensor = graph.tensor(node.inputs()[input]);
+    if (!tensor || tensor->type() == onnx::TensorProto_DataType_UNDEFINED) {
+        return std::nullopt;
+    }
+    return TypeAndShape{tensor->type(), tensor->shape()};
+}
+
+std::optional<std::vector<int64_t>> readConstantI64(const Graph &graph,
+                                                    const std::string &name) {
+    const Tensor *tensor = graph.tensor(name);
+    if (!tensor || !tensor->isConstant() ||
+        tensor->type() != onnx::TensorProto_DataType_INT64 ||
+        tensor->data().size() % sizeof(int64_t) != 0) {
+        return std::nullopt;
+    }
+    std::vector<int64_t> values(tensor->data().size() / sizeof(int64_t));
+    std::memcpy(values.data(), tensor->data().data(), tensor->data().size());
+    return values;
+}
+
+int64_t normalizeAxis(int64_t axis, int64_t rank, const std::string &op) {
+    if (axis < 0) {
+        axis += rank;
+    }
+    if (axis < 0 || axis >= rank) {
+        throw std::runtime_error(op + " axis is out of range");
+    }
+    return axis;
+}
+
+// The axes of Squeeze/Unsqueeze/ReduceMean: an attribute before opset 13/18, an
+// optional constant input since.
+std::optional<std::vector<int64_t>> readAxes(const Graph &graph,
+                                             const Node &node) {
+    auto it = node.attributes().find("axes");
+    if (it != node.attributes().end()) {
+        if (const auto *axes =
+                std::get_if<std::vector<int64_t>>(&it->second.value())) {
+            return *axes;
+        }
+    }
+    if (node.inputs().size() > 1 && !node.inputs()[1].empty()) {
+        return readConstantI64(graph, node.inputs()[1]);
+    }
+    return std::vector<int64_t>{};
+}
+
+int64_t broadcastDim(int64_t a, int64_t b, const std::string &op) {
+    if (a == b || b == 1) {
+        return a;
+    }
+    if (a == 1) {
+        return b;
+    }
+    if (isDynamic(a)) {
+        return b;
+    }
+    if (isDynamic(b)) {
+        return a;
+    }
+    throw std::runtime_error(op + " inputs cannot be broadcast: " +
+                             std::to_string(a) + " vs " + std::to_string(b));
+}
+
+Shape broadcastShapes(const Shape &lhs, const Shape &rhs,
+                      const std::string &op) {
+    Shape result(std::max(lhs.size(), rhs.size()), 1);
+    for (size_t i = 0; i < result.size(); ++i) {
+        int64_t a = i < lhs.size() ? lhs[lhs.size() - 1 - i] : 1;
+        int64_t b = i < rhs.size() ? rhs[rhs.size() - 1 - i] : 1;
+        result[result.size() - 1 - i] = broadcastDim(a, b, op);
+    }
+    return result;
+}
+
+// Output size of one spatial dimension of Conv/MaxPool. padBegin/padEnd are
+// ignored for SAME_* auto_pad.
+int64_t windowOutput(int64_t input, int64_t kernel, int64_t stride,
+                     int64_t dilation, int64_t padBegin, int64_t padEnd,
+                     const std::string &autoPad, bool ceilMode,
+                     const std::string &op) {
+    if (isDynamic(input) || isDynamic(kernel)) {
+        return kDynamicDim;
+    }
+    if (stride <= 0 || dilation <= 0) {
+        throw std::runtime_error(op + " strides and dilations must be positive");
+    }
+    if (autoPad == "SAME_UPPER" || autoPad == "SAME_LOWER") {
+        return (input + stride - 1) / stride;
+    }
+    if (autoPad == "VALID") {
+        padBegin = padEnd = 0;
+    } else if (autoPad != "NOTSET") {
+        throw std::runtime_error(op + " auto_pad is not supported: " + autoPad);
+    }
+
+    int64_t effectiveKernel = dilation * (kernel - 1) + 1;
+    int64_t span = input + padBegin + padEnd - effectiveKernel;
+    if (span < 0) {
+        throw std::runtime_error(op + " window is larger than its input");
+    }
+    return (ceilMode ? (span + stride - 1) / stride : span / stride) + 1;
+}
+
+std::optional<TypeAndShape> inferWindowed(const Graph &graph, const Node &node,
+                                          bool isConv) {
+    const std::string &op = node.opcode();
+    auto x = known(graph, node, 0);
+    if (!x || x->shape.size() < 3) {
+        return std::nullopt;
+    }
+    const size_t spatial = x->shape.size() - 2;
+
+    Shape kernel;
+    int64_t channels = x->shape[1];
+    if (isConv) {
+        auto w = known(graph, node, 1);
+        if (!w || w->shape.size() != x->shape.size()) {
+            return std::nullopt;
+        }
+        channels = w->shape[0];
+        kernel.assign(w->shape.begin() + 2, w->shape.end());
+    }
+    kernel = getAttributeOr(node, "kernel_shape", kernel);
+    if (kernel.size() != spatial) {
+        throw std::runtime_error(op + " kernel_shape has unexpected rank");
+    }
+
+    auto strides = getAttributeOr(node, "strides", Shape(spatial, 1));
+    auto dilations = getAttributeOr(node, "dilations", Shape(spatial, 1));
+    auto pads = getAttributeOr(node, "pads", Shape(2 * spatial, 0));
+    if (strides.size() != spatial || dilations.size() != spatial ||
+        pads.size() != 2 * spatial) {
+        throw std::runtime_error(op + " attributes have unexpected rank");
+    }
+    const std::string autoPad =
+        getAttributeOr<std::string>(node, "auto_pad", "NOTSET");
+    const bool ceilMode = getAttributeOr<int64_t>(node, "ceil_mode", 0) != 0;
+
+    Shape shape = {x->shape[0], channels};
+    for (size_t i = 0; i < spatial; ++i) {
+        shape.push_back(windowOutput(x->shape[2 + i], kernel[i], strides[i],
+                                     dilations[i], pads[i], pads[spatial + i],
+                                     autoPad, ceilMode, op));
+    }
+    return TypeAndShape{x->type, shape};
+}
+
+std::optional<TypeAndShape> inferReshape(const Graph &graph,
+                                         const Node &node) {
+    auto x = known(graph, node, 0);
+    auto target = node.inputs().size() == 2
+                      ? readConstantI64(graph, node.inputs()[1])
+                      : std::nullopt;
+    if (!x || !target) {
+        return std::nullopt;
+    }
+
+    const bool allowZero = getAttributeOr<int64_t>(node, "allowzero", 0) != 0;
+    Shape shape(target->size());
+    // Dimensions copied with 0 appear on both sides and cancel out, so a
+    // dynamic batch copied through [0, -1] still leaves -1 static.
+    std::vector<bool> copied(x->shape.size(), false);
+    std::optional<size_t> inferred;
+    int64_t product = 1;
+    for (size_t i = 0; i < shape.size(); ++i) {
+        int64_t dim = (*target)[i];
+        if (dim == 0 && !allowZero) {
+            if (i >= x->shape.size()) {
+                throw std::runtime_error("Reshape copies a missing dimension");
+            }
+            shape[i] = x->shape[i];
+            copied[i] = true;
+            continue;
+        }
+        if (dim == -1) {
+            if (inferred) {
+                throw std::runtime_error("Reshape has more than one -1");
+            }
+            inferred = i;
+            continue;
+        }
+        if (dim < 0) {
+            throw std::runtime_error("Reshape has a negative dimension");
+        }
+        shape[i] = dim;
+        product *= dim;
+    }
+
+    int64_t total = 1;
+    for (size_t i = 0; i < x->shape.size(); ++i) {
+        if (!copied[i]) {
+            int64_t dim = x->shape[i];
+            total = isDynamic(dim) || isDynamic(total) ? kDynamicDim
+                                                       : total * dim;
+        }
+    }
+
+    if (inferred) {
+        if (isDynamic(total)) {
+            shape[*inferred] = kDynamicDim;
+        } else if (product == 0 || total % product != 0) {
+            throw std::runtime_error("Reshape cannot infer the -1 dimension");
+        } else {
+            shape[*inferred] = total / product;
+        }
+    } else if (!isDynamic(total) && total != product) {
+        throw std::runtime_error("Reshape changes the element count");
+    }
+    return TypeAndShape{x->type, shape};
+}
+
+std::optional<TypeAndShape> inferSqueeze(const Graph &graph,
+                                         const Node &node) {
+    auto x = known(graph, node, 0);
+    auto axes = readAxes(graph, node);
+    if (!x || !axes) {
+        return std::nullopt;
+    }
+
+    const int64_t rank = static_cast<int64_t>(x->shape.size());
+    std::vector<bool> squeezed(x->shape.size(), false);
+    if (axes->empty()) {
+        for (size_t i = 0; i < x->shape.size(); ++i) {
+            if (isDynamic(x->shape[i])) {
+                return std::nullopt;
+            }
+            squeezed[i] = x->shape[i] == 1;
+        }
+    }
+    for (int64_t axis : *axes) {
+        axis = normalizeAxis(axis, rank, "Squeeze");
+        int64_t dim = x->shape[static_cast<size_t>(axis)];
+        if (!isDynamic(dim) && dim != 1) {
+            throw std::runtime_error(
+                "Squeeze can only remove dimensions of size 1");
+        }
+        squeezed[static_cast<size_t>(axis)] = true;
+    }
+
+    Shape shape;
+    for (size_t i = 0; i < x->shape.size(); ++i) {
+        if (!squeezed[i]) {
+            shape.push_back(x->shape[i]);
+        }
+    }
+    return TypeAndShape{x->type, shape};
+}
+
+std::optional<TypeAndShape> inferReduceMean(const Graph &graph,
+                                            const Node &node) {
+    auto x = known(graph, node, 0);
+    auto axes = readAxes(graph, node);
+    if (!x || !axes) {
+        return std::nullopt;
+    }
+
+    const int64_t rank = static_cast<int64_t>(x->shape.size());
+    const bool keepDims = getAttributeOr<int64_t>(node, "keepdims", 1) != 0;
+    std::vector<bool> reduced(x->shape.size(), axes->empty());
+    if (axes->empty() &&
+        getAttributeOr<int64_t>(node, "noop_with_empty_axes", 0) != 0) {
+        return x;
+    }
+    for (int64_t axis : *axes) {
+        reduced[static_cast<size_t>(normalizeAxis(axis, rank, "ReduceMean"))] =
+            true;
+    }
+
+    Shape shape;
+    for (size_t i = 0; i < x->shape.size(); ++i) {
+        if (!reduced[i]) {
+            shape.push_back(x->shape[i]);
+        } else if (keepDims) {
+            shape.push_back(1);
+        }
+    }
+    return TypeAndShape{x->type, shape};
+}
+
+std::optional<TypeAndShape> inferMatMul(const Graph &graph, const Node &node) {
+    auto a = known(graph, node, 0);
+    auto b = known(graph, node, 1);
+    if (!a || !b || a->shape.empty() || b->shape.empty()) {
+        return std::nullopt;
+    }
+
+    // Rank-1 operands are promoted to a row/column and the unit dimension
+    // is dropped from the result again.
+    Shape lhs = a->shape;
+    Shape rhs = b->shape;
+    const bool lhsVector = lhs.size() == 1;
+    const bool rhsVector = rhs.size() == 1;
+    if (lhsVector) {
+        lhs.insert(lhs.begin(), 1);
+    }
+    if (rhsVector) {
+        rhs.push_back(1);
+    }
+
+    int64_t k = lhs.back();
+    int64_t rhsK = rhs[rhs.size() - 2];
+    if (!isDynamic(k) && !isDynamic(rhsK) && k != rhsK) {
+        throw std::runtime_error("MatMul inner dimensions do not match");
+    }
+
+    Shape shape = broadcastShapes(Shape(lhs.begin(), lhs.end() - 2),
+                                  Shape(rhs.begin(), rhs.end() - 2), "MatMul");
+    if (!lhsVector) {
+        shape.push_back(lhs[lhs.size() - 2]);
+    }
+    if (!rhsVector) {
+        shape.push_back(rhs.back());
+    }
+    return TypeAndShape{a->type, shape};
+}
+
+std::optional<TypeAndShape> inferArgMax(const Graph &graph, const Node &node) {
+    auto x = known(graph, node, 0);
+    if (!x) {
+        return std::nullopt;
+    }
+
+    const int64_t rank = static_cast<int64_t>(x->shape.size());
+    const size_t axis = static_cast<size_t>(normalizeAxis(
+        getAttributeOr<int64_t>(node, "axis", 0), rank, "ArgMax"));
+    Shape shape = x->shape;
+    if (getAttributeOr<int64_t>(node, "keepdims", 1) != 0) {
+        shape[axis] = 1;
+    } else {
+        shape.erase(shape.begin() + static_cast<std::ptrdiff_t>(axis));
+    }
+    return TypeAndShape{onnx::TensorProto_DataType_INT64, shape};
+}
+
+// Shape with the optional start/end slice of opset 15.
+std::optional<TypeAndShape> inferShape(const Graph &graph, const Node &node) {
+    auto x = known(graph, node, 0);
+    if (!x) {
+        return std::nullopt;
+    }
+    const int64_t rank = static_cast<int64_t>(x->shape.size());
+    auto clamp = [rank](int64_t i) {
+        return std::clamp<int64_t>(i < 0 ? i + rank : i, 0, rank);
+    };
+    const int64_t start = clamp(getAttributeOr<int64_t>(node, "start", 0));
+    const int64_t end = clamp(getAttributeOr<int64_t>(node, "end", rank));
+    return TypeAndShape{onnx::TensorProto_DataType_INT64,
+                        {std::max<int64_t>(end - start, 0)}};
+}
+
+std::optional<TypeAndShape> inferGather(const Graph &graph, const Node &node) {
+    auto data = known(graph, node, 0);
+    auto indices = known(graph, node, 1);
+    if (!data || !indices) {
+        return std::nullopt;
+    }
+    const int64_t rank = static_cast<int64_t>(data->shape.size());
+    const auto axis = static_cast<std::ptrdiff_t>(normalizeAxis(
+        getAttributeOr<int64_t>(node, "axis", 0), rank, "Gather"));
+
+    Shape shape(data->shape.begin(), data->shape.begin() + axis);
+    shape.insert(shape.end(), indices->shape.begin(), indices->shape.end());
+    shape.insert(shape.end(), data->shape.begin() + axis + 1,
+                 data->shape.end());
+    return TypeAndShape{data->type, shape};
+}
+
+std::optional<TypeAndShape> inferConcat(const Graph &graph, const Node &node) {
+    auto first = known(graph, node, 0);
+    if (!first) {
+        return std::nullopt;
+    }
+    const int64_t rank = static_cast<int64_t>(first->shape.size());
+    const size_t axis = static_cast<size_t>(normalizeAxis(
+        getAttributeOr<int64_t>(node, "axis", 0), rank, "Concat"));
+
+    Shape shape = first->shape;
+    for (size_t i = 1; i < node.inputs().size(); ++i) {
+        auto x = known(graph, node, i);
+        if (!x) {
+            return std::nullopt;
+        }
+        if (x->type != first->type || x->shape.size() != shape.size()) {
+            throw std::runtime_error("Concat inputs differ in type or rank");
+        }
+        for (size_t d = 0; d < shape.size(); ++d) {
+            if (d == axis) {
+                shape[d] = isDynamic(shape[d]) || isDynamic(x->shape[d])
+                               ? kDynamicDim
+                               : shape[d] + x->shape[d];
+            } else if (isDynamic(shape[d])) {
+                shape[d] = x->shape[d];
+            } else if (!isDynamic(x->shape[d]) && shape[d] != x->shape[d]) {
+                throw std::runtime_error(
+                    "Concat inputs differ outside the concat axis");
+            }
+        }
+    }
+    return TypeAndShape{first->type, shape};
+}
+
+std::optional<TypeAndShape> inferUnsqueeze(const Graph &graph,
+                                           const Node &node) {
+    auto x = known(graph, node, 0);
+    auto axes = readAxes(graph, node);
+    if (!x || !axes) {
+        return std::nullopt;
+    }
+
+    const int64_t rank = static_cast<int64_t>(x->shape.size() + axes->size());
+    std::vector<bool> inserted(static_cast<size_t>(rank), false);
+    for (int64_t axis : *axes) {
+        size_t i = static_cast<size_t>(normalizeAxis(axis, rank, "Unsqueeze"));
+        if (inserted[i]) {
+            throw std::runtime_error("Unsqueeze axes contain duplicates");
+        }
+        inserted[i] = true;
+    }
+
+    Shape shape;
+    auto next = x->shape.begin();
+    for (bool unit : inserted) {
+        shape.push_back(unit ? 1 : *next++);
+    }
+    return TypeAndShape{x->type, shape};
+}
+
+std::optional<TypeAndShape> inferTranspose(const Graph &graph,
+                                           const Node &node) {
+    auto x = known(graph, node, 0);
+    if (!x) {
+        return std::nullopt;
+    }
+
+    // Without perm the dimensions are reversed.
+    const size_t rank = x->shape.size();
+    std::vector<int64_t> perm;
+    for (size_t i = rank; i-- > 0;) {
+        perm.push_back(static_cast<int64_t>(i));
+    }
+    perm = getAttributeOr<std::vector<int64_t>>(node, "perm", perm);
+    if (perm.size() != rank) {
+        throw std::runtime_error("Transpose perm does not match the rank");
+    }
+
+    Shape shape;
+    for (int64_t axis : perm) {
+        shape.push_back(x->shape[static_cast<size_t>(
+            normalizeAxis(axis, static_cast<int64_t>(rank), "Transpose"))]);
+    }
+    return TypeAndShape{x->type, shape};
+}
+
+std::optional<TypeAndShape> inferElementwise(const Graph &graph,
+                                             const Node &node) {
+    auto lhs = known(graph, node, 0);
+    auto rhs = known(graph, node, 1);
+    if (!lhs || !rhs) {
+        return std::nullopt;
+    }
+    if (lhs->type != rhs->type) {
+        throw std::runtime_error(node.opcode() + " input element types differ");
+    }
+    return TypeAndShape{lhs->type,
+                        broadcastShapes(lhs->shape, rhs->shape, node.opcode())};
+}
+
+std::optional<TypeAndShape> inferSameAsInput(const Graph &graph,
+                                             const Node &node) {
+    return known(graph, node, 0);
+}
+
+// Gives the built-in ops their rule unless one was registered already.
+void registerBuiltinRules() {
+    using Rule = std::optional<TypeAndShape> (*)(const Graph &, const Node &);
+    const std::pair<const char *, Rule> rules[] = {
+        {"Add", inferElementwise},
+        {"Sub", inferElementwise},
+        {"Mul", inferElementwise},
+        {"Div", inferElementwise},
+        {"Identity", inferSameAsInput},
+        {"Relu", inferSameAsInput},
+        {"Softmax", inferSameAsInput},
+        {"BatchNormalization", inferSameAsInput},
+        {"Conv",
+         [](const Graph &graph, const Node &node) {
+             return inferWindowed(graph, node, /*isConv=*/true);
+         }},
+        {"MaxPool",
+         [](const Graph &graph, const Node &node) {
+             return inferWindowed(graph, node, /*isConv=*/false);
+         }},
+        {"ReduceMean", inferReduceMean},
+        {"Reshape", inferReshape},
+        {"Squeeze", inferSqueeze},
+        {"MatMul", inferMatMul},
+        {"ArgMax", inferArgMax},
+        {"Shape", inferShape},
+        {"Gather", inferGather},
+        {"Concat", inferConcat},
+        {"Unsqueeze", inferUnsqueeze},
+        {"Transpose", inferTranspose},
+    };
+
+    OpRegistry &registry = OpRegistry::instance();
+    for (const auto &[opcode, rule] : rules) {
+        OpInfo info = registry.info(registry.intern(opcode));
+        if (!info.inferShape) {
+            info.inferShape = rule;
+            registry.registerOp(opcode, std::move(info));
+        }
+    }
+}
+
+// Merges the inferred type and shape into a tensor that may already carry a
+// declared one (graph outputs). Returns whether anything changed.
+bool refine(Tensor &tensor, const TypeAndShape &inferred) {
+    if (tensor.type() == onnx::TensorProto_DataType_UNDEFINED) {
+        tensor.setType(inferred.type);
+        tensor.setShape(inferred.shape);
+        return true;
+    }
+    if (tensor.type() != inferred.type) {
+        throw std::runtime_error("inferred element type of '" + tensor.name() +
+                                 "' contradicts its declaration");
+    }
+
+    // A declaration without dims cannot be told apart from a scalar.
+    const Shape &declared = tensor.shape();
+    if (declared.empty()) {
+        if (inferred.shape.empty()) {
+            return false;
+        }
+        tensor.setShape(inferred.shape);
+        return true;
+    }
+    if (declared.size() != inferred.shape.size()) {
+        throw std::runtime_error("inferred rank of '" + tensor.name() +
+                                 "' contradicts its declaration");
+    }
+
+    Shape shape = declared;
+    for (size_t i = 0; i < shape.size(); ++i) {
+        if (isDynamic(shape[i])) {
+            shape[i] = inferred.shape[i];
+        } else if (!isDynamic(inferred.shape[i]) &&
+                   shape[i] != inferred.shape[i]) {
+            throw std::runtime_error("inferred shape of '" + tensor.name() +
+                                     "' contradicts its declaration");
+        }
+    }
+    if (shape == declared) {
+        return false;
+    }
+    tensor.setShape(shape);
+    return true;
+}
+
+} // namespace
+
+std::size_t inferShapes(Graph &graph) {
+    static const bool registered = (registerBuiltinRules(), true);
+    (void)registered;
+
+    OpRegistry &registry = OpRegistry::instance();
+    std::size_t changed = 0;
+    for (const Node &node : graph.nodes()) {
+        // Multi-output ops (MaxPool indices, BatchNormalization training
+        // statistics) are not supported by Codegen; only output 0 is typed.
+        if (node.outputs().empty() || node.outputs()[0].empty()) {
+            continue;
+        }
+        const OpInfo &info = registry.info(node.opId());
+        if (!info.inferShape) {
+            continue;
+        }
+        auto inferred = info.inferShape(graph, node);
+        const Tensor *current = graph.tensor(node.outputs()[0]);
+        if (!inferred || !current) {
+            continue;
+        }
+
+        Tensor tensor = *current;
+        if (refine(tensor, *inferred)) {
+            graph.addTensor(std::move(tensor));
+            ++changed;
+        }
+    }
+    return changed;
+}
+
+} // namespace tensor_compiler
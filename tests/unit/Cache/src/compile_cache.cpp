@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+
+#include "Cache/CompileCache.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace tensor_compiler;
+
+namespace {
+
+std::string keyOf(llvm::StringRef first, llvm::StringRef second) {
+    return CacheKey().add(first).add(second).finish();
+}
+
+void writeFile(const std::string &path, llvm::StringRef contents) {
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec);
+    ASSERT_FALSE(ec) << ec.message();
+    os << contents;
+}
+
+std::string readFile(const std::string &path) {
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    return buffer ? (*buffer)->getBuffer().str() : std::string();
+}
+
+// A fresh directory; the cache lives in a subdirectory not created yet.
+class CompileCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("tc_cache", dir_));
+        cacheDir_ = dir_;
+        llvm::sys::path::append(cacheDir_, "cache");
+    }
+
+    void TearDown() override { llvm::sys::fs::remove_directories(dir_); }
+
+    llvm::SmallString<128> dir_;
+    llvm::SmallString<128> cacheDir_;
+};
+
+} // namespace
+
+TEST(CacheKey, PrefixesFieldsWithTheirLength) {
+    EXPECT_NE(keyOf("ab", "c"), keyOf("a", "bc"));
+    EXPECT_NE(keyOf("", "abc"), keyOf("abc", ""));
+    EXPECT_EQ(keyOf("ab", "c"), keyOf("ab", "c"));
+
+    // Hex SHA-256.
+    std::string key = keyOf("ab", "c");
+    EXPECT_EQ(key.size(), 64u);
+    EXPECT_EQ(key.find_first_not_of("0123456789abcdef"), std::string::npos);
+}
+
+TEST(CacheKey, DistinguishesIntegers) {
+    EXPECT_NE(CacheKey().add(int64_t{1}).finish(),
+              CacheKey().add(int64_t{2}).finish());
+    EXPECT_NE(CacheKey().add(int64_t{1}).add(int64_t{0}).finish(),
+              CacheKey().add(int64_t{1}).finish());
+}
+
+TEST_F(CompileCacheTest, MissesThenHitsAfterInsert) {
+    const CompileCache cache{std::string(cacheDir_)};
+    const std::string key = keyOf("model", "O2");
+    EXPECT_EQ(cache.lookup(key), std::nullopt);
+
+    const std::string temporary = cache.createTemporary();
+    ASSERT_FALSE(temporary.empty());
+    EXPECT_EQ(llvm::sys::path::parent_path(temporary), cacheDir_.str());
+    EXPECT_TRUE(llvm::sys::fs::exists(temporary));
+    writeFile(temporary, "object");
+
+    ASSERT_TRUE(cache.insert(key, temporary));
+    EXPECT_FALSE(llvm::sys::fs::exists(temporary));
+
+    std::optional<std::string> entry = cache.lookup(key);
+    ASSERT_TRUE(entry.has_value());
+    EXPECT_EQ(readFile(*entry), "object");
+    EXPECT_EQ(cache.lookup(keyOf("model", "O3")), std::nullopt);
+}
+
+TEST_F(CompileCacheTest, CreatesDistinctTemporaries) {
+    const CompileCache cache{std::string(cacheDir_)};
+    const std::string first = cache.createTemporary();
+    const std::string second = cache.createTemporary();
+    ASSERT_FALSE(first.empty());
+    ASSERT_FALSE(second.empty());
+    EXPECT_NE(first, second);
+}
+
+TEST_F(CompileCacheTest, ReplacesExistingEntry) {
+    const CompileCache cache{std::string(cacheDir_)};
+    const std::string key = keyOf("model", "O2");
+
+    for (const char *contents : {"first", "second"}) {
+        const std::string temporary = cache.createTemporary();
+        ASSERT_FALSE(temporary.empty());
+        writeFile(temporary, contents);
+        ASSERT_TRUE(cache.insert(key, temporary));
+    }
+    EXPECT_EQ(readFile(cache.lookup(key).value_or("")), "second");
+}
+
+// A failed insert leaves the temporary file for the caller.
+TEST_F(CompileCacheTest, KeepsTemporaryWhenInsertFails) {
+    const CompileCache cache{std::string(cacheDir_)};
+    const std::string key = keyOf("model", "O2");
+    const std::string temporary = cache.createTemporary();
+    ASSERT_FALSE(temporary.empty());
+    writeFile(temporary, "object");
+
+    // A non-empty directory where the entry belongs cannot be replaced.
+    llvm::SmallString<128> blocker(cacheDir_);
+    llvm::sys::path::append(blocker, key + ".o", "file");
+    ASSERT_FALSE(llvm::sys::fs::create_directories(
+        llvm::sys::path::parent_path(blocker)));
+    writeFile(std::string(blocker), "");
+
+    EXPECT_FALSE(cache.insert(key, temporary));
+    EXPECT_EQ(readFile(temporary), "object");
+    EXPECT_EQ(cache.lookup(key), std::nullopt);
+}
+
+// No temporary when the cache directory cannot be created.
+TEST_F(CompileCacheTest, ReturnsNoTemporaryWithoutDirectory) {
+    writeFile(std::string(cacheDir_), "not a directory");
+    const CompileCache cache{std::string(cacheDir_)};
+    EXPECT_TRUE(cache.createTemporary().empty());
+    EXPECT_EQ(cache.lookup(keyOf("model", "O2")), std::nullopt);
+}
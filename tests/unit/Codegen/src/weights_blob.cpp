@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "Codegen/WeightsBlob.h"
+
+using namespace tensor_compiler;
+
+TEST(WeightsBlob, AppendAlignsEveryEntry) {
+    WeightsBlob blob;
+    EXPECT_TRUE(blob.empty());
+
+    const std::string first = blob.append(std::string(10, '\x01'));
+    const std::string second = blob.append(std::string(100, '\x02'));
+    blob.append(std::string(4, '\x03'));
+
+    ASSERT_EQ(blob.entries().size(), 3u);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(blob.entries()[0].offset, 0u);
+    EXPECT_EQ(blob.entries()[1].offset, kWeightsAlignment);
+    EXPECT_EQ(blob.entries()[2].offset, 3 * kWeightsAlignment);
+    EXPECT_EQ(blob.entries()[1].size, 100u);
+    EXPECT_EQ(blob.size(), 3 * kWeightsAlignment + 4);
+
+    blob.clear();
+    EXPECT_TRUE(blob.empty());
+    EXPECT_EQ(blob.size(), 0u);
+}
+
+TEST(WeightsBlob, WriteStoresBytesAtOffsets) {
+    WeightsBlob blob;
+    blob.append("abc");
+    blob.append("xyz");
+
+    const std::string path = testing::TempDir() + "weights_blob_test.bin";
+    blob.write(path);
+
+    std::ifstream in(path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+    std::remove(path.c_str());
+
+    ASSERT_EQ(contents.size(), blob.size());
+    EXPECT_EQ(contents.substr(0, 3), "abc");
+    EXPECT_EQ(contents.substr(blob.entries()[1].offset, 3), "xyz");
+    EXPECT_EQ(contents[3], '\0');
+}
+
+TEST(WeightsBlob, AsmSectionDefinesSymbols) {
+    WeightsBlob blob;
+    blob.append("abc");
+    const std::string symbol = blob.append("xyz");
+
+    const std::string section = blob.asmSection("/tmp/dir \"q\"/model.weights");
+    EXPECT_NE(section.find(".incbin\t\"/tmp/dir \\\"q\\\"/model.weights\""),
+              std::string::npos);
+    EXPECT_NE(section.find(std::string(kWeightsBaseSymbol) + ":\n"),
+              std::string::npos);
+    EXPECT_NE(section.find(".set\t" + symbol + ", " + kWeightsBaseSymbol +
+                           " + " + std::to_string(kWeightsAlignment)),
+              std::string::npos);
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "Codegen/WeightsBlob.h"
+#include "JIT/JitModel.h"
+#include "Lowering/MLIRToLLVM.h"
+#include "ModelAPI/JitAPI.h"
+
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+using namespace tensor_compiler;
+
+namespace {
+
+// output = input + 1 with the entry points Codegen emits.
+constexpr const char *kAddOneModule = R"mlir(
+func.func @tensorCompWorkspaceSizeImpl() -> i64 {
+  %c0 = arith.constant 0 : i64
+  return %c0 : i64
+}
+
+func.func @tensorCompForwardImpl(%in: memref<4x4xf32>,
+                                 %out: memref<4x4xf32>,
+                                 %workspace: memref<64xi8>) -> i32 {
+  %one = arith.constant 1.0 : f32
+  linalg.generic {indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                                   affine_map<(d0, d1) -> (d0, d1)>],
+                  iterator_types = ["parallel", "parallel"]}
+      ins(%in : memref<4x4xf32>) outs(%out : memref<4x4xf32>) {
+  ^bb0(%a: f32, %b: f32):
+    %sum = arith.addf %a, %one : f32
+    linalg.yield %sum : f32
+  }
+  %ok = arith.constant 0 : i32
+  return %ok : i32
+}
+)mlir";
+
+class JitAPI : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("tc_jit_api", dir_));
+        objectPath_ = dir_;
+        llvm::sys::path::append(objectPath_, "model.o");
+
+        mlir::MLIRContext context;
+        registerCompilerDialects(context);
+        mlir::OwningOpRef<mlir::ModuleOp> module =
+            mlir::parseSourceString<mlir::ModuleOp>(kAddOneModule, &context);
+        ASSERT_TRUE(module);
+        ASSERT_TRUE(mlir::succeeded(MLIRToLLVM(context, module)));
+
+        // Writes the object tcJitLoad reads, as --run does for the cache.
+        auto model = JitModel::create(*module, WeightsBlob{}, /*optLevel=*/2,
+                                      /*cpu=*/"", /*features=*/"",
+                                      std::string(objectPath_));
+        ASSERT_TRUE(!!model) << llvm::toString(model.takeError());
+    }
+
+    void TearDown() override { llvm::sys::fs::remove_directories(dir_); }
+
+    llvm::SmallString<128> dir_;
+    llvm::SmallString<128> objectPath_;
+};
+
+} // namespace
+
+TEST_F(JitAPI, RunsLoadedObject) {
+    TcJitModel *model = tcJitLoad(objectPath_.c_str());
+    ASSERT_NE(model, nullptr);
+
+    std::vector<float> input(16);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<float>(i);
+    }
+    std::vector<float> output(input.size(), 0.0f);
+    const float *inputs[] = {input.data()};
+    float *outputs[] = {output.data()};
+    EXPECT_EQ(tcJitForward(model, inputs, 1, outputs, 1), 0);
+    for (size_t i = 0; i < input.size(); ++i) {
+        EXPECT_EQ(output[i], input[i] + 1.0f) << "at " << i;
+    }
+
+    tcJitFree(model);
+}
+
+TEST_F(JitAPI, RejectsWrongBufferCount) {
+    TcJitModel *model = tcJitLoad(objectPath_.c_str());
+    ASSERT_NE(model, nullptr);
+
+    std::vector<float> input(16, 0.0f);
+    const float *inputs[] = {input.data()};
+    EXPECT_NE(tcJitForward(model, inputs, 1, nullptr, 0), 0);
+    EXPECT_NE(tcJitForward(nullptr, inputs, 1, nullptr, 0), 0);
+
+    tcJitFree(model);
+}
+
+TEST(JitAPILoad, ReturnsNullForMissingObject) {
+    EXPECT_EQ(tcJitLoad("/nonexistent/tc_jit_api/model.o"), nullptr);
+    tcJitFree(nullptr);
+}
@@ -0,0 +1,393 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Codegen/Codegen.h"
+#include "Graph.h"
+#include "JIT/JitModel.h"
+#include "Lowering/MLIRToLLVM.h"
+#include "OnnxBuilders.h"
+
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "llvm/Support/Error.h"
+
+using namespace tensor_compiler;
+using namespace tensor_compiler::test;
+
+namespace {
+
+// One Conv node: x[N, C, H, W] * w[F, C / group, K, K] (+ b[F]) -> y.
+struct ConvCase {
+    int64_t batch = 1;
+    int64_t channels = 4;
+    int64_t height = 8;
+    int64_t width = 8;
+    int64_t filters = 4;
+    int64_t kernel = 3;
+    int64_t group = 1;
+    int64_t stride = 1;
+    int64_t pad = 0;
+    int64_t dilation = 1;
+    bool bias = true;
+
+    int64_t outHeight() const {
+        return (height + 2 * pad - dilation * (kernel - 1) - 1) / stride + 1;
+    }
+    int64_t outWidth() const {
+        return (width + 2 * pad - dilation * (kernel - 1) - 1) / stride + 1;
+    }
+    int64_t inputSize() const { return batch * channels * height * width; }
+    int64_t filterSize() const {
+        return filters * (channels / group) * kernel * kernel;
+    }
+    int64_t outputSize() const {
+        return batch * filters * outHeight() * outWidth();
+    }
+};
+
+// Deterministic values in [-1, 1).
+std::vector<float> pseudoRandom(int64_t count, uint32_t seed) {
+    std::vector<float> values(static_cast<size_t>(count));
+    for (float &value : values) {
+        seed = seed * 1664525u + 1013904223u;
+        value = static_cast<float>(seed >> 8) / static_cast<float>(1u << 23) -
+                1.0f;
+    }
+    return values;
+}
+
+struct ConvData {
+    std::vector<float> input;
+    std::vector<float> filter;
+    std::vector<float> bias;
+};
+
+ConvData makeData(const ConvCase &conv) {
+    return {pseudoRandom(conv.inputSize(), 1),
+            pseudoRandom(conv.filterSize(), 2),
+            conv.bias ? pseudoRandom(conv.filters, 3) : std::vector<float>{}};
+}
+
+// Direct NCHW convolution in double precision.
+std::vector<float> referenceConv(const ConvCase &conv, const ConvData &data) {
+    const int64_t outH = conv.outHeight();
+    const int64_t outW = conv.outWidth();
+    const int64_t groupChannels = conv.channels / conv.group;
+    const int64_t groupFilters = conv.filters / conv.group;
+    std::vector<float> output(static_cast<size_t>(conv.outputSize()));
+
+    for (int64_t n = 0; n < conv.batch; ++n) {
+        for (int64_t f = 0; f < conv.filters; ++f) {
+            const int64_t g = f / groupFilters;
+            for (int64_t oh = 0; oh < outH; ++oh) {
+                for (int64_t ow = 0; ow < outW; ++ow) {
+                    double sum = conv.bias ? data.bias[f] : 0.0;
+                    for (int64_t c = 0; c < groupChannels; ++c) {
+                        const int64_t ic = g * groupChannels + c;
+                        for (int64_t kh = 0; kh < conv.kernel; ++kh) {
+                            for (int64_t kw = 0; kw < conv.kernel; ++kw) {
+                                const int64_t ih = oh * conv.stride +
+                                                   kh * conv.dilation -
+                                                   conv.pad;
+                                const int64_t iw = ow * conv.stride +
+                                                   kw * conv.dilation -
+                                                   conv.pad;
+                                if (ih < 0 || ih >= conv.height || iw < 0 ||
+                                    iw >= conv.width) {
+                                    continue;
+                                }
+                                sum += static_cast<double>(
+                                           data.input[((n * conv.channels +
+                                                        ic) * conv.height +
+                                                       ih) * conv.width + iw]) *
+                                       data.filter[((f * groupChannels + c) *
+                                                        conv.kernel +
+                                                    kh) * conv.kernel + kw];
+                            }
+                        }
+                    }
+                    output[((n * conv.filters + f) * outH + oh) * outW + ow] =
+                        static_cast<float>(sum);
+                }
+            }
+        }
+    }
+    return output;
+}
+
+onnx::GraphProto buildConvGraph(const ConvCase &conv, const ConvData &data) {
+    onnx::GraphProto graph;
+    addValueInfo(graph.mutable_input(), "x",
+                 {conv.batch, conv.channels, conv.height, conv.width});
+    addInitializer(graph, "w",
+                   {conv.filters, conv.channels / conv.group, conv.kernel,
+                    conv.kernel},
+                   data.filter);
+    std::vector<std::string> inputs = {"x", "w"};
+    if (conv.bias) {
+        addInitializer(graph, "b", {conv.filters}, data.bias);
+        inputs.push_back("b");
+    }
+    onnx::NodeProto *node = addNode(graph, "Conv", inputs, {"y"});
+    setInts(node, "kernel_shape", {conv.kernel, conv.kernel});
+    setInts(node, "strides", {conv.stride, conv.stride});
+    setInts(node, "pads", {conv.pad, conv.pad, conv.pad, conv.pad});
+    setInts(node, "dilations", {conv.dilation, conv.dilation});
+    setInt(node, "group", conv.group);
+    addValueInfo(graph.mutable_output(), "y",
+                 {conv.batch, conv.filters, conv.outHeight(),
+                  conv.outWidth()});
+    return graph;
+}
+
+// Compiles the conv with Codegen and the MLIR pipeline, as --run does, and
+// runs it on data.input.
+std::vector<float> runConv(const ConvCase &conv, const ConvData &data,
+                           const CodegenOptions &codegenOptions) {
+    const Graph graph{buildConvGraph(conv, data)};
+
+    mlir::MLIRContext context;
+    registerCompilerDialects(context);
+    Codegen codegen{context, codegenOptions};
+    mlir::OwningOpRef<mlir::ModuleOp> module = codegen.generate(graph);
+    if (!module || mlir::failed(optimizeTensorIR(context, module)) ||
+        mlir::failed(MLIRToLLVM(context, module))) {
+        ADD_FAILURE() << "lowering failed";
+        return {};
+    }
+
+    auto model = JitModel::create(*module, codegen.weights(), /*optLevel=*/2);
+    if (!model) {
+        ADD_FAILURE() << llvm::toString(model.takeError());
+        return {};
+    }
+    std::vector<float> output(static_cast<size_t>(conv.outputSize()), 0.0f);
+    EXPECT_EQ((*model)->forward({data.input.data()}, {output.data()}), 0);
+    return output;
+}
+
+// Largest difference relative to the largest magnitude of expected.
+double relativeError(const std::vector<float> &actual,
+                     const std::vector<float> &expected) {
+    if (actual.size() != expected.size()) {
+        return INFINITY;
+    }
+    double maxDiff = 0.0;
+    double maxMagnitude = 0.0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        maxDiff = std::max(maxDiff, std::fabs(double(actual[i]) - expected[i]));
+        maxMagnitude = std::max(maxMagnitude, std::fabs(double(expected[i])));
+    }
+    return maxDiff / std::max(maxMagnitude, 1e-30);
+}
+
+// Exact up to summation order.
+constexpr double kDirectTolerance = 1e-5;
+
+CodegenOptions withWinograd(Winograd winograd) {
+    CodegenOptions options;
+    options.winograd = winograd;
+    return options;
+}
+
+CodegenOptions withLowering(ConvLowering lowering) {
+    CodegenOptions options;
+    options.convLowering = lowering;
+    return options;
+}
+
+} // namespace
+
+// ---------------------------------- Winograd --------------------------------
+
+// The README's accuracy note: around 1e-5 for --winograd=2 and up to 1e-3
+// for --winograd=4, relative to direct conv. The output sizes (7x9, 5x5)
+// are not multiples of either tile size, so the last tiles are cropped.
+TEST(ConvLowering, WinogradMatchesDirectConvWithinDocumentedError) {
+    ConvCase unpadded;
+    unpadded.batch = 2;
+    unpadded.channels = 8;
+    unpadded.height = 9;
+    unpadded.width = 11;
+    unpadded.filters = 6;
+
+    ConvCase padded;
+    padded.channels = 16;
+    padded.height = 5;
+    padded.width = 5;
+    padded.filters = 8;
+    padded.pad = 1;
+    padded.bias = false;
+
+    for (const ConvCase &conv : {unpadded, padded}) {
+        const ConvData data = makeData(conv);
+        const std::vector<float> direct =
+            runConv(conv, data, withWinograd(Winograd::none));
+        EXPECT_LE(relativeError(direct, referenceConv(conv, data)),
+                  kDirectTolerance);
+
+        EXPECT_LE(relativeError(
+                      runConv(conv, data, withWinograd(Winograd::f2x2)),
+                      direct),
+                  1e-5)
+            << "F(2x2, 3x3), " << conv.height << "x" << conv.width;
+        EXPECT_LE(relativeError(
+                      runConv(conv, data, withWinograd(Winograd::f4x4)),
+                      direct),
+                  1e-3)
+            << "F(4x4, 3x3), " << conv.height << "x" << conv.width;
+    }
+}
+
+// ------------------------------ Grouped conv --------------------------------
+
+// group == C and F == C: the depthwise path, padded, strided and dilated.
+TEST(ConvLowering, DepthwiseMatchesReference) {
+    ConvCase conv;
+    conv.batch = 2;
+    conv.channels = 6;
+    conv.height = 10;
+    conv.width = 9;
+    conv.filters = 6;
+    conv.group = 6;
+    conv.pad = 1;
+
+    for (int64_t stride : {1, 2}) {
+        for (int64_t dilation : {1, 2}) {
+            conv.stride = stride;
+            conv.dilation = dilation;
+            const ConvData data = makeData(conv);
+            EXPECT_LE(relativeError(runConv(conv, data, {}),
+                                    referenceConv(conv, data)),
+                      kDirectTolerance)
+                << "stride " << stride << ", dilation " << dilation;
+        }
+    }
+}
+
+// group == 2: the 5-D grouped path with several channels per group.
+TEST(ConvLowering, GroupedMatchesReference) {
+    ConvCase conv;
+    conv.channels = 8;
+    conv.height = 7;
+    conv.width = 7;
+    conv.filters = 6;
+    conv.group = 2;
+
+    ConvCase strided = conv;
+    strided.batch = 2;
+    strided.stride = 2;
+    strided.pad = 1;
+    strided.bias = false;
+
+    for (const ConvCase &grouped : {conv, strided}) {
+        const ConvData data = makeData(grouped);
+        EXPECT_LE(relativeError(runConv(grouped, data, {}),
+                                referenceConv(grouped, data)),
+                  kDirectTolerance)
+            << "stride " << grouped.stride;
+    }
+}
+
+// group == C with F == 2C: a channel multiplier of 2 is not depthwise and
+// takes the grouped path with one channel per group.
+TEST(ConvLowering, ChannelMultiplierMatchesReference) {
+    ConvCase conv;
+    conv.channels = 4;
+    conv.height = 6;
+    conv.width = 8;
+    conv.filters = 8;
+    conv.group = 4;
+    conv.pad = 1;
+
+    const ConvData data = makeData(conv);
+    EXPECT_LE(
+        relativeError(runConv(conv, data, {}), referenceConv(conv, data)),
+        kDirectTolerance);
+}
+
+// --------------------------------- im2col -----------------------------------
+
+// The patch matrix with padding, strides and dilations, for a static batch
+// of 1 (linalg.matmul) and of 2 (batched contraction).
+TEST(ConvLowering, Im2ColMatchesReference) {
+    ConvCase conv;
+    conv.channels = 3;
+    conv.height = 11;
+    conv.width = 10;
+    conv.filters = 5;
+    conv.stride = 2;
+    conv.pad = 1;
+
+    ConvCase dilated = conv;
+    dilated.batch = 2;
+    dilated.stride = 1;
+    dilated.dilation = 2;
+    dilated.pad = 2;
+    dilated.bias = false;
+
+    for (const ConvCase &c : {conv, dilated}) {
+        const ConvData data = makeData(c);
+        EXPECT_LE(relativeError(
+                      runConv(c, data, withLowering(ConvLowering::im2col)),
+                      referenceConv(c, data)),
+                  kDirectTolerance)
+            << "batch " << c.batch;
+    }
+}
+
+// 1x1 stride-1 convs without padding use the input as the patch matrix.
+TEST(ConvLowering, PointwiseIm2ColMatchesReference) {
+    ConvCase conv;
+    conv.channels = 16;
+    conv.height = 5;
+    conv.width = 7;
+    conv.filters = 12;
+    conv.kernel = 1;
+
+    for (int64_t batch : {1, 2}) {
+        conv.batch = batch;
+        const ConvData data = makeData(conv);
+        EXPECT_LE(relativeError(
+                      runConv(conv, data, withLowering(ConvLowering::im2col)),
+                      referenceConv(conv, data)),
+                  kDirectTolerance)
+            << "batch " << batch;
+    }
+}
+
+// --conv-lowering=auto picks im2col for the deep 3x3 conv and the 1x1 one
+// and direct conv for the shallow one; all must match the reference.
+TEST(ConvLowering, AutomaticMatchesReference) {
+    ConvCase deep;
+    deep.channels = 8;
+    deep.height = 8;
+    deep.width = 8;
+    deep.filters = 4;
+    deep.pad = 1;
+
+    ConvCase shallow = deep;
+    shallow.channels = 2;
+    shallow.stride = 2;
+
+    ConvCase pointwise = deep;
+    pointwise.kernel = 1;
+    pointwise.pad = 0;
+
+    for (const ConvCase &conv : {deep, shallow, pointwise}) {
+        const ConvData data = makeData(conv);
+        EXPECT_LE(
+            relativeError(
+                runConv(conv, data, withLowering(ConvLowering::automatic)),
+                referenceConv(conv, data)),
+            kDirectTolerance)
+            << conv.channels << " channels, " << conv.kernel << "x"
+            << conv.kernel;
+    }
+}
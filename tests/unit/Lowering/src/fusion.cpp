@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "Lowering/MLIRToLLVM.h"
+
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace tensor_compiler;
+
+namespace {
+
+// MatMul followed by a Relu epilogue, as Codegen emits a Gemm + Relu pair.
+constexpr const char *kMatMulReluModule = R"mlir(
+func.func @matmul_relu(%a: tensor<16x32xf32>, %b: tensor<32x16xf32>,
+                       %init: tensor<16x16xf32>) -> tensor<16x16xf32> {
+  %zero = arith.constant 0.0 : f32
+  %fill = linalg.fill ins(%zero : f32) outs(%init : tensor<16x16xf32>)
+            -> tensor<16x16xf32>
+  %mm = linalg.matmul ins(%a, %b : tensor<16x32xf32>, tensor<32x16xf32>)
+          outs(%fill : tensor<16x16xf32>) -> tensor<16x16xf32>
+  %empty = tensor.empty() : tensor<16x16xf32>
+  %relu = linalg.generic {indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                                           affine_map<(d0, d1) -> (d0, d1)>],
+                          iterator_types = ["parallel", "parallel"]}
+      ins(%mm : tensor<16x16xf32>) outs(%empty : tensor<16x16xf32>) {
+  ^bb0(%x: f32, %out: f32):
+    %max = arith.maximumf %x, %zero : f32
+    linalg.yield %max : f32
+  } -> tensor<16x16xf32>
+  return %relu : tensor<16x16xf32>
+}
+)mlir";
+
+} // namespace
+
+// What --fuse --emit=mlir prints: the epilogue and its MatMul share one
+// scf.for nest.
+TEST(FuseEpilogues, EmitsFusedLoopNest) {
+    mlir::MLIRContext context;
+    registerCompilerDialects(context);
+    mlir::OwningOpRef<mlir::ModuleOp> module =
+        mlir::parseSourceString<mlir::ModuleOp>(kMatMulReluModule, &context);
+    ASSERT_TRUE(module);
+
+    LoweringOptions options;
+    options.fuse = true;
+    ASSERT_TRUE(mlir::succeeded(optimizeTensorIR(context, module, options)));
+
+    std::string text;
+    llvm::raw_string_ostream os(text);
+    module->print(os);
+    os.flush();
+    EXPECT_NE(text.find("scf.for"), std::string::npos) << text;
+
+    int generics = 0;
+    module->walk([&](mlir::linalg::GenericOp op) {
+        ++generics;
+        EXPECT_TRUE(op->getParentOfType<mlir::scf::ForOp>()) << text;
+    });
+    EXPECT_EQ(generics, 1) << text;
+
+    int matmuls = 0;
+    module->walk([&](mlir::linalg::MatmulOp op) {
+        ++matmuls;
+        EXPECT_TRUE(op->getParentOfType<mlir::scf::ForOp>()) << text;
+    });
+    EXPECT_EQ(matmuls, 1) << text;
+}
+
+// Without --fuse the epilogue stays a whole-tensor op.
+TEST(FuseEpilogues, KeepsEpilogueUnfusedByDefault) {
+    mlir::MLIRContext context;
+    registerCompilerDialects(context);
+    mlir::OwningOpRef<mlir::ModuleOp> module =
+        mlir::parseSourceString<mlir::ModuleOp>(kMatMulReluModule, &context);
+    ASSERT_TRUE(module);
+
+    ASSERT_TRUE(mlir::succeeded(optimizeTensorIR(context, module)));
+
+    bool anyLoop = false;
+    module->walk([&](mlir::scf::ForOp) { anyLoop = true; });
+    EXPECT_FALSE(anyLoop);
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "Codegen/Codegen.h"
+#include "Graph.h"
+#include "Lowering/MLIRToLLVM.h"
+#include "ModelFile.h"
+#include "OnnxBuilders.h"
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/DialectResourceBlobManager.h"
+#include "mlir/IR/MLIRContext.h"
+
+using namespace tensor_compiler;
+using namespace tensor_compiler::test;
+
+namespace {
+
+// y = x + w, where the bytes of w are viewed like those of a mapped model
+// file, so Codegen emits them in place when it can.
+class InlineConstants : public ::testing::Test {
+protected:
+    InlineConstants() {
+        registerCompilerDialects(context_);
+        for (size_t i = 0; i < sizeof(storage_); ++i) {
+            storage_[i] = static_cast<char>(i * 7 + 3);
+        }
+    }
+
+    // Generates the module for a w of count floats starting at
+    // storage_ + offset and returns the value of its arith.constant.
+    mlir::Attribute generate(int64_t count, size_t offset) {
+        bytes_ = std::string_view(storage_ + offset,
+                                  static_cast<size_t>(count) * sizeof(float));
+
+        onnx::GraphProto proto;
+        addValueInfo(proto.mutable_input(), "x", {count});
+        onnx::TensorProto *w = proto.add_initializer();
+        w->set_name("w");
+        w->set_data_type(onnx::TensorProto_DataType_FLOAT);
+        w->add_dims(count);
+        addNode(proto, "Add", {"x", "w"}, {"y"});
+        addValueInfo(proto.mutable_output(), "y", {count});
+
+        graph_ = std::make_unique<Graph>(proto, RawDataViews{{"w", bytes_}});
+        CodegenOptions options;
+        options.externalWeights = false;
+        Codegen codegen{context_, options};
+        module_ = codegen.generate(*graph_);
+        if (!module_) {
+            return {};
+        }
+
+        auto wType = mlir::RankedTensorType::get(
+            {count}, mlir::Float32Type::get(&context_));
+        mlir::Attribute value;
+        module_->walk([&](mlir::arith::ConstantOp op) {
+            if (op.getType() == wType) {
+                EXPECT_FALSE(value) << "more than one constant for w";
+                value = op.getValue();
+            }
+        });
+        return value;
+    }
+
+    // The bytes of a resource constant.
+    static llvm::ArrayRef<char> blobData(mlir::Attribute value) {
+        auto resource = mlir::dyn_cast<mlir::DenseResourceElementsAttr>(value);
+        if (!resource || !resource.getRawHandle().getBlob()) {
+            return {};
+        }
+        return resource.getRawHandle().getBlob()->getData();
+    }
+
+    bool sameBytes(llvm::ArrayRef<char> data) const {
+        return data.size() == bytes_.size() &&
+               std::memcmp(data.data(), bytes_.data(), bytes_.size()) == 0;
+    }
+
+    alignas(64) char storage_[1024 + 64];
+    std::string_view bytes_;
+    mlir::MLIRContext context_;
+    std::unique_ptr<Graph> graph_;
+    mlir::OwningOpRef<mlir::ModuleOp> module_;
+};
+
+} // namespace
+
+TEST_F(InlineConstants, ViewsAlignedBytesInPlace) {
+    mlir::Attribute value = generate(256, /*offset=*/sizeof(float));
+    llvm::ArrayRef<char> data = blobData(value);
+    ASSERT_FALSE(data.empty());
+    EXPECT_EQ(data.data(), bytes_.data());
+    EXPECT_TRUE(sameBytes(data));
+}
+
+// A pointer that is not a multiple of alignof(float) must not be read as
+// floats; the blob gets an aligned copy.
+TEST_F(InlineConstants, CopiesMisalignedBytes) {
+    mlir::Attribute value = generate(256, /*offset=*/2);
+    llvm::ArrayRef<char> data = blobData(value);
+    ASSERT_FALSE(data.empty());
+    EXPECT_NE(data.data(), bytes_.data());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(data.data()) % alignof(float), 0u);
+    EXPECT_TRUE(sameBytes(data));
+}
+
+// Below kMinExternalWeightBytes a constant stays dense, aligned or not.
+TEST_F(InlineConstants, KeepsSmallConstantsDense) {
+    constexpr int64_t count = kMinExternalWeightBytes / sizeof(float) - 1;
+    for (size_t offset : {size_t{0}, size_t{1}}) {
+        mlir::Attribute value = generate(count, offset);
+        auto dense = mlir::dyn_cast_or_null<mlir::DenseElementsAttr>(value);
+        ASSERT_TRUE(dense) << "offset " << offset;
+        llvm::ArrayRef<char> data = dense.getRawData();
+        EXPECT_NE(data.data(), bytes_.data());
+        EXPECT_TRUE(sameBytes(data)) << "offset " << offset;
+    }
+}
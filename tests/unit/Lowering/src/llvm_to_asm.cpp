@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+
+#include <dlfcn.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Lowering/LLVMToASM.h"
+#include "Lowering/LLVMToLLVMIR.h"
+#include "Lowering/MLIRToLLVM.h"
+
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/BinaryFormat/Magic.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Object/Archive.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/TargetParser/Host.h"
+
+#ifndef TENSOR_COMPILER_RUNTIME_LIB
+#define TENSOR_COMPILER_RUNTIME_LIB "libtensor_runtime.a"
+#endif
+
+using namespace tensor_compiler;
+
+namespace {
+
+// The model entry point of ModelRunner.c around one parallel loop nest:
+// output = input + 1. The memory planner adds the workspace and its size
+// function, the layer becomes a function of its own and, with --parallel,
+// its loop is outlined, so the module defines four functions.
+constexpr const char *kAddOneModule = R"mlir(
+func.func @tensorCompForwardImpl(%in: memref<64x64xf32>,
+                                 %out: memref<64x64xf32>) -> i32 {
+  %one = arith.constant 1.0 : f32
+  linalg.generic {indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                                   affine_map<(d0, d1) -> (d0, d1)>],
+                  iterator_types = ["parallel", "parallel"]}
+      ins(%in : memref<64x64xf32>) outs(%out : memref<64x64xf32>) {
+  ^bb0(%a: f32, %b: f32):
+    %sum = arith.addf %a, %one : f32
+    linalg.yield %sum : f32
+  }
+  %ok = arith.constant 0 : i32
+  return %ok : i32
+}
+)mlir";
+
+// Two layers through a planned intermediate buffer, without --parallel:
+// output = (input + 1) * 2. The size function, the entry point and one
+// function per layer make four definitions.
+constexpr const char *kTwoLayerModule = R"mlir(
+func.func @tensorCompForwardImpl(%in: memref<64x64xf32>,
+                                 %out: memref<64x64xf32>) -> i32 {
+  %one = arith.constant 1.0 : f32
+  %two = arith.constant 2.0 : f32
+  %tmp = memref.alloc() : memref<64x64xf32>
+  linalg.generic {indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                                   affine_map<(d0, d1) -> (d0, d1)>],
+                  iterator_types = ["parallel", "parallel"]}
+      ins(%in : memref<64x64xf32>) outs(%tmp : memref<64x64xf32>) {
+  ^bb0(%a: f32, %b: f32):
+    %sum = arith.addf %a, %one : f32
+    linalg.yield %sum : f32
+  }
+  linalg.generic {indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                                   affine_map<(d0, d1) -> (d0, d1)>],
+                  iterator_types = ["parallel", "parallel"]}
+      ins(%tmp : memref<64x64xf32>) outs(%out : memref<64x64xf32>) {
+  ^bb0(%a: f32, %b: f32):
+    %product = arith.mulf %a, %two : f32
+    linalg.yield %product : f32
+  }
+  memref.dealloc %tmp : memref<64x64xf32>
+  %ok = arith.constant 0 : i32
+  return %ok : i32
+}
+)mlir";
+
+std::unique_ptr<llvm::Module> lowerToLLVMIR(llvm::LLVMContext &llvmContext,
+                                            const char *source,
+                                            const LoweringOptions &options) {
+    mlir::MLIRContext context;
+    registerCompilerDialects(context);
+    mlir::OwningOpRef<mlir::ModuleOp> module =
+        mlir::parseSourceString<mlir::ModuleOp>(source, &context);
+    if (!module || mlir::failed(MLIRToLLVM(context, module, options))) {
+        return nullptr;
+    }
+    return LLVMToLLVMIR(llvmContext, module);
+}
+
+size_t countMembers(const std::string &archivePath) {
+    auto buffer = llvm::MemoryBuffer::getFile(archivePath);
+    if (!buffer) {
+        return 0;
+    }
+    auto archive = llvm::object::Archive::create((*buffer)->getMemBufferRef());
+    if (!archive) {
+        llvm::consumeError(archive.takeError());
+        return 0;
+    }
+    size_t members = 0;
+    llvm::Error error = llvm::Error::success();
+    for (const auto &child : (*archive)->children(error)) {
+        (void)child;
+        ++members;
+    }
+    if (error) {
+        llvm::consumeError(std::move(error));
+        return 0;
+    }
+    return members;
+}
+
+// Loads a --emit=so library and checks tensorCompForward on 64x64 inputs.
+void expectForward(const std::string &soPath, float (*expected)(float)) {
+    void *library = dlopen(soPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+    ASSERT_NE(library, nullptr) << dlerror();
+    using Forward = int (*)(const float *, float *);
+    auto forward =
+        reinterpret_cast<Forward>(dlsym(library, "tensorCompForward"));
+    ASSERT_NE(forward, nullptr);
+
+    std::vector<float> input(64 * 64);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<float>(i);
+    }
+    std::vector<float> output(input.size(), 0.0f);
+    EXPECT_EQ(forward(input.data(), output.data()), 0);
+    for (size_t i = 0; i < input.size(); ++i) {
+        ASSERT_EQ(output[i], expected(input[i])) << "at " << i;
+    }
+    dlclose(library);
+}
+
+} // namespace
+
+// ---------------------------------- generateCode -----------------------------
+
+// -j2 --parallel: the module is compiled on two threads into an archive of
+// two objects, which must link into a working shared library.
+TEST(GenerateCode, LinksArchiveSplitAcrossThreads) {
+    LoweringOptions options;
+    options.parallel = true;
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> llvmModule =
+        lowerToLLVMIR(llvmContext, kAddOneModule, options);
+    ASSERT_TRUE(llvmModule);
+
+    llvm::SmallString<128> dir;
+    ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("tc_split_codegen", dir));
+    llvm::SmallString<128> archivePath(dir);
+    llvm::sys::path::append(archivePath, "model.a");
+    llvm::SmallString<128> soPath(dir);
+    llvm::sys::path::append(soPath, "libmodel.so");
+
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream out(archivePath, ec, llvm::sys::fs::OF_None);
+        ASSERT_FALSE(ec);
+        const TargetSpec target{llvm::sys::getProcessTriple(), "", ""};
+        ASSERT_TRUE(mlir::succeeded(
+            generateCode(llvmModule.get(), target, /*optLevel=*/2,
+                         CodeGenFile::archive, out, /*threads=*/2)));
+    }
+    EXPECT_EQ(countMembers(std::string(archivePath)), 2u);
+
+    ASSERT_TRUE(mlir::succeeded(linkSharedLibrary(
+        std::string(archivePath), TENSOR_COMPILER_RUNTIME_LIB,
+        std::string(soPath))));
+    expectForward(std::string(soPath), [](float x) { return x + 1.0f; });
+
+    llvm::sys::fs::remove_directories(dir);
+}
+
+// -j4 without --parallel: each layer is a function of its own, so the
+// module still splits into four partitions. --emit=obj merges them into
+// one relocatable object, which links like a single-threaded one.
+TEST(GenerateCode, SplitsLayersAndMergesArchiveIntoObject) {
+    llvm::LLVMContext llvmContext;
+    std::unique_ptr<llvm::Module> llvmModule =
+        lowerToLLVMIR(llvmContext, kTwoLayerModule, LoweringOptions{});
+    ASSERT_TRUE(llvmModule);
+
+    llvm::SmallString<128> dir;
+    ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("tc_split_codegen", dir));
+    llvm::SmallString<128> archivePath(dir);
+    llvm::sys::path::append(archivePath, "model.a");
+    llvm::SmallString<128> objPath(dir);
+    llvm::sys::path::append(objPath, "model.o");
+    llvm::SmallString<128> soPath(dir);
+    llvm::sys::path::append(soPath, "libmodel.so");
+
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream out(archivePath, ec, llvm::sys::fs::OF_None);
+        ASSERT_FALSE(ec);
+        const TargetSpec target{llvm::sys::getProcessTriple(), "", ""};
+        ASSERT_TRUE(mlir::succeeded(
+            generateCode(llvmModule.get(), target, /*optLevel=*/2,
+                         CodeGenFile::archive, out, /*threads=*/4)));
+    }
+    EXPECT_EQ(countMembers(std::string(archivePath)), 4u);
+
+    ASSERT_TRUE(mlir::succeeded(linkRelocatableObject(
+        std::string(archivePath), std::string(objPath))));
+    auto objBuffer = llvm::MemoryBuffer::getFile(objPath);
+    ASSERT_TRUE(objBuffer);
+    EXPECT_EQ(llvm::identify_magic((*objBuffer)->getBuffer()),
+              llvm::file_magic::elf_relocatable);
+
+    ASSERT_TRUE(mlir::succeeded(linkSharedLibrary(
+        std::string(objPath), TENSOR_COMPILER_RUNTIME_LIB,
+        std::string(soPath))));
+    expectForward(std::string(soPath),
+                  [](float x) { return (x + 1.0f) * 2.0f; });
+
+    llvm::sys::fs::remove_directories(dir);
+}
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Lowering/MLIRToLLVM.h"
+#include "Lowering/MemoryPlanner.h"
+
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+
+using namespace tensor_compiler;
+
+namespace {
+
+// %a is dead once %b is allocated.
+constexpr const char *kDisjointModule = R"mlir(
+func.func private @use(memref<256xf32>)
+
+func.func @tensorCompForwardImpl() -> i32 {
+  %a = memref.alloc() : memref<256xf32>
+  call @use(%a) : (memref<256xf32>) -> ()
+  %b = memref.alloc() : memref<256xf32>
+  call @use(%b) : (memref<256xf32>) -> ()
+  %ok = arith.constant 0 : i32
+  return %ok : i32
+}
+)mlir";
+
+// %a and %b are used by the same op.
+constexpr const char *kOverlappingModule = R"mlir(
+func.func private @use2(memref<256xf32>, memref<256xf32>)
+
+func.func @tensorCompForwardImpl() -> i32 {
+  %a = memref.alloc() : memref<256xf32>
+  %b = memref.alloc() : memref<256xf32>
+  call @use2(%a, %b) : (memref<256xf32>, memref<256xf32>) -> ()
+  %ok = arith.constant 0 : i32
+  return %ok : i32
+}
+)mlir";
+
+// %a is last used through a subview, after the only use of %b.
+constexpr const char *kSubviewModule = R"mlir(
+func.func private @use(memref<64xf32>)
+func.func private @useView(memref<16xf32, strided<[1], offset: 8>>)
+
+func.func @tensorCompForwardImpl() -> i32 {
+  %a = memref.alloc() : memref<64xf32>
+  %b = memref.alloc() : memref<64xf32>
+  %view = memref.subview %a[8] [16] [1]
+      : memref<64xf32> to memref<16xf32, strided<[1], offset: 8>>
+  call @use(%b) : (memref<64xf32>) -> ()
+  call @useView(%view) : (memref<16xf32, strided<[1], offset: 8>>) -> ()
+  %ok = arith.constant 0 : i32
+  return %ok : i32
+}
+)mlir";
+
+// %a is carried through a loop and last used through its result.
+constexpr const char *kLoopModule = R"mlir(
+func.func private @use(memref<64xf32>)
+
+func.func @tensorCompForwardImpl() -> i32 {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %a = memref.alloc() : memref<64xf32>
+  %loop = scf.for %i = %c0 to %c4 step %c1
+      iter_args(%x = %a) -> (memref<64xf32>) {
+    scf.yield %x : memref<64xf32>
+  }
+  %b = memref.alloc() : memref<64xf32>
+  call @use(%b) : (memref<64xf32>) -> ()
+  call @use(%loop) : (memref<64xf32>) -> ()
+  %ok = arith.constant 0 : i32
+  return %ok : i32
+}
+)mlir";
+
+// %a escapes through func.return and must stay a heap allocation.
+constexpr const char *kReturnedModule = R"mlir(
+func.func private @use(memref<16xf32>)
+
+func.func @tensorCompForwardImpl() -> memref<16xf32> {
+  %a = memref.alloc() : memref<16xf32>
+  %b = memref.alloc() : memref<16xf32>
+  call @use(%b) : (memref<16xf32>) -> ()
+  return %a : memref<16xf32>
+}
+)mlir";
+
+// 28, 12 and 5 bytes, all live at once.
+constexpr const char *kUnalignedModule = R"mlir(
+func.func private @use3(memref<7xf32>, memref<3xf32>, memref<5xi8>)
+
+func.func @tensorCompForwardImpl() -> i32 {
+  %a = memref.alloc() : memref<7xf32>
+  %b = memref.alloc() : memref<3xf32>
+  %c = memref.alloc() : memref<5xi8>
+  call @use3(%a, %b, %c) : (memref<7xf32>, memref<3xf32>, memref<5xi8>) -> ()
+  %ok = arith.constant 0 : i32
+  return %ok : i32
+}
+)mlir";
+
+class MemoryPlanner : public ::testing::Test {
+protected:
+    MemoryPlanner() { registerCompilerDialects(context_); }
+
+    // Parses source and runs the memory planner on it.
+    void plan(const char *source) {
+        module_ = mlir::parseSourceString<mlir::ModuleOp>(source, &context_);
+        ASSERT_TRUE(module_);
+        mlir::PassManager pm(&context_);
+        pm.addPass(createMemoryPlannerPass());
+        ASSERT_TRUE(mlir::succeeded(pm.run(*module_)));
+    }
+
+    mlir::func::FuncOp entry() {
+        return module_->lookupSymbol<mlir::func::FuncOp>(
+            "tensorCompForwardImpl");
+    }
+
+    // Byte offsets of the workspace views, in allocation order.
+    std::vector<int64_t> offsets() {
+        std::vector<int64_t> result;
+        entry().walk([&](mlir::memref::ViewOp view) {
+            std::optional<int64_t> offset =
+                mlir::getConstantIntValue(view.getByteShift());
+            EXPECT_TRUE(offset.has_value());
+            result.push_back(offset.value_or(-1));
+        });
+        return result;
+    }
+
+    // The constant tensorCompWorkspaceSizeImpl returns.
+    std::optional<int64_t> workspaceSize() {
+        auto sizeFunc =
+            module_->lookupSymbol<mlir::func::FuncOp>(kWorkspaceSizeFuncName);
+        if (!sizeFunc) {
+            return std::nullopt;
+        }
+        auto ret = mlir::cast<mlir::func::ReturnOp>(
+            sizeFunc.getBody().front().getTerminator());
+        return mlir::getConstantIntValue(ret.getOperand(0));
+    }
+
+    // Size of the trailing workspace argument of the entry function.
+    int64_t workspaceArgumentSize() {
+        mlir::func::FuncOp func = entry();
+        auto type = mlir::cast<mlir::MemRefType>(
+            func.getArgument(func.getNumArguments() - 1).getType());
+        EXPECT_TRUE(type.getElementType().isInteger(8));
+        return type.getNumElements();
+    }
+
+    int remainingAllocs() {
+        int count = 0;
+        entry().walk([&](mlir::memref::AllocOp) { ++count; });
+        return count;
+    }
+
+    mlir::MLIRContext context_;
+    mlir::OwningOpRef<mlir::ModuleOp> module_;
+};
+
+} // namespace
+
+TEST_F(MemoryPlanner, SharesMemoryOfDisjointLifetimes) {
+    plan(kDisjointModule);
+    EXPECT_EQ(remainingAllocs(), 0);
+    EXPECT_EQ(offsets(), (std::vector<int64_t>{0, 0}));
+    EXPECT_EQ(workspaceSize(), 1024);
+    EXPECT_EQ(workspaceArgumentSize(), 1024);
+}
+
+TEST_F(MemoryPlanner, SeparatesOverlappingLifetimes) {
+    plan(kOverlappingModule);
+    EXPECT_EQ(offsets(), (std::vector<int64_t>{0, 1024}));
+    EXPECT_EQ(workspaceSize(), 2048);
+    EXPECT_EQ(workspaceArgumentSize(), 2048);
+}
+
+TEST_F(MemoryPlanner, FollowsSubviews) {
+    plan(kSubviewModule);
+    std::vector<int64_t> placed = offsets();
+    ASSERT_EQ(placed.size(), 2u);
+    EXPECT_NE(placed[0], placed[1]);
+    EXPECT_EQ(workspaceSize(), 512);
+}
+
+TEST_F(MemoryPlanner, FollowsLoopResults) {
+    plan(kLoopModule);
+    std::vector<int64_t> placed = offsets();
+    ASSERT_EQ(placed.size(), 2u);
+    EXPECT_NE(placed[0], placed[1]);
+    EXPECT_EQ(workspaceSize(), 512);
+}
+
+TEST_F(MemoryPlanner, KeepsReturnedBuffersOnTheHeap) {
+    plan(kReturnedModule);
+    EXPECT_EQ(remainingAllocs(), 1);
+    EXPECT_EQ(offsets(), (std::vector<int64_t>{0}));
+    EXPECT_EQ(workspaceSize(), 64);
+}
+
+// Largest first: 28 bytes at 0, 12 at 64, 5 at 128; the size is rounded up
+// to the alignment as well.
+TEST_F(MemoryPlanner, AlignsOffsetsTo64Bytes) {
+    plan(kUnalignedModule);
+    std::vector<int64_t> placed = offsets();
+    EXPECT_EQ(placed, (std::vector<int64_t>{0, 64, 128}));
+    for (int64_t offset : placed) {
+        EXPECT_EQ(offset % kWorkspaceAlignment, 0);
+    }
+    EXPECT_EQ(workspaceSize(), 192);
+    EXPECT_EQ(workspaceArgumentSize(), 192);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "Lowering/MLIRToLLVM.h"
+#include "Lowering/TileAndVectorize.h"
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+
+using namespace tensor_compiler;
+
+namespace {
+
+// 32 filters over 16 channels, 32 output columns: one tile holds vw filters
+// x vw columns x 16 channels x 3 taps, 12288 elements at 16 lanes.
+constexpr const char *kConvModule = R"mlir(
+func.func @conv(%x: tensor<1x16x3x34xf32>, %w: tensor<32x16x3x3xf32>,
+                %init: tensor<1x32x1x32xf32>) -> tensor<1x32x1x32xf32> {
+  %0 = linalg.conv_2d_nchw_fchw
+         {dilations = dense<1> : tensor<2xi64>,
+          strides = dense<1> : tensor<2xi64>}
+         ins(%x, %w : tensor<1x16x3x34xf32>, tensor<32x16x3x3xf32>)
+         outs(%init : tensor<1x32x1x32xf32>) -> tensor<1x32x1x32xf32>
+  return %0 : tensor<1x32x1x32xf32>
+}
+)mlir";
+
+struct VectorizeResult {
+    int convOps = 0;
+    int vectorOps = 0;
+};
+
+VectorizeResult tileAndVectorizeConv(int64_t vectorWidth) {
+    mlir::MLIRContext context;
+    registerCompilerDialects(context);
+    mlir::OwningOpRef<mlir::ModuleOp> module =
+        mlir::parseSourceString<mlir::ModuleOp>(kConvModule, &context);
+    EXPECT_TRUE(module);
+    if (!module) {
+        return {};
+    }
+
+    TileAndVectorizeOptions options;
+    options.vectorWidth = vectorWidth;
+    mlir::PassManager pm(&context);
+    pm.addNestedPass<mlir::func::FuncOp>(createTileAndVectorizePass(options));
+    EXPECT_TRUE(mlir::succeeded(pm.run(*module)));
+
+    VectorizeResult result;
+    module->walk([&](mlir::Operation *op) {
+        if (mlir::isa<mlir::linalg::ConvolutionOpInterface>(op)) {
+            ++result.convOps;
+        }
+        if (op->getDialect() &&
+            op->getDialect()->getNamespace() == "vector") {
+            ++result.vectorOps;
+        }
+    });
+    return result;
+}
+
+} // namespace
+
+TEST(TileAndVectorize, VectorizesConvAtEightLanes) {
+    VectorizeResult result = tileAndVectorizeConv(8);
+    EXPECT_EQ(result.convOps, 0);
+    EXPECT_GT(result.vectorOps, 0);
+}
+
+// AVX-512: the tile is three times the budget of 8 lanes, which must grow
+// with the vector width instead of turning conv vectorization off.
+TEST(TileAndVectorize, VectorizesConvAtSixteenLanes) {
+    VectorizeResult result = tileAndVectorizeConv(16);
+    EXPECT_EQ(result.convOps, 0);
+    EXPECT_GT(result.vectorOps, 0);
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ModelAPI/ModelAPI.h"
+
+namespace {
+
+// Records every chunk handed to the body and how often each iteration ran.
+struct Trace {
+    int64_t lb;
+    int64_t step;
+    std::vector<std::atomic<int>> hits;
+    std::mutex lock;
+    std::vector<std::pair<int64_t, int64_t>> chunks;
+    std::vector<std::thread::id> threads;
+
+    Trace(int64_t lb, int64_t ub, int64_t step)
+        : lb(lb), step(step),
+          hits(static_cast<size_t>(ub > lb ? ub - lb : 0)) {}
+};
+
+void recordChunk(int64_t begin, int64_t end, void *ctx) {
+    auto *trace = static_cast<Trace *>(ctx);
+    for (int64_t i = begin; i < end; i += trace->step) {
+        ++trace->hits[static_cast<size_t>(i - trace->lb)];
+    }
+    std::lock_guard<std::mutex> guard(trace->lock);
+    trace->chunks.emplace_back(begin, end);
+    trace->threads.push_back(std::this_thread::get_id());
+}
+
+// Checks that every iteration lb + k * step below ub ran exactly once.
+void expectEachIterationOnce(const Trace &trace, int64_t ub) {
+    for (int64_t i = trace.lb; i < ub; ++i) {
+        const int expected = (i - trace.lb) % trace.step == 0 ? 1 : 0;
+        ASSERT_EQ(trace.hits[static_cast<size_t>(i - trace.lb)].load(),
+                  expected)
+            << "iteration " << i;
+    }
+}
+
+// Restores the default pool size after each test.
+class ThreadPool : public ::testing::Test {
+protected:
+    void TearDown() override { tensorCompSetNumThreads(0); }
+};
+
+} // namespace
+
+TEST_F(ThreadPool, RunsEveryIterationOnceInStepAlignedChunks) {
+    tensorCompSetNumThreads(4);
+    const int64_t lb = 3;
+    const int64_t ub = 1000;
+    const int64_t step = 7;
+    Trace trace(lb, ub, step);
+
+    tensorCompParallelFor(recordChunk, lb, ub, step, &trace);
+
+    expectEachIterationOnce(trace, ub);
+    EXPECT_GT(trace.chunks.size(), 1u);
+    for (auto [begin, end] : trace.chunks) {
+        EXPECT_EQ((begin - lb) % step, 0) << "chunk begin " << begin;
+        EXPECT_LT(begin, end);
+        EXPECT_LE(end, ub);
+        EXPECT_TRUE(end == ub || (end - lb) % step == 0)
+            << "chunk end " << end;
+    }
+}
+
+TEST_F(ThreadPool, RunsShortLoopsOnTheCallingThread) {
+    tensorCompSetNumThreads(4);
+
+    // One iteration: a single call with the original bounds.
+    Trace single(5, 9, 4);
+    tensorCompParallelFor(recordChunk, 5, 9, 4, &single);
+    ASSERT_EQ(single.chunks.size(), 1u);
+    EXPECT_EQ(single.chunks[0], (std::pair<int64_t, int64_t>{5, 9}));
+    EXPECT_EQ(single.threads[0], std::this_thread::get_id());
+
+    // Empty ranges and non-positive steps do nothing.
+    Trace empty(0, 10, 1);
+    tensorCompParallelFor(recordChunk, 10, 10, 1, &empty);
+    tensorCompParallelFor(recordChunk, 10, 0, 1, &empty);
+    tensorCompParallelFor(recordChunk, 0, 10, 0, &empty);
+    tensorCompParallelFor(recordChunk, 0, 10, -1, &empty);
+    EXPECT_TRUE(empty.chunks.empty());
+}
+
+namespace {
+
+struct Nested {
+    Trace outer{0, 8, 1};
+    std::mutex lock;
+    std::vector<Trace *> inner;
+};
+
+void runNested(int64_t begin, int64_t end, void *ctx) {
+    auto *nested = static_cast<Nested *>(ctx);
+    recordChunk(begin, end, &nested->outer);
+    auto *trace = new Trace(0, 100, 1);
+    tensorCompParallelFor(recordChunk, 0, 100, 1, trace);
+    std::lock_guard<std::mutex> guard(nested->lock);
+    nested->inner.push_back(trace);
+}
+
+} // namespace
+
+TEST_F(ThreadPool, RunsNestedLoopsSerially) {
+    tensorCompSetNumThreads(4);
+    Nested nested;
+
+    tensorCompParallelFor(runNested, 0, 8, 1, &nested);
+
+    expectEachIterationOnce(nested.outer, 8);
+    ASSERT_EQ(nested.inner.size(), nested.outer.chunks.size());
+    for (size_t i = 0; i < nested.inner.size(); ++i) {
+        Trace *inner = nested.inner[i];
+        ASSERT_EQ(inner->chunks.size(), 1u);
+        EXPECT_EQ(inner->chunks[0], (std::pair<int64_t, int64_t>{0, 100}));
+        expectEachIterationOnce(*inner, 100);
+        delete inner;
+    }
+}
+
+TEST_F(ThreadPool, SetsAndRestartsThreadCount) {
+    tensorCompSetNumThreads(3);
+    EXPECT_EQ(tensorCompGetNumThreads(), 3);
+
+    Trace first(0, 256, 1);
+    tensorCompParallelFor(recordChunk, 0, 256, 1, &first);
+    expectEachIterationOnce(first, 256);
+    EXPECT_EQ(tensorCompGetNumThreads(), 3);
+
+    // Changing the count stops the running pool; the next loop restarts it.
+    tensorCompSetNumThreads(2);
+    EXPECT_EQ(tensorCompGetNumThreads(), 2);
+    Trace second(0, 256, 1);
+    tensorCompParallelFor(recordChunk, 0, 256, 1, &second);
+    expectEachIterationOnce(second, 256);
+    EXPECT_EQ(tensorCompGetNumThreads(), 2);
+
+    // One thread runs the whole range on the caller.
+    tensorCompSetNumThreads(1);
+    EXPECT_EQ(tensorCompGetNumThreads(), 1);
+    Trace serial(0, 256, 1);
+    tensorCompParallelFor(recordChunk, 0, 256, 1, &serial);
+    ASSERT_EQ(serial.chunks.size(), 1u);
+    EXPECT_EQ(serial.threads[0], std::this_thread::get_id());
+
+    tensorCompSetNumThreads(0);
+    EXPECT_GE(tensorCompGetNumThreads(), 1);
+}
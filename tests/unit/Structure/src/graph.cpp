@@ -2,6 +2,139 @@
 #include <gtest/gtest.h>
 
 #include "Graph.h"
+#include "OnnxBuilders.h"
 
 using namespace tensor_compiler;
+using namespace tensor_compiler::test;
 
+namespace {
+
+// x -> Relu -> a -> Mul(a, a) -> b -> Add(a, b) -> y
+onnx::GraphProto makeDiamond() {
+    onnx::GraphProto g;
+    g.add_input()->set_name("x");
+    addNode(g, "Relu", {"x"}, {"a"});
+    addNode(g, "Mul", {"a", "a"}, {"b"});
+    addNode(g, "Add", {"a", "b"}, {"y"});
+    g.add_output()->set_name("y");
+    return g;
+}
+
+} // namespace
+
+TEST(Graph, IndexesProducersAndConsumers) {
+    Graph graph{makeDiamond()};
+
+    EXPECT_FALSE(graph.producer("x").has_value());
+    EXPECT_EQ(graph.producer("a"), std::optional<std::size_t>(0));
+    EXPECT_EQ(graph.producer("y"), std::optional<std::size_t>(2));
+
+    EXPECT_EQ(graph.consumers("x"), (std::vector<std::size_t>{0}));
+    EXPECT_EQ(graph.consumers("a"), (std::vector<std::size_t>{1, 2}));
+    EXPECT_TRUE(graph.consumers("y").empty());
+    EXPECT_TRUE(graph.consumers("unknown").empty());
+}
+
+TEST(Graph, SetNodesRebuildsIndex) {
+    Graph graph{makeDiamond()};
+
+    std::vector<Node> nodes = graph.nodes();
+    nodes[2].setInputs(std::vector<std::string>{"x", "b"});
+    nodes.erase(nodes.begin());
+    nodes[0].setInputs(std::vector<std::string>{"x", "x"});
+    graph.setNodes(std::move(nodes));
+
+    EXPECT_FALSE(graph.producer("a").has_value());
+    EXPECT_TRUE(graph.consumers("a").empty());
+    EXPECT_EQ(graph.producer("b"), std::optional<std::size_t>(0));
+    EXPECT_EQ(graph.consumers("x"), (std::vector<std::size_t>{0, 1}));
+}
+
+TEST(Graph, InternsTensorNamesToDenseIds) {
+    Graph graph{makeDiamond()};
+
+    ASSERT_EQ(graph.tensorIdCount(), 4u);
+    auto a = graph.tensorId("a");
+    ASSERT_TRUE(a.has_value());
+    EXPECT_LT(*a, graph.tensorIdCount());
+    EXPECT_EQ(graph.tensorName(*a), "a");
+    EXPECT_EQ(graph.tensor(*a), graph.tensor("a"));
+    EXPECT_FALSE(graph.tensorId("unknown").has_value());
+    EXPECT_EQ(graph.tensor(kNoTensor), nullptr);
+
+    const Node &mul = graph.nodes()[1];
+    EXPECT_EQ(mul.inputIds(), (std::vector<TensorId>{*a, *a}));
+    EXPECT_EQ(mul.outputIds(), (std::vector<TensorId>{*graph.tensorId("b")}));
+    EXPECT_EQ(graph.consumers(*a), (std::vector<std::size_t>{1, 2}));
+    EXPECT_EQ(graph.producer(*a), std::optional<std::size_t>(0));
+}
+
+TEST(Graph, KeepsIdsAcrossRewritesAndCopies) {
+    Graph graph{makeDiamond()};
+    const TensorId a = *graph.tensorId("a");
+
+    graph.removeTensor("a");
+    EXPECT_EQ(graph.tensor(a), nullptr);
+    EXPECT_EQ(graph.tensorId("a"), a);
+
+    graph.replaceUses("a", "x");
+    const TensorId x = *graph.tensorId("x");
+    EXPECT_EQ(graph.nodes()[2].inputIds()[0], x);
+    EXPECT_EQ(graph.consumers(x), (std::vector<std::size_t>{0, 1, 2}));
+
+    Graph copy = graph;
+    EXPECT_EQ(copy.tensorId("x"), x);
+    EXPECT_EQ(copy.tensor("x")->name(), "x");
+    EXPECT_NE(copy.tensor("x"), graph.tensor("x"));
+}
+
+TEST(Graph, RemapsStandaloneNodesAndTensorsToItsIds) {
+    Graph graph{makeDiamond()};
+
+    Node node{"n", "Neg"};
+    node.setInputs(std::vector<std::string>{"z", "b"});
+    node.setOutputs(std::vector<std::string>{"c"});
+    graph.addNode(node);
+    graph.addTensor(Tensor::create("z", {1}, {1.0f}, Tensor_kind::constant));
+
+    const Node &added = graph.nodes().back();
+    const TensorId z = *graph.tensorId("z");
+    EXPECT_EQ(added.inputIds(),
+              (std::vector<TensorId>{z, *graph.tensorId("b")}));
+    EXPECT_EQ(added.inputs(), (std::vector<std::string>{"z", "b"}));
+    EXPECT_EQ(graph.producer("c"), std::optional<std::size_t>(3));
+    ASSERT_NE(graph.tensor(z), nullptr);
+    EXPECT_EQ(graph.tensor(z)->name(), "z");
+}
+
+TEST(Graph, StoresInputsAndOutputsAsIds) {
+    Graph graph{makeDiamond()};
+
+    EXPECT_EQ(graph.inputIds(), (std::vector<TensorId>{*graph.tensorId("x")}));
+    EXPECT_EQ(graph.outputIds(), (std::vector<TensorId>{*graph.tensorId("y")}));
+    EXPECT_EQ(graph.inputs(), (std::vector<std::string>{"x"}));
+
+    graph.setOutputs({"a", "y"});
+    EXPECT_EQ(graph.outputIds(), (std::vector<TensorId>{*graph.tensorId("a"),
+                                                        *graph.tensorId("y")}));
+    EXPECT_EQ(graph.outputs(), (std::vector<std::string>{"a", "y"}));
+}
+
+TEST(Graph, DetachedCopiesDoNotInternIntoItsTable) {
+    Graph graph{makeDiamond()};
+    const std::size_t count = graph.tensorIdCount();
+
+    Tensor tensor = *graph.tensor("a");
+    tensor.setName("renamed");
+    EXPECT_EQ(tensor.name(), "renamed");
+
+    Node node = graph.nodes()[1];
+    node.setInputs(std::vector<std::string>{"a", "extra"});
+    node.setOutputs(std::vector<std::string>{"out"});
+    EXPECT_EQ(node.inputs(), (std::vector<std::string>{"a", "extra"}));
+    EXPECT_EQ(node.outputs(), (std::vector<std::string>{"out"}));
+
+    EXPECT_EQ(graph.tensorIdCount(), count);
+    EXPECT_FALSE(graph.tensorId("renamed").has_value());
+    EXPECT_EQ(graph.nodes()[1].inputs(), (std::vector<std::string>{"a", "a"}));
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "Graph.h"
+#include "ModelFile.h"
+
+using namespace tensor_compiler;
+
+// ------------------------------ Helpers ----------------------------------------
+
+static onnx::ModelProto makeModel() {
+    onnx::ModelProto model;
+    model.set_ir_version(8);
+    model.set_producer_name("test");
+    model.add_opset_import()->set_version(17);
+
+    onnx::GraphProto *graph = model.mutable_graph();
+    graph->set_name("g");
+
+    onnx::TensorProto *w = graph->add_initializer();
+    w->set_name("W");
+    w->add_dims(2);
+    w->set_data_type(onnx::TensorProto_DataType_FLOAT);
+    w->set_raw_data(std::string("\x00\x00\x80\x3f\x00\x00\x00\x40", 8));
+
+    // float_data initializers are kept in the parsed model.
+    onnx::TensorProto *b = graph->add_initializer();
+    b->set_name("B");
+    b->add_dims(1);
+    b->set_data_type(onnx::TensorProto_DataType_FLOAT);
+    b->add_float_data(3.0f);
+
+    onnx::NodeProto *node = graph->add_node();
+    node->set_op_type("Add");
+    node->add_input("W");
+    node->add_input("B");
+    node->add_output("Y");
+    return model;
+}
+
+// ------------------------------ Parsing ----------------------------------------
+
+TEST(ModelFile, ParseCutsRawDataIntoViews) {
+    const std::string bytes = makeModel().SerializeAsString();
+
+    onnx::ModelProto model;
+    RawDataViews rawData;
+    ASSERT_TRUE(parseModelWithoutRawData(bytes, model, rawData));
+
+    ASSERT_EQ(model.graph().initializer_size(), 2);
+    EXPECT_EQ(model.graph().initializer(0).name(), "W");
+    EXPECT_TRUE(model.graph().initializer(0).raw_data().empty());
+    EXPECT_EQ(model.graph().initializer(0).dims(0), 2);
+    EXPECT_EQ(model.graph().initializer(1).float_data_size(), 1);
+    EXPECT_EQ(model.graph().node(0).op_type(), "Add");
+    EXPECT_EQ(model.producer_name(), "test");
+    EXPECT_EQ(model.opset_import(0).version(), 17);
+
+    ASSERT_EQ(rawData.size(), 1u);
+    std::string_view w = rawData.at("W");
+    EXPECT_EQ(w.size(), 8u);
+    EXPECT_GE(w.data(), bytes.data());
+    EXPECT_LE(w.data() + w.size(), bytes.data() + bytes.size());
+}
+
+TEST(ModelFile, ParseRejectsTruncatedInput) {
+    const std::string bytes = makeModel().SerializeAsString();
+
+    onnx::ModelProto model;
+    RawDataViews rawData;
+    EXPECT_FALSE(parseModelWithoutRawData(
+        std::string_view(bytes).substr(0, bytes.size() - 3), model, rawData));
+}
+
+TEST(ModelFile, GraphTensorsViewMappedFile) {
+    std::string path = ::testing::TempDir() + "model_file_test.onnx";
+    {
+        std::ofstream out(path, std::ios::binary);
+        ASSERT_TRUE(makeModel().SerializeToOstream(&out));
+    }
+
+    {
+        ModelFile file(path);
+        Graph graph(file.model().graph(), file.rawData());
+
+        const Tensor *w = graph.tensor("W");
+        ASSERT_NE(w, nullptr);
+        EXPECT_EQ(w->data().size(), 8u);
+        EXPECT_GE(w->data().data(), file.bytes().data());
+        EXPECT_LE(w->data().data() + w->data().size(),
+                  file.bytes().data() + file.bytes().size());
+
+        const Tensor *b = graph.tensor("B");
+        ASSERT_NE(b, nullptr);
+        EXPECT_EQ(b->data().size(), sizeof(float));
+    }
+    std::remove(path.c_str());
+}
+
+// ---------------------------- External data ------------------------------------
+
+static void addExternal(onnx::TensorProto *t, const std::string &location,
+                        const std::string &offset, const std::string &length) {
+    t->set_data_location(onnx::TensorProto_DataLocation_EXTERNAL);
+    auto *entry = t->add_external_data();
+    entry->set_key("location");
+    entry->set_value(location);
+    entry = t->add_external_data();
+    entry->set_key("offset");
+    entry->set_value(offset);
+    entry = t->add_external_data();
+    entry->set_key("length");
+    entry->set_value(length);
+}
+
+TEST(ModelFile, ExternalDataIsViewedFromDataFile) {
+    const std::string dir = ::testing::TempDir();
+    const std::string dataPath = dir + "model_file_test.data";
+    {
+        std::ofstream out(dataPath, std::ios::binary);
+        out << "xxxxABCDEFGH";
+    }
+
+    onnx::ModelProto model = makeModel();
+    onnx::TensorProto *w = model.mutable_graph()->mutable_initializer(0);
+    w->clear_raw_data();
+    addExternal(w, "model_file_test.data", "4", "8");
+
+    const std::string path = dir + "model_file_ext.onnx";
+    {
+        std::ofstream out(path, std::ios::binary);
+        ASSERT_TRUE(model.SerializeToOstream(&out));
+    }
+
+    {
+        ModelFile file(path);
+        Graph graph(file.model().graph(), file.rawData());
+        const Tensor *tensor = graph.tensor("W");
+        ASSERT_NE(tensor, nullptr);
+        EXPECT_EQ(tensor->data(), "ABCDEFGH");
+
+        ASSERT_EQ(file.externalFiles().size(), 1u);
+        EXPECT_EQ(file.externalFiles().at("model_file_test.data").bytes(),
+                  "xxxxABCDEFGH");
+    }
+    std::remove(path.c_str());
+    std::remove(dataPath.c_str());
+}
+
+TEST(ModelFile, ExternalDataOutsideModelDirectoryThrows) {
+    onnx::ModelProto model = makeModel();
+    onnx::TensorProto *w = model.mutable_graph()->mutable_initializer(0);
+    w->clear_raw_data();
+    addExternal(w, "../weights.data", "0", "8");
+
+    const std::string path = ::testing::TempDir() + "model_file_escape.onnx";
+    {
+        std::ofstream out(path, std::ios::binary);
+        ASSERT_TRUE(model.SerializeToOstream(&out));
+    }
+    EXPECT_THROW(ModelFile{path}, std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ModelFile, UnloadedExternalDataThrows) {
+    onnx::ModelProto model = makeModel();
+    addExternal(model.mutable_graph()->mutable_initializer(0), "w.data", "0",
+                "8");
+    model.mutable_graph()->mutable_initializer(0)->clear_raw_data();
+    EXPECT_THROW(Graph{model.graph()}, std::runtime_error);
+}
+
+TEST(ModelFile, MissingFileThrows) {
+    EXPECT_THROW(ModelFile("/nonexistent/model.onnx"), std::runtime_error);
+}
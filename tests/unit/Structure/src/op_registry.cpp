@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Graph.h"
+#include "OpRegistry.h"
+#include "OnnxBuilders.h"
+
+using namespace tensor_compiler;
+using namespace tensor_compiler::test;
+
+TEST(OpRegistry, InternsOpcodesToDenseIds) {
+    OpRegistry &registry = OpRegistry::instance();
+    const OpId relu = registry.intern("Relu");
+
+    EXPECT_EQ(registry.intern("Relu"), relu);
+    EXPECT_EQ(registry.name(relu), "Relu");
+    EXPECT_LT(relu, registry.size());
+    EXPECT_FALSE(registry.find("TestNeverInterned").has_value());
+
+    const OpId custom = registry.intern("TestInterned");
+    EXPECT_EQ(custom, registry.size() - 1);
+    EXPECT_EQ(registry.find("TestInterned"), custom);
+    EXPECT_THROW(registry.name(static_cast<OpId>(registry.size())),
+                 std::out_of_range);
+}
+
+TEST(OpRegistry, NodesCarryTheirOpId) {
+    Node node("n", "Conv");
+    EXPECT_EQ(node.opId(), OpRegistry::instance().intern("Conv"));
+}
+
+TEST(OpRegistry, BuiltinOpsHaveCostAndFusionHooks) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "a", {4, 8});
+    addValueInfo(g.mutable_input(), "b", {8, 16});
+    auto *n = g.add_node();
+    n->set_op_type("MatMul");
+    n->add_input("a");
+    n->add_input("b");
+    n->add_output("y");
+    addValueInfo(g.mutable_output(), "y", {4, 16});
+
+    Graph graph{g};
+    OpRegistry &registry = OpRegistry::instance();
+    const Node &matmul = graph.nodes()[0];
+    const OpInfo &info = registry.info(matmul.opId());
+    ASSERT_TRUE(info.cost);
+    EXPECT_EQ(info.cost(graph, matmul), 2u * 8u * 4u * 16u);
+    EXPECT_FALSE(info.fusible);
+
+    EXPECT_TRUE(registry.info(registry.intern("Add")).fusible);
+    EXPECT_FALSE(registry.info(registry.intern("TestNoHooks")).cost);
+}
+
+TEST(OpRegistry, RegisterOpReplacesHooks) {
+    OpRegistry &registry = OpRegistry::instance();
+    const OpId id = registry.registerOp(
+        "TestCustom",
+        {nullptr, [](const Graph &, const Node &) -> std::uint64_t { return 7; },
+         true});
+
+    Graph graph{onnx::GraphProto{}};
+    Node node("custom", "TestCustom");
+    EXPECT_EQ(node.opId(), id);
+    EXPECT_EQ(registry.info(id).cost(graph, node), 7u);
+    EXPECT_TRUE(registry.info(id).fusible);
+}
@@ -2,6 +2,7 @@
 #include <cstdint>
 #include <cstring>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "Tensor.h"
@@ -10,7 +11,7 @@ using namespace tensor_compiler;
 
 // ------------------------------ Helpers ----------------------------------------
 
-static std::vector<float> unpackFloatsFromRaw(const std::string& raw) {
+static std::vector<float> unpackFloatsFromRaw(std::string_view raw) {
     EXPECT_EQ(raw.size() % sizeof(float), 0u);
 
     std::vector<float> out(raw.size() / sizeof(float));
@@ -164,6 +165,27 @@ TEST(Tensor, SetDataUpdatesData) {
     EXPECT_EQ(t.data(), "");
 }
 
+TEST(Tensor, CopiesShareOwnedData) {
+    Tensor t;
+    t.setData("payload");
+    Tensor copy = t;
+    Tensor moved = std::move(t);
+
+    EXPECT_EQ(copy.data(), "payload");
+    EXPECT_EQ(moved.data(), "payload");
+    EXPECT_EQ(copy.data().data(), moved.data().data());
+}
+
+TEST(Tensor, SetDataViewDoesNotCopy) {
+    const std::string buffer = "external bytes";
+    Tensor t;
+    t.setData("owned");
+    t.setDataView(std::string_view(buffer).substr(9));
+
+    EXPECT_EQ(t.data(), "bytes");
+    EXPECT_EQ(t.data().data(), buffer.data() + 9);
+}
+
 TEST(Tensor, SetShapeUpdatesShape) {
     Tensor t;
     t.setShape({3, 7, 9});
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "Graph.h"
+#include "Transforms/FoldBatchNorm.h"
+#include "OnnxBuilders.h"
+
+using namespace tensor_compiler;
+using namespace tensor_compiler::test;
+
+namespace {
+
+// x[1,1,2,2] -> Conv(W[2,1,1,1], B) -> c -> BatchNormalization -> y
+onnx::GraphProto makeConvBn(bool convOutputIsGraphOutput = false) {
+    onnx::GraphProto g;
+    addInitializer(g, "W", {2, 1, 1, 1}, {2.0f, 3.0f});
+    addInitializer(g, "B", {2}, {1.0f, -1.0f});
+    addInitializer(g, "scale", {2}, {1.0f, 2.0f});
+    addInitializer(g, "beta", {2}, {0.5f, 0.0f});
+    addInitializer(g, "mean", {2}, {1.0f, 2.0f});
+    addInitializer(g, "var", {2}, {4.0f, 1.0f});
+    addValueInfo(g.mutable_input(), "x", {1, 1, 2, 2});
+
+    addNode(g, "Conv", {"x", "W", "B"}, {"c"});
+    auto *bn = addNode(g, "BatchNormalization",
+                       {"c", "scale", "beta", "mean", "var"}, {"y"});
+    auto *eps = bn->add_attribute();
+    eps->set_name("epsilon");
+    eps->set_type(onnx::AttributeProto_AttributeType_FLOAT);
+    eps->set_f(0.0f);
+
+    addValueInfo(g.mutable_output(), "y", {1, 2, 2, 2});
+    if (convOutputIsGraphOutput) {
+        addValueInfo(g.mutable_output(), "c", {1, 2, 2, 2});
+    }
+    return g;
+}
+
+} // namespace
+
+TEST(FoldBatchNorm, FoldsIntoConvWeightsAndBias) {
+    Graph graph{makeConvBn()};
+
+    EXPECT_EQ(foldConvBatchNorm(graph), 1u);
+
+    ASSERT_EQ(graph.nodes().size(), 1u);
+    const Node &conv = graph.nodes()[0];
+    EXPECT_EQ(conv.opcode(), "Conv");
+    ASSERT_EQ(conv.inputs().size(), 3u);
+    EXPECT_EQ(conv.inputs()[0], "x");
+    ASSERT_EQ(conv.outputs().size(), 1u);
+    EXPECT_EQ(conv.outputs()[0], "y");
+
+    const Tensor *w = graph.tensor(conv.inputs()[1]);
+    const Tensor *b = graph.tensor(conv.inputs()[2]);
+    ASSERT_NE(w, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_TRUE(w->isConstant());
+    EXPECT_EQ(w->shape(), (std::vector<int64_t>{2, 1, 1, 1}));
+    EXPECT_EQ(b->shape(), (std::vector<int64_t>{2}));
+
+    // s = scale / sqrt(var) = {0.5, 2}
+    auto wv = floats(*w);
+    auto bv = floats(*b);
+    ASSERT_EQ(wv.size(), 2u);
+    ASSERT_EQ(bv.size(), 2u);
+    EXPECT_FLOAT_EQ(wv[0], 1.0f);
+    EXPECT_FLOAT_EQ(wv[1], 6.0f);
+    EXPECT_FLOAT_EQ(bv[0], 0.5f);  // (1 - 1) * 0.5 + 0.5
+    EXPECT_FLOAT_EQ(bv[1], -6.0f); // (-1 - 2) * 2 + 0
+}
+
+TEST(FoldBatchNorm, RemovesReplacedConstantsAndIntermediate) {
+    Graph graph{makeConvBn()};
+    foldConvBatchNorm(graph);
+
+    for (const char *name : {"W", "B", "scale", "beta", "mean", "var", "c"}) {
+        EXPECT_EQ(graph.tensor(name), nullptr) << name;
+    }
+    EXPECT_NE(graph.tensor("x"), nullptr);
+    EXPECT_NE(graph.tensor("y"), nullptr);
+}
+
+TEST(FoldBatchNorm, KeepsBatchNormWhenConvOutputIsObserved) {
+    Graph graph{makeConvBn(/*convOutputIsGraphOutput=*/true)};
+
+    EXPECT_EQ(foldConvBatchNorm(graph), 0u);
+    ASSERT_EQ(graph.nodes().size(), 2u);
+    EXPECT_EQ(graph.nodes()[1].opcode(), "BatchNormalization");
+    EXPECT_NE(graph.tensor("W"), nullptr);
+}
+
+TEST(FoldBatchNorm, KeepsBatchNormWithNonConstantParameters) {
+    onnx::GraphProto g = makeConvBn();
+    // Turn "mean" into a runtime input.
+    auto *inits = g.mutable_initializer();
+    for (int i = 0; i < inits->size(); ++i) {
+        if (inits->Get(i).name() == "mean") {
+            inits->DeleteSubrange(i, 1);
+            break;
+        }
+    }
+    addValueInfo(g.mutable_input(), "mean", {2});
+    Graph graph{g};
+
+    EXPECT_EQ(foldConvBatchNorm(graph), 0u);
+    EXPECT_EQ(graph.nodes().size(), 2u);
+}
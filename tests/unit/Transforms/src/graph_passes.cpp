@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Graph.h"
+#include "Transforms/PassManager.h"
+#include "Transforms/ShapeInference.h"
+#include "OnnxBuilders.h"
+
+using namespace tensor_compiler;
+using namespace tensor_compiler::test;
+
+namespace {
+
+std::vector<std::string> opcodes(const Graph &graph) {
+    std::vector<std::string> ops;
+    for (const Node &node : graph.nodes()) {
+        ops.push_back(node.opcode());
+    }
+    return ops;
+}
+
+bool runSingle(Graph &graph, std::unique_ptr<GraphPass> pass) {
+    PassManager pm;
+    pm.addPass(std::move(pass));
+    return pm.run(graph);
+}
+
+} // namespace
+
+TEST(GraphPasses, DeadCodeEliminationDropsUnusedBranches) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {2});
+    addInitializer(g, "c", {2}, {1.0f, 2.0f});
+    addNode(g, "Relu", {"x"}, {"y"});
+    addNode(g, "Add", {"x", "c"}, {"dead"});
+    addNode(g, "Relu", {"dead"}, {"dead2"});
+    addValueInfo(g.mutable_output(), "y", {2});
+
+    Graph graph{g};
+    EXPECT_TRUE(runSingle(graph, createDeadCodeEliminationPass()));
+    EXPECT_EQ(opcodes(graph), (std::vector<std::string>{"Relu"}));
+    EXPECT_EQ(graph.tensor("dead"), nullptr);
+    EXPECT_EQ(graph.tensor("c"), nullptr);
+    EXPECT_NE(graph.tensor("x"), nullptr);
+}
+
+TEST(GraphPasses, IdentityEliminationForwardsInput) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {2});
+    addNode(g, "Identity", {"x"}, {"a"});
+    addNode(g, "Relu", {"a"}, {"b"});
+    addNode(g, "Identity", {"b"}, {"y"});
+    addValueInfo(g.mutable_output(), "y", {2});
+
+    Graph graph{g};
+    EXPECT_TRUE(runSingle(graph, createIdentityEliminationPass()));
+    // The Identity producing the graph output stays.
+    EXPECT_EQ(opcodes(graph), (std::vector<std::string>{"Relu", "Identity"}));
+    EXPECT_EQ(graph.nodes()[0].inputs()[0], "x");
+    EXPECT_EQ(graph.tensor("a"), nullptr);
+}
+
+TEST(GraphPasses, ConstantFoldingEvaluatesBroadcastArithmetic) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {2, 2});
+    addInitializer(g, "a", {2, 2}, {1.0f, -2.0f, 3.0f, -4.0f});
+    addInitializer(g, "b", {2}, {10.0f, 20.0f});
+    addNode(g, "Add", {"a", "b"}, {"s"});
+    addNode(g, "Relu", {"s"}, {"r"});
+    addNode(g, "Mul", {"x", "r"}, {"y"});
+    addValueInfo(g.mutable_output(), "y", {2, 2});
+
+    Graph graph{g};
+    inferShapes(graph);
+    EXPECT_TRUE(runSingle(graph, createConstantFoldingPass()));
+    EXPECT_EQ(opcodes(graph), (std::vector<std::string>{"Mul"}));
+
+    const Tensor *r = graph.tensor("r");
+    ASSERT_NE(r, nullptr);
+    EXPECT_TRUE(r->isConstant());
+    EXPECT_EQ(r->shape(), (std::vector<int64_t>{2, 2}));
+    EXPECT_EQ(floats(*r), (std::vector<float>{11.0f, 18.0f, 13.0f, 16.0f}));
+    EXPECT_EQ(graph.tensor("a"), nullptr);
+    EXPECT_EQ(graph.tensor("s"), nullptr);
+}
+
+TEST(GraphPasses, ConstantFoldingKeepsGraphOutputs) {
+    onnx::GraphProto g;
+    addInitializer(g, "a", {2}, {1.0f, 2.0f});
+    addNode(g, "Relu", {"a"}, {"y"});
+    addValueInfo(g.mutable_output(), "y", {2});
+
+    Graph graph{g};
+    inferShapes(graph);
+    EXPECT_FALSE(runSingle(graph, createConstantFoldingPass()));
+    EXPECT_EQ(opcodes(graph), (std::vector<std::string>{"Relu"}));
+}
+
+TEST(GraphPasses, ConstantFoldingResolvesShapeArithmetic) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {2, 3, 4});
+    addInt64Initializer(g, "zero", {}, {0});
+    addInt64Initializer(g, "axes", {1}, {0});
+    addInt64Initializer(g, "rest", {1}, {-1});
+    addNode(g, "Shape", {"x"}, {"dims"});
+    addNode(g, "Gather", {"dims", "zero"}, {"batch"});
+    addNode(g, "Unsqueeze", {"batch", "axes"}, {"batch1"});
+    auto *concat = addNode(g, "Concat", {"batch1", "rest"}, {"shape"});
+    auto *axis = concat->add_attribute();
+    axis->set_name("axis");
+    axis->set_type(onnx::AttributeProto_AttributeType_INT);
+    axis->set_i(0);
+    addNode(g, "Reshape", {"x", "shape"}, {"y"});
+    addValueInfo(g.mutable_output(), "y", {});
+
+    Graph graph{g};
+    inferShapes(graph);
+    EXPECT_TRUE(runSingle(graph, createConstantFoldingPass()));
+    EXPECT_EQ(opcodes(graph), (std::vector<std::string>{"Reshape"}));
+
+    const Tensor *shape = graph.tensor("shape");
+    ASSERT_NE(shape, nullptr);
+    EXPECT_TRUE(shape->isConstant());
+    EXPECT_EQ(int64s(*shape), (std::vector<int64_t>{2, -1}));
+    EXPECT_EQ(graph.tensor("y")->shape(), (std::vector<int64_t>{2, 12}));
+    EXPECT_EQ(graph.tensor("dims"), nullptr);
+}
+
+TEST(GraphPasses, ConstantFoldingTransposesWeights) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {2, 3});
+    addInitializer(g, "w", {3, 2}, {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f});
+    addNode(g, "Transpose", {"w"}, {"wt"});
+    addNode(g, "Mul", {"x", "wt"}, {"y"});
+    addValueInfo(g.mutable_output(), "y", {2, 3});
+
+    Graph graph{g};
+    inferShapes(graph);
+    EXPECT_TRUE(runSingle(graph, createConstantFoldingPass()));
+    EXPECT_EQ(opcodes(graph), (std::vector<std::string>{"Mul"}));
+
+    const Tensor *wt = graph.tensor("wt");
+    ASSERT_NE(wt, nullptr);
+    EXPECT_EQ(wt->shape(), (std::vector<int64_t>{2, 3}));
+    EXPECT_EQ(floats(*wt),
+              (std::vector<float>{1.0f, 3.0f, 5.0f, 2.0f, 4.0f, 6.0f}));
+}
+
+TEST(GraphPasses, CSEMergesEqualNodes) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {2});
+    addNode(g, "Relu", {"x"}, {"a"});
+    addNode(g, "Relu", {"x"}, {"b"});
+    addNode(g, "Mul", {"a", "a"}, {"c"});
+    addNode(g, "Mul", {"b", "b"}, {"d"});
+    addNode(g, "Add", {"c", "d"}, {"y"});
+    addValueInfo(g.mutable_output(), "y", {2});
+
+    Graph graph{g};
+    EXPECT_TRUE(runSingle(graph, createCSEPass()));
+    EXPECT_EQ(opcodes(graph), (std::vector<std::string>{"Relu", "Mul", "Add"}));
+    EXPECT_EQ(graph.nodes()[2].inputs(), (std::vector<std::string>{"c", "c"}));
+    EXPECT_EQ(graph.consumers("a"), (std::vector<std::size_t>{1}));
+}
+
+TEST(GraphPasses, CSERespectsAttributes) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {2, 2});
+    auto *first = addNode(g, "Softmax", {"x"}, {"a"});
+    auto *attr = first->add_attribute();
+    attr->set_name("axis");
+    attr->set_type(onnx::AttributeProto_AttributeType_INT);
+    attr->set_i(0);
+    addNode(g, "Softmax", {"x"}, {"b"});
+    addNode(g, "Add", {"a", "b"}, {"y"});
+    addValueInfo(g.mutable_output(), "y", {2, 2});
+
+    Graph graph{g};
+    EXPECT_FALSE(runSingle(graph, createCSEPass()));
+    EXPECT_EQ(graph.nodes().size(), 3u);
+}
+
+TEST(GraphPasses, PassManagerHonoursDisabledPasses) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {2});
+    addNode(g, "Identity", {"x"}, {"a"});
+    addNode(g, "Relu", {"a"}, {"y"});
+    addValueInfo(g.mutable_output(), "y", {2});
+
+    Graph graph{g};
+    PassManager pm;
+    addDefaultGraphPasses(pm);
+    pm.disable("identity");
+    pm.run(graph);
+    EXPECT_EQ(opcodes(graph), (std::vector<std::string>{"Identity", "Relu"}));
+
+    EXPECT_THROW(pm.disable("no-such-pass"), std::runtime_error);
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Graph.h"
+#include "Transforms/Schedule.h"
+#include "Transforms/ShapeInference.h"
+#include "OnnxBuilders.h"
+
+using namespace tensor_compiler;
+using namespace tensor_compiler::test;
+
+namespace {
+
+void addReduceMean(onnx::GraphProto &graph, const std::string &input,
+                   const std::string &output) {
+    auto *attr = addNode(graph, "ReduceMean", {input}, {output})->add_attribute();
+    attr->set_name("axes");
+    attr->set_type(onnx::AttributeProto_AttributeType_INTS);
+    attr->add_ints(1);
+}
+
+std::vector<std::string> order(const Graph &graph) {
+    std::vector<std::string> names;
+    for (const Node &node : graph.nodes()) {
+        names.push_back(node.outputs()[0]);
+    }
+    return names;
+}
+
+// Two branches x -> Relu (4000 bytes) -> ReduceMean (4 bytes), joined by Add.
+// File order runs both Relus first, so both big tensors are live at once.
+onnx::GraphProto makeTwoBranches() {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {1, 1000});
+    addNode(g, "Relu", {"x"}, {"p"});
+    addNode(g, "Relu", {"x"}, {"r"});
+    addReduceMean(g, "p", "q");
+    addReduceMean(g, "r", "s");
+    addNode(g, "Add", {"q", "s"}, {"y"});
+    addValueInfo(g.mutable_output(), "y", {1, 1});
+    return g;
+}
+
+} // namespace
+
+TEST(Schedule, SortsNodesTopologically) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {4});
+    addNode(g, "Relu", {"b"}, {"y"});
+    addNode(g, "Relu", {"a"}, {"b"});
+    addNode(g, "Relu", {"x"}, {"a"});
+    addNode(g, "Relu", {"x"}, {"c"});
+    addValueInfo(g.mutable_output(), "y", {4});
+
+    Graph graph{g};
+    sortTopologically(graph);
+    EXPECT_EQ(order(graph), (std::vector<std::string>{"a", "b", "y", "c"}));
+}
+
+TEST(Schedule, KeepsValidFileOrder) {
+    Graph graph{makeTwoBranches()};
+    sortTopologically(graph);
+    EXPECT_EQ(order(graph),
+              (std::vector<std::string>{"p", "r", "q", "s", "y"}));
+}
+
+TEST(Schedule, RejectsCycles) {
+    onnx::GraphProto g;
+    addNode(g, "Relu", {"b"}, {"a"});
+    addNode(g, "Relu", {"a"}, {"b"});
+
+    Graph graph{g};
+    EXPECT_THROW(sortTopologically(graph), std::runtime_error);
+}
+
+TEST(Schedule, FinishesBranchBeforeStartingNext) {
+    Graph graph{makeTwoBranches()};
+    inferShapes(graph);
+    EXPECT_EQ(peakActivationBytes(graph), 8004u);
+
+    EXPECT_EQ(scheduleForMemory(graph), 4008u);
+    EXPECT_EQ(order(graph),
+              (std::vector<std::string>{"p", "q", "r", "s", "y"}));
+    EXPECT_EQ(peakActivationBytes(graph), 4008u);
+}
+
+TEST(Schedule, KeepsFileOrderWhenGreedyOrderPeaksHigher) {
+    // Greedy runs the small ReduceMean of x first, so t stays live across
+    // the 4000-byte Relu output; the file order frees s before t exists.
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {1, 1000});
+    addNode(g, "Relu", {"x"}, {"s"});
+    addReduceMean(g, "s", "u");
+    addReduceMean(g, "x", "t");
+    addNode(g, "Add", {"u", "t"}, {"y"});
+    addValueInfo(g.mutable_output(), "y", {1, 1});
+
+    Graph graph{g};
+    inferShapes(graph);
+    EXPECT_EQ(peakActivationBytes(graph), 4004u);
+
+    EXPECT_EQ(scheduleForMemory(graph), 4004u);
+    EXPECT_EQ(order(graph), (std::vector<std::string>{"s", "u", "t", "y"}));
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Graph.h"
+#include "OpRegistry.h"
+#include "Transforms/ShapeInference.h"
+#include "OnnxBuilders.h"
+
+using namespace tensor_compiler;
+using namespace tensor_compiler::test;
+
+namespace {
+
+// x[batch,3,8,8] -> Conv 3x3 pad 1 -> Relu -> MaxPool 2x2 -> Reshape [0,-1]
+// -> MatMul [64,10] -> Add -> Softmax -> ArgMax(axis=1, keepdims=0)
+onnx::GraphProto makeClassifier(int64_t batch) {
+    onnx::GraphProto g;
+    addInitializer(g, "W", {4, 3, 3, 3});
+    addInitializer(g, "M", {64, 10});
+    addInitializer(g, "b", {10});
+    addInt64Initializer(g, "shape", {2}, {0, -1});
+    addValueInfo(g.mutable_input(), "x", {batch, 3, 8, 8});
+
+    setInts(addNode(g, "Conv", {"x", "W"}, {"c"}), "pads", {1, 1, 1, 1});
+    addNode(g, "Relu", {"c"}, {"r"});
+    auto *pool = addNode(g, "MaxPool", {"r"}, {"p"});
+    setInts(pool, "kernel_shape", {2, 2});
+    setInts(pool, "strides", {2, 2});
+    addNode(g, "Reshape", {"p", "shape"}, {"f"});
+    addNode(g, "MatMul", {"f", "M"}, {"m"});
+    addNode(g, "Add", {"m", "b"}, {"logits"});
+    addNode(g, "Softmax", {"logits"}, {"probs"});
+    auto *argmax = addNode(g, "ArgMax", {"probs"}, {"y"});
+    setInt(argmax, "axis", 1);
+    setInt(argmax, "keepdims", 0);
+
+    addValueInfo(g.mutable_output(), "y", {-1},
+                 onnx::TensorProto_DataType_INT64);
+    return g;
+}
+
+std::vector<int64_t> shapeOf(const Graph &graph, const std::string &name) {
+    const Tensor *tensor = graph.tensor(name);
+    EXPECT_NE(tensor, nullptr);
+    return tensor ? tensor->shape() : std::vector<int64_t>{};
+}
+
+} // namespace
+
+TEST(ShapeInference, InfersStaticShapesThroughClassifier) {
+    Graph graph{makeClassifier(2)};
+    EXPECT_EQ(inferShapes(graph), 8u);
+
+    EXPECT_EQ(shapeOf(graph, "c"), (std::vector<int64_t>{2, 4, 8, 8}));
+    EXPECT_EQ(shapeOf(graph, "r"), (std::vector<int64_t>{2, 4, 8, 8}));
+    EXPECT_EQ(shapeOf(graph, "p"), (std::vector<int64_t>{2, 4, 4, 4}));
+    EXPECT_EQ(shapeOf(graph, "f"), (std::vector<int64_t>{2, 64}));
+    EXPECT_EQ(shapeOf(graph, "m"), (std::vector<int64_t>{2, 10}));
+    EXPECT_EQ(shapeOf(graph, "logits"), (std::vector<int64_t>{2, 10}));
+    EXPECT_EQ(shapeOf(graph, "probs"), (std::vector<int64_t>{2, 10}));
+    EXPECT_EQ(shapeOf(graph, "y"), (std::vector<int64_t>{2}));
+
+    EXPECT_EQ(graph.tensor("f")->type(), onnx::TensorProto_DataType_FLOAT);
+    EXPECT_EQ(graph.tensor("y")->type(), onnx::TensorProto_DataType_INT64);
+}
+
+TEST(ShapeInference, KeepsDynamicBatchDimension) {
+    Graph graph{makeClassifier(-1)};
+    inferShapes(graph);
+
+    EXPECT_EQ(shapeOf(graph, "p"), (std::vector<int64_t>{kDynamicDim, 4, 4, 4}));
+    EXPECT_EQ(shapeOf(graph, "f"), (std::vector<int64_t>{kDynamicDim, 64}));
+    EXPECT_EQ(shapeOf(graph, "y"), (std::vector<int64_t>{kDynamicDim}));
+}
+
+TEST(ShapeInference, IsIdempotent) {
+    Graph graph{makeClassifier(2)};
+    inferShapes(graph);
+    EXPECT_EQ(inferShapes(graph), 0u);
+}
+
+TEST(ShapeInference, SqueezeAndReduceMeanUseConstantAxes) {
+    onnx::GraphProto g;
+    addInt64Initializer(g, "axes", {2}, {2, 3});
+    addValueInfo(g.mutable_input(), "x", {1, 8, 5, 5});
+    addNode(g, "ReduceMean", {"x"}, {"mean"});
+    setInts(&g.mutable_node()->at(0), "axes", {2, 3});
+    addNode(g, "Squeeze", {"mean", "axes"}, {"y"});
+
+    Graph graph{g};
+    inferShapes(graph);
+    EXPECT_EQ(shapeOf(graph, "mean"), (std::vector<int64_t>{1, 8, 1, 1}));
+    EXPECT_EQ(shapeOf(graph, "y"), (std::vector<int64_t>{1, 8}));
+}
+
+TEST(ShapeInference, LeavesUnknownOpsAlone) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {4});
+    addNode(g, "Cos", {"x"}, {"c"});
+    addNode(g, "Relu", {"c"}, {"y"});
+
+    Graph graph{g};
+    EXPECT_EQ(inferShapes(graph), 0u);
+    EXPECT_EQ(graph.tensor("y")->type(), onnx::TensorProto_DataType_UNDEFINED);
+}
+
+TEST(ShapeInference, RejectsIncompatibleBroadcast) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "a", {2, 3});
+    addValueInfo(g.mutable_input(), "b", {4});
+    addNode(g, "Add", {"a", "b"}, {"y"});
+
+    Graph graph{g};
+    EXPECT_THROW(inferShapes(graph), std::runtime_error);
+}
+
+TEST(ShapeInference, RejectsContradictingOutputDeclaration) {
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {2, 3});
+    addNode(g, "Relu", {"x"}, {"y"});
+    addValueInfo(g.mutable_output(), "y", {3, 2});
+
+    Graph graph{g};
+    EXPECT_THROW(inferShapes(graph), std::runtime_error);
+}
+
+TEST(ShapeInference, UsesRulesOfRegisteredOps) {
+    OpRegistry::instance().registerOp(
+        "TestConcatSelf",
+        {[](const Graph &graph, const Node &node)
+             -> std::optional<TypeAndShape> {
+             const Tensor *x = graph.tensor(node.inputs()[0]);
+             std::vector<int64_t> shape = x->shape();
+             shape[0] *= 2;
+             return TypeAndShape{x->type(), shape};
+         },
+         nullptr, false});
+
+    onnx::GraphProto g;
+    addValueInfo(g.mutable_input(), "x", {2, 3});
+    addNode(g, "TestConcatSelf", {"x"}, {"d"});
+    addNode(g, "Relu", {"d"}, {"y"});
+
+    Graph graph{g};
+    EXPECT_EQ(inferShapes(graph), 2u);
+    EXPECT_EQ(shapeOf(graph, "y"), (std::vector<int64_t>{4, 3}));
+}
@@ -0,0 +1,128 @@
+#ifndef TESTS_UNIT_COMMON_ONNXBUILDERS_H
+#define TESTS_UNIT_COMMON_ONNXBUILDERS_H
+
+#include "Tensor.h"
+#include "onnx.pb.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/// Helpers building small ONNX graphs in unit tests.
+namespace tensor_compiler::test {
+
+/// @brief Add a float initializer.
+/// @param values Contents; zeros of the size of dims if empty.
+inline void addInitializer(onnx::GraphProto &graph, const std::string &name,
+                           const std::vector<int64_t> &dims,
+                           const std::vector<float> &values = {}) {
+    auto *t = graph.add_initializer();
+    t->set_name(name);
+    t->set_data_type(onnx::TensorProto_DataType_FLOAT);
+    int64_t count = 1;
+    for (int64_t d : dims) {
+        t->add_dims(d);
+        count *= d;
+    }
+    if (values.empty()) {
+        for (int64_t i = 0; i < count; ++i) {
+            t->add_float_data(0.0f);
+        }
+    }
+    for (float v : values) {
+        t->add_float_data(v);
+    }
+}
+
+/// @brief Add an int64 initializer.
+inline void addInt64Initializer(onnx::GraphProto &graph,
+                                const std::string &name,
+                                const std::vector<int64_t> &dims,
+                                const std::vector<int64_t> &values) {
+    auto *t = graph.add_initializer();
+    t->set_name(name);
+    t->set_data_type(onnx::TensorProto_DataType_INT64);
+    for (int64_t d : dims) {
+        t->add_dims(d);
+    }
+    for (int64_t v : values) {
+        t->add_int64_data(v);
+    }
+}
+
+/// @brief Add a graph input, output or value_info entry.
+/// @param dims Shape; a dimension of -1 is declared symbolic.
+inline void
+addValueInfo(google::protobuf::RepeatedPtrField<onnx::ValueInfoProto> *list,
+             const std::string &name, const std::vector<int64_t> &dims,
+             int elemType = onnx::TensorProto_DataType_FLOAT) {
+    auto *v = list->Add();
+    v->set_name(name);
+    auto *tensorType = v->mutable_type()->mutable_tensor_type();
+    tensorType->set_elem_type(elemType);
+    for (int64_t d : dims) {
+        auto *dim = tensorType->mutable_shape()->add_dim();
+        if (d < 0) {
+            dim->set_dim_param("N");
+        } else {
+            dim->set_dim_value(d);
+        }
+    }
+}
+
+/// @brief Add a node named after its op and first output.
+inline onnx::NodeProto *addNode(onnx::GraphProto &graph, const std::string &op,
+                                const std::vector<std::string> &inputs,
+                                const std::vector<std::string> &outputs) {
+    auto *n = graph.add_node();
+    n->set_op_type(op);
+    if (!outputs.empty()) {
+        n->set_name(op + "_" + outputs[0]);
+    }
+    for (const auto &in : inputs) {
+        n->add_input(in);
+    }
+    for (const auto &out : outputs) {
+        n->add_output(out);
+    }
+    return n;
+}
+
+/// @brief Add an INT attribute to a node.
+inline void setInt(onnx::NodeProto *node, const std::string &name,
+                   int64_t value) {
+    auto *attr = node->add_attribute();
+    attr->set_name(name);
+    attr->set_type(onnx::AttributeProto_AttributeType_INT);
+    attr->set_i(value);
+}
+
+/// @brief Add an INTS attribute to a node.
+inline void setInts(onnx::NodeProto *node, const std::string &name,
+                    const std::vector<int64_t> &values) {
+    auto *attr = node->add_attribute();
+    attr->set_name(name);
+    attr->set_type(onnx::AttributeProto_AttributeType_INTS);
+    for (int64_t v : values) {
+        attr->add_ints(v);
+    }
+}
+
+/// @brief Contents of a float tensor.
+inline std::vector<float> floats(const Tensor &t) {
+    std::vector<float> out(t.data().size() / sizeof(float));
+    std::memcpy(out.data(), t.data().data(), t.data().size());
+    return out;
+}
+
+/// @brief Contents of an int64 tensor.
+inline std::vector<int64_t> int64s(const Tensor &t) {
+    std::vector<int64_t> out(t.data().size() / sizeof(int64_t));
+    std::memcpy(out.data(), t.data().data(), t.data().size());
+    return out;
+}
+
+} // namespace tensor_compiler::test
+
+#endif // TESTS_UNIT_COMMON_ONNXBUILDERS_H